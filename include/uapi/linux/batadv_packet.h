@@ -136,12 +136,45 @@ enum batadv_mcast_flags {
  * @BATADV_TT_REQUEST: TT request message
  * @BATADV_TT_RESPONSE: TT response message
  * @BATADV_TT_FULL_TABLE: contains full table to replace existing table
+ * @BATADV_TT_MULTIPART: in a request: the sender accepts a full table split
+ *  into several responses, an optional batadv_tvlv_tt_part following the VLAN
+ *  data resumes an interrupted transfer; in a full table response: only a part
+ *  of the table is carried and a batadv_tvlv_tt_part follows the VLAN data
+ * @BATADV_TT_LAST_PART: last part of a full table split into several responses
+ * @BATADV_TT_COMPRESSED: in a request: the sender accepts compressed tt
+ *  changes; in a response: the tt changes are encoded as a
+ *  batadv_tvlv_tt_compressed header followed by compressed records
  */
 enum batadv_tt_data_flags {
 	BATADV_TT_OGM_DIFF   = 1UL << 0,
 	BATADV_TT_REQUEST    = 1UL << 1,
 	BATADV_TT_RESPONSE   = 1UL << 2,
 	BATADV_TT_FULL_TABLE = 1UL << 4,
+	BATADV_TT_MULTIPART  = 1UL << 5,
+	BATADV_TT_LAST_PART  = 1UL << 6,
+	BATADV_TT_COMPRESSED = 1UL << 7,
+};
+
+/* number of leading address bytes a compressed tt record shares with the
+ * previous record
+ */
+#define BATADV_TT_COMPRESS_PREFIX_MASK 0x07
+
+/**
+ * enum batadv_tt_compress_flags - control flags of a compressed tt record
+ * @BATADV_TT_COMPRESS_SAME_FLAGS: record has the tt flags of the previous one,
+ *  otherwise a flags byte follows the control byte
+ * @BATADV_TT_COMPRESS_SAME_VID: record has the VLAN of the previous one,
+ *  otherwise the big endian vid follows the flags
+ *
+ * Each record starts with a control byte holding these flags and the shared
+ * prefix length (see BATADV_TT_COMPRESS_PREFIX_MASK), optionally followed by
+ * the flags and vid, and ends with the address bytes not shared with the
+ * previous record. Records are sorted by vid and address.
+ */
+enum batadv_tt_compress_flags {
+	BATADV_TT_COMPRESS_SAME_FLAGS = 1UL << 3,
+	BATADV_TT_COMPRESS_SAME_VID   = 1UL << 4,
 };
 
 /**
@@ -266,6 +299,28 @@ struct batadv_elp_packet {
 
 #define BATADV_ELP_HLEN sizeof(struct batadv_elp_packet)
 
+/**
+ * enum batadv_elp_probe_flags - flags used in unicast ELP probes
+ * @BATADV_ELP_PROBE_EST_REQUEST: the sender has no throughput information
+ *  towards the receiver and asks it to send probe trains in return
+ */
+enum batadv_elp_probe_flags {
+	BATADV_ELP_PROBE_EST_REQUEST = 1UL << 0,
+};
+
+/**
+ * struct batadv_elp_probe - trailer of a unicast ELP probe
+ * @flags: probe flags (see batadv_elp_probe_flags)
+ * @reserved: reserved field - useful for alignment purposes only
+ *
+ * Follows the batadv_elp_packet header at the start of the zero padding of
+ * a probe. Probes too short to carry it have no flags set.
+ */
+struct batadv_elp_probe {
+	__u8 flags;
+	__u8 reserved[3];
+};
+
 /**
  * struct batadv_icmp_header - common members among all the ICMP packets
  * @packet_type: batman-adv packet type, part of the general header
@@ -331,7 +386,8 @@ struct batadv_icmp_packet {
  * @timestamp: time when the packet has been sent. This value is filled in a
  *  TP_MSG and echoed back in the next TP_ACK so that the sender can compute the
  *  RTT. Since it is read only by the host which wrote it, there is no need to
- *  store it using network order
+ *  store it using network order. TP_PROBE packets carry a timestamp in
+ *  microseconds which is echoed back in the TP_PROBE_ACK
  */
 struct batadv_icmp_tp_packet {
 	__u8   packet_type;
@@ -351,10 +407,14 @@ struct batadv_icmp_tp_packet {
  * enum batadv_icmp_tp_subtype - ICMP TP Meter packet subtypes
  * @BATADV_TP_MSG: Msg from sender to receiver
  * @BATADV_TP_ACK: acknowledgment from receiver to sender
+ * @BATADV_TP_PROBE: latency probe from sender to receiver
+ * @BATADV_TP_PROBE_ACK: latency probe echoed back by the receiver
  */
 enum batadv_icmp_tp_subtype {
 	BATADV_TP_MSG	= 0,
 	BATADV_TP_ACK,
+	BATADV_TP_PROBE,
+	BATADV_TP_PROBE_ACK,
 };
 
 #define BATADV_RR_LEN 16
@@ -595,6 +655,25 @@ struct batadv_tvlv_tt_vlan_data {
 	__u16  reserved;
 };
 
+/**
+ * struct batadv_tvlv_tt_part - position of a full table part
+ * @offset: number of tt entries carried by the previous parts of the same
+ *  full table. In a request: number of tt entries already received
+ */
+struct batadv_tvlv_tt_part {
+	__be32 offset;
+};
+
+/**
+ * struct batadv_tvlv_tt_compressed - header of compressed tt changes
+ * @num_entries: number of encoded tt changes
+ * @reserved: reserved field - useful for alignment purposes only
+ */
+struct batadv_tvlv_tt_compressed {
+	__be16 num_entries;
+	__u16  reserved;
+};
+
 /**
  * struct batadv_tvlv_tt_change - translation table diff data
  * @flags: status indicators concerning the non-mesh client (see
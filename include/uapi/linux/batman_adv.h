@@ -344,6 +344,115 @@ enum batadv_nl_attrs {
 	 */
 	BATADV_ATTR_MCAST_FLAGS_PRIV,
 
+	/**
+	 * @BATADV_ATTR_NC_BUFFER_BYTES: Bytes held by the network coding
+	 *  decoding buffer
+	 */
+	BATADV_ATTR_NC_BUFFER_BYTES,
+
+	/**
+	 * @BATADV_ATTR_NC_BUFFER_EVICT: Packets evicted from the network coding
+	 *  decoding buffer to stay within its limits
+	 */
+	BATADV_ATTR_NC_BUFFER_EVICT,
+
+	/**
+	 * @BATADV_ATTR_NC_DECODE: Coded packets which could be decoded
+	 */
+	BATADV_ATTR_NC_DECODE,
+
+	/**
+	 * @BATADV_ATTR_NC_DECODE_FAILED: Coded packets which could not be
+	 *  decoded
+	 */
+	BATADV_ATTR_NC_DECODE_FAILED,
+
+	/**
+	 * @BATADV_ATTR_THROUGHPUT_EST: estimated throughput towards a neighbor
+	 *  without driver provided throughput information (in kbit/s)
+	 */
+	BATADV_ATTR_THROUGHPUT_EST,
+
+	/**
+	 * @BATADV_ATTR_THROUGHPUT_EST_SAMPLES: number of measurements the
+	 *  estimated throughput is based on
+	 */
+	BATADV_ATTR_THROUGHPUT_EST_SAMPLES,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_STREAMS: number of parallel streams of a
+	 *  tp_meter session
+	 */
+	BATADV_ATTR_TPMETER_STREAMS,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_STREAM: index (starting at 1) of the stream a
+	 *  tp_meter result belongs to. Missing for the session result
+	 */
+	BATADV_ATTR_TPMETER_STREAM,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_PROBE_INTERVAL: interval between two latency
+	 *  probes of a tp_meter session (in milliseconds). Enables the latency
+	 *  measurement. A session started with 0 @BATADV_ATTR_TPMETER_STREAMS
+	 *  only measures the latency
+	 */
+	BATADV_ATTR_TPMETER_PROBE_INTERVAL,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_PROBES_SENT: number of latency probes sent
+	 *  during the tp_meter session
+	 */
+	BATADV_ATTR_TPMETER_PROBES_SENT,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_PROBES_LOST: number of latency probes which were
+	 *  not echoed back by the receiver
+	 */
+	BATADV_ATTR_TPMETER_PROBES_LOST,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_RTT_MIN: smallest RTT of the latency probes (in
+	 *  microseconds)
+	 */
+	BATADV_ATTR_TPMETER_RTT_MIN,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_RTT_AVG: average RTT of the latency probes (in
+	 *  microseconds)
+	 */
+	BATADV_ATTR_TPMETER_RTT_AVG,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_RTT_P50: median RTT of the latency probes (in
+	 *  microseconds)
+	 */
+	BATADV_ATTR_TPMETER_RTT_P50,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_RTT_P99: 99th percentile of the RTT of the
+	 *  latency probes (in microseconds)
+	 */
+	BATADV_ATTR_TPMETER_RTT_P99,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_RTT_MAX: largest RTT of the latency probes (in
+	 *  microseconds)
+	 */
+	BATADV_ATTR_TPMETER_RTT_MAX,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_JITTER: variation of the RTT of the latency
+	 *  probes (in microseconds)
+	 */
+	BATADV_ATTR_TPMETER_JITTER,
+
+	/**
+	 * @BATADV_ATTR_TPMETER_CC: congestion control algorithm used by the
+	 *  throughput streams of a tp_meter session (see batadv_tp_meter_cc)
+	 */
+	BATADV_ATTR_TPMETER_CC,
+
 	/* add attributes above here, update the policy in netlink.c */
 
 	/**
@@ -505,4 +614,38 @@ enum batadv_tp_meter_reason {
 	BATADV_TP_REASON_TOO_MANY		= 133,
 };
 
+/**
+ * enum batadv_tp_meter_cc - congestion control algorithms of the tp meter
+ */
+enum batadv_tp_meter_cc {
+	/**
+	 * @BATADV_TP_CC_RENO: loss based NewReno (default)
+	 */
+	BATADV_TP_CC_RENO,
+
+	/**
+	 * @BATADV_TP_CC_CUBIC: loss based window growth following a cubic
+	 *  function of the time since the last loss
+	 */
+	BATADV_TP_CC_CUBIC,
+
+	/**
+	 * @BATADV_TP_CC_RATE: rate based, paces the packets at the estimated
+	 *  bottleneck bandwidth and ignores losses
+	 */
+	BATADV_TP_CC_RATE,
+
+	/* add new algorithms above here */
+
+	/**
+	 * @__BATADV_TP_CC_AFTER_LAST: internal use
+	 */
+	__BATADV_TP_CC_AFTER_LAST,
+
+	/**
+	 * @BATADV_TP_CC_MAX: highest congestion control algorithm number
+	 */
+	BATADV_TP_CC_MAX = __BATADV_TP_CC_AFTER_LAST - 1
+};
+
 #endif /* _UAPI_LINUX_BATMAN_ADV_H_ */
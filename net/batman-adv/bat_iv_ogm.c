@@ -35,6 +35,7 @@
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/lockdep.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/pkt_sched.h>
@@ -205,6 +206,10 @@ static int batadv_iv_ogm_iface_enable(struct batadv_hard_iface *hard_iface)
 	struct batadv_ogm_packet *batadv_ogm_packet;
 	unsigned char *ogm_buff;
 	u32 random_seqno;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(hard_iface->bat_iv.aggr_slots); i++)
+		INIT_HLIST_HEAD(&hard_iface->bat_iv.aggr_slots[i]);
 
 	/* randomize initial seqno to avoid collision */
 	get_random_bytes(&random_seqno, sizeof(random_seqno));
@@ -258,11 +263,15 @@ batadv_iv_ogm_primary_iface_set(struct batadv_hard_iface *hard_iface)
 
 /* when do we schedule our own ogm to be sent */
 static unsigned long
-batadv_iv_ogm_emit_send_time(const struct batadv_priv *bat_priv)
+batadv_iv_ogm_emit_send_time(struct batadv_hard_iface *hard_iface)
 {
+	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
 	unsigned int msecs;
 
-	msecs = atomic_read(&bat_priv->orig_interval) - BATADV_JITTER;
+	msecs = batadv_interval_backoff(bat_priv,
+					&hard_iface->bat_iv.ogm_backoff,
+					atomic_read(&bat_priv->orig_interval));
+	msecs -= BATADV_JITTER;
 	msecs += prandom_u32() % (2 * BATADV_JITTER);
 
 	return jiffies + msecs_to_jiffies(msecs);
@@ -396,11 +405,49 @@ static void batadv_iv_ogm_emit(struct batadv_forw_packet *forw_packet)
 	batadv_iv_ogm_send_to_if(forw_packet, forw_packet->if_outgoing);
 }
 
+/**
+ * batadv_iv_ogm_aggr_max_len() - get the maximum size of an OGM aggregate
+ * @if_outgoing: interface the aggregate is leaving on
+ *
+ * Return: the MTU of the outgoing interface, capped at
+ *  BATADV_MAX_AGGREGATION_BYTES which is the largest aggregate accepted by
+ *  the receiving nodes
+ */
+static unsigned int
+batadv_iv_ogm_aggr_max_len(const struct batadv_hard_iface *if_outgoing)
+{
+	return min_t(unsigned int, if_outgoing->net_dev->mtu,
+		     BATADV_MAX_AGGREGATION_BYTES);
+}
+
+/**
+ * batadv_iv_ogm_aggr_slot() - get the aggregation slot for a send time
+ * @if_outgoing: interface the aggregate is leaving on
+ * @send_time: timestamp (jiffies) when the aggregate is to be sent
+ *
+ * Each slot covers one aggregation window of BATADV_MAX_AGGREGATION_MS. An
+ * OGM can therefore only be aggregated with packets indexed in the slot of
+ * its own send time or in the one following it.
+ *
+ * Return: the list head of the slot
+ */
+static struct hlist_head *
+batadv_iv_ogm_aggr_slot(struct batadv_hard_iface *if_outgoing,
+			unsigned long send_time)
+{
+	unsigned long slot;
+
+	slot = send_time / msecs_to_jiffies(BATADV_MAX_AGGREGATION_MS);
+	slot %= ARRAY_SIZE(if_outgoing->bat_iv.aggr_slots);
+
+	return &if_outgoing->bat_iv.aggr_slots[slot];
+}
+
 /**
  * batadv_iv_ogm_can_aggregate() - find out if an OGM can be aggregated on an
  *  existing forward packet
  * @new_bat_ogm_packet: OGM packet to be aggregated
- * @bat_priv: the bat priv with all the soft interface information
+ * @primary_if: the selected primary interface of the mesh
  * @packet_len: (total) length of the OGM
  * @send_time: timestamp (jiffies) when the packet is to be sent
  * @directlink: true if this is a direct link packet
@@ -412,7 +459,7 @@ static void batadv_iv_ogm_emit(struct batadv_forw_packet *forw_packet)
  */
 static bool
 batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
-			    struct batadv_priv *bat_priv,
+			    const struct batadv_hard_iface *primary_if,
 			    int packet_len, unsigned long send_time,
 			    bool directlink,
 			    const struct batadv_hard_iface *if_incoming,
@@ -421,8 +468,6 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 {
 	struct batadv_ogm_packet *batadv_ogm_packet;
 	int aggregated_bytes = forw_packet->packet_len + packet_len;
-	struct batadv_hard_iface *primary_if = NULL;
-	bool res = false;
 	unsigned long aggregation_end_time;
 
 	batadv_ogm_packet = (struct batadv_ogm_packet *)forw_packet->skb->data;
@@ -434,14 +479,19 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 	 *
 	 * - the send time is within our MAX_AGGREGATION_MS time
 	 * - the resulting packet wont be bigger than
-	 *   MAX_AGGREGATION_BYTES
+	 *   MAX_AGGREGATION_BYTES or the MTU of the outgoing interface
+	 * - the packet still fits into the skb of the aggregate, which was
+	 *   sized by the MTU at the time the aggregate was created
 	 * otherwise aggregation is not possible
 	 */
 	if (!time_before(send_time, forw_packet->send_time) ||
 	    !time_after_eq(aggregation_end_time, forw_packet->send_time))
 		return false;
 
-	if (aggregated_bytes > BATADV_MAX_AGGREGATION_BYTES)
+	if (aggregated_bytes > batadv_iv_ogm_aggr_max_len(if_outgoing))
+		return false;
+
+	if (packet_len > skb_tailroom(forw_packet->skb))
 		return false;
 
 	/* packet is not leaving on the same interface. */
@@ -455,9 +505,6 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 	 *    a "global" packet as well as the base
 	 *    packet
 	 */
-	primary_if = batadv_primary_if_get_selected(bat_priv);
-	if (!primary_if)
-		return false;
 
 	/* packets without direct link flag and high TTL
 	 * are flooded through the net
@@ -470,10 +517,8 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 	     * interfaces leave only that interface
 	     */
 	    (!forw_packet->own ||
-	     forw_packet->if_incoming == primary_if)) {
-		res = true;
-		goto out;
-	}
+	     forw_packet->if_incoming == primary_if))
+		return true;
 
 	/* if the incoming packet is sent via this one
 	 * interface only - we still can aggregate
@@ -488,21 +533,36 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
 	     */
 	    (batadv_ogm_packet->flags & BATADV_DIRECTLINK ||
 	     (forw_packet->own &&
-	      forw_packet->if_incoming != primary_if))) {
-		res = true;
-		goto out;
-	}
+	      forw_packet->if_incoming != primary_if)))
+		return true;
 
-out:
-	if (primary_if)
-		batadv_hardif_put(primary_if);
-	return res;
+	return false;
+}
+
+/**
+ * batadv_iv_ogm_put() - append an OGM to an aggregate
+ * @skb: the aggregate to append the OGM to
+ * @packet_buff: pointer to the OGM header
+ * @tvlv_buff: pointer to the TVLV data of the OGM
+ * @packet_len: (total) length of the OGM
+ *
+ * The OGM header and its TVLV data do not have to be contiguous. This allows
+ * forwarding a modified copy of a received OGM header without copying the
+ * whole received packet first.
+ */
+static void batadv_iv_ogm_put(struct sk_buff *skb,
+			      const unsigned char *packet_buff,
+			      const unsigned char *tvlv_buff, int packet_len)
+{
+	skb_put_data(skb, packet_buff, BATADV_OGM_HLEN);
+	skb_put_data(skb, tvlv_buff, packet_len - BATADV_OGM_HLEN);
 }
 
 /**
  * batadv_iv_ogm_aggregate_new() - create a new aggregated packet and add this
  *  packet to it.
- * @packet_buff: pointer to the OGM
+ * @packet_buff: pointer to the OGM header
+ * @tvlv_buff: pointer to the TVLV data of the OGM
  * @packet_len: (total) length of the OGM
  * @send_time: timestamp (jiffies) when the packet is to be sent
  * @direct_link: whether this OGM has direct link status
@@ -511,6 +571,7 @@ batadv_iv_ogm_can_aggregate(const struct batadv_ogm_packet *new_bat_ogm_packet,
  * @own_packet: true if it is a self-generated ogm
  */
 static void batadv_iv_ogm_aggregate_new(const unsigned char *packet_buff,
+					const unsigned char *tvlv_buff,
 					int packet_len, unsigned long send_time,
 					bool direct_link,
 					struct batadv_hard_iface *if_incoming,
@@ -520,13 +581,15 @@ static void batadv_iv_ogm_aggregate_new(const unsigned char *packet_buff,
 	struct batadv_priv *bat_priv = netdev_priv(if_incoming->soft_iface);
 	struct batadv_forw_packet *forw_packet_aggr;
 	struct sk_buff *skb;
-	unsigned char *skb_buff;
 	unsigned int skb_size;
+	unsigned int max_len;
+	struct hlist_head *aggr_head;
 	atomic_t *queue_left = own_packet ? NULL : &bat_priv->batman_queue_left;
 
-	if (atomic_read(&bat_priv->aggregated_ogms) &&
-	    packet_len < BATADV_MAX_AGGREGATION_BYTES)
-		skb_size = BATADV_MAX_AGGREGATION_BYTES;
+	max_len = batadv_iv_ogm_aggr_max_len(if_outgoing);
+
+	if (atomic_read(&bat_priv->aggregated_ogms) && packet_len < max_len)
+		skb_size = max_len;
 	else
 		skb_size = packet_len;
 
@@ -546,9 +609,9 @@ static void batadv_iv_ogm_aggregate_new(const unsigned char *packet_buff,
 	forw_packet_aggr->skb->priority = TC_PRIO_CONTROL;
 	skb_reserve(forw_packet_aggr->skb, ETH_HLEN);
 
-	skb_buff = skb_put(forw_packet_aggr->skb, packet_len);
+	batadv_iv_ogm_put(forw_packet_aggr->skb, packet_buff, tvlv_buff,
+			  packet_len);
 	forw_packet_aggr->packet_len = packet_len;
-	memcpy(skb_buff, packet_buff, packet_len);
 
 	forw_packet_aggr->own = own_packet;
 	forw_packet_aggr->direct_link_flags = BATADV_NO_FLAGS;
@@ -561,17 +624,25 @@ static void batadv_iv_ogm_aggregate_new(const unsigned char *packet_buff,
 	INIT_DELAYED_WORK(&forw_packet_aggr->delayed_work,
 			  batadv_iv_send_outstanding_bat_ogm_packet);
 
-	batadv_forw_packet_ogmv1_queue(bat_priv, forw_packet_aggr, send_time);
+	/* own packets are indexed as well: they are not merged into other
+	 * aggregates but forwarded OGMs may still be appended to them
+	 */
+	aggr_head = batadv_iv_ogm_aggr_slot(if_outgoing, send_time);
+
+	batadv_forw_packet_ogmv1_queue(bat_priv, forw_packet_aggr, aggr_head,
+				       send_time);
 }
 
 /* aggregate a new packet into the existing ogm packet */
 static void batadv_iv_ogm_aggregate(struct batadv_forw_packet *forw_packet_aggr,
 				    const unsigned char *packet_buff,
+				    const unsigned char *tvlv_buff,
 				    int packet_len, bool direct_link)
 {
 	unsigned long new_direct_link_flag;
 
-	skb_put_data(forw_packet_aggr->skb, packet_buff, packet_len);
+	batadv_iv_ogm_put(forw_packet_aggr->skb, packet_buff, tvlv_buff,
+			  packet_len);
 	forw_packet_aggr->packet_len += packet_len;
 	forw_packet_aggr->num_packets++;
 
@@ -585,7 +656,8 @@ static void batadv_iv_ogm_aggregate(struct batadv_forw_packet *forw_packet_aggr,
 /**
  * batadv_iv_ogm_queue_add() - queue up an OGM for transmission
  * @bat_priv: the bat priv with all the soft interface information
- * @packet_buff: pointer to the OGM
+ * @packet_buff: pointer to the OGM header
+ * @tvlv_buff: pointer to the TVLV data of the OGM
  * @packet_len: (total) length of the OGM
  * @if_incoming: interface where the packet was received
  * @if_outgoing: interface for which the retransmission should be considered
@@ -594,6 +666,7 @@ static void batadv_iv_ogm_aggregate(struct batadv_forw_packet *forw_packet_aggr,
  */
 static void batadv_iv_ogm_queue_add(struct batadv_priv *bat_priv,
 				    unsigned char *packet_buff,
+				    const unsigned char *tvlv_buff,
 				    int packet_len,
 				    struct batadv_hard_iface *if_incoming,
 				    struct batadv_hard_iface *if_outgoing,
@@ -604,22 +677,38 @@ static void batadv_iv_ogm_queue_add(struct batadv_priv *bat_priv,
 	 */
 	struct batadv_forw_packet *forw_packet_aggr = NULL;
 	struct batadv_forw_packet *forw_packet_pos = NULL;
+	struct batadv_hard_iface *primary_if = NULL;
 	struct batadv_ogm_packet *batadv_ogm_packet;
+	struct hlist_head *slots[2];
 	bool direct_link;
 	unsigned long max_aggregation_jiffies;
+	unsigned int i;
 
 	batadv_ogm_packet = (struct batadv_ogm_packet *)packet_buff;
 	direct_link = !!(batadv_ogm_packet->flags & BATADV_DIRECTLINK);
 	max_aggregation_jiffies = msecs_to_jiffies(BATADV_MAX_AGGREGATION_MS);
 
+	/* own packets are not to be aggregated */
+	if (atomic_read(&bat_priv->aggregated_ogms) && !own_packet)
+		primary_if = batadv_primary_if_get_selected(bat_priv);
+
+	/* only the aggregates scheduled within the aggregation window after
+	 * send_time are candidates - they are indexed in the two slots
+	 * covering it
+	 */
+	slots[0] = batadv_iv_ogm_aggr_slot(if_outgoing, send_time);
+	slots[1] = batadv_iv_ogm_aggr_slot(if_outgoing,
+					   send_time + max_aggregation_jiffies);
+
 	/* find position for the packet in the forward queue */
 	spin_lock_bh(&bat_priv->forw_bat_list_lock);
-	/* own packets are not to be aggregated */
-	if (atomic_read(&bat_priv->aggregated_ogms) && !own_packet) {
-		hlist_for_each_entry(forw_packet_pos,
-				     &bat_priv->forw_bat_list, list) {
+	for (i = 0; primary_if && !forw_packet_aggr && i < 2; i++) {
+		if (i == 1 && slots[1] == slots[0])
+			break;
+
+		hlist_for_each_entry(forw_packet_pos, slots[i], aggr_list) {
 			if (batadv_iv_ogm_can_aggregate(batadv_ogm_packet,
-							bat_priv, packet_len,
+							primary_if, packet_len,
 							send_time, direct_link,
 							if_incoming,
 							if_outgoing,
@@ -644,20 +733,24 @@ static void batadv_iv_ogm_queue_add(struct batadv_priv *bat_priv,
 		if (!own_packet && atomic_read(&bat_priv->aggregated_ogms))
 			send_time += max_aggregation_jiffies;
 
-		batadv_iv_ogm_aggregate_new(packet_buff, packet_len,
+		batadv_iv_ogm_aggregate_new(packet_buff, tvlv_buff, packet_len,
 					    send_time, direct_link,
 					    if_incoming, if_outgoing,
 					    own_packet);
 	} else {
 		batadv_iv_ogm_aggregate(forw_packet_aggr, packet_buff,
-					packet_len, direct_link);
+					tvlv_buff, packet_len, direct_link);
 		spin_unlock_bh(&bat_priv->forw_bat_list_lock);
 	}
+
+	if (primary_if)
+		batadv_hardif_put(primary_if);
 }
 
 static void batadv_iv_ogm_forward(struct batadv_orig_node *orig_node,
 				  const struct ethhdr *ethhdr,
 				  struct batadv_ogm_packet *batadv_ogm_packet,
+				  const unsigned char *tvlv_buff,
 				  bool is_single_hop_neigh,
 				  bool is_from_best_next_hop,
 				  struct batadv_hard_iface *if_incoming,
@@ -703,7 +796,7 @@ static void batadv_iv_ogm_forward(struct batadv_orig_node *orig_node,
 		batadv_ogm_packet->flags &= ~BATADV_DIRECTLINK;
 
 	batadv_iv_ogm_queue_add(bat_priv, (unsigned char *)batadv_ogm_packet,
-				BATADV_OGM_HLEN + tvlv_len,
+				tvlv_buff, BATADV_OGM_HLEN + tvlv_len,
 				if_incoming, if_outgoing, 0,
 				batadv_iv_ogm_fwd_send_time());
 }
@@ -795,14 +888,16 @@ static void batadv_iv_ogm_schedule(struct batadv_hard_iface *hard_iface)
 
 	batadv_iv_ogm_slide_own_bcast_window(hard_iface);
 
-	send_time = batadv_iv_ogm_emit_send_time(bat_priv);
+	send_time = batadv_iv_ogm_emit_send_time(hard_iface);
 
 	if (hard_iface != primary_if) {
 		/* OGMs from secondary interfaces are only scheduled on their
 		 * respective interfaces.
 		 */
-		batadv_iv_ogm_queue_add(bat_priv, *ogm_buff, *ogm_buff_len,
-					hard_iface, hard_iface, 1, send_time);
+		batadv_iv_ogm_queue_add(bat_priv, *ogm_buff,
+					*ogm_buff + BATADV_OGM_HLEN,
+					*ogm_buff_len, hard_iface, hard_iface,
+					1, send_time);
 		goto out;
 	}
 
@@ -818,6 +913,7 @@ static void batadv_iv_ogm_schedule(struct batadv_hard_iface *hard_iface)
 			continue;
 
 		batadv_iv_ogm_queue_add(bat_priv, *ogm_buff,
+					*ogm_buff + BATADV_OGM_HLEN,
 					*ogm_buff_len, hard_iface,
 					tmp_hard_iface, 1, send_time);
 
@@ -1259,6 +1355,45 @@ batadv_iv_ogm_update_seqnos(const struct ethhdr *ethhdr,
 	return ret;
 }
 
+/**
+ * batadv_iv_ogm_nc_link_quality() - get the quality of the link between the
+ *  originator of an OGM and the neighbor it was received from
+ * @orig_node: the orig node who originally emitted the ogm packet
+ * @ogm_packet: the ogm packet
+ *
+ * The TQ value of an OGM only describes this single link if:
+ *  1) The OGM has the most recent sequence number.
+ *  2) The TTL was decremented by one and only one.
+ *  3) The OGM was received by the neighbor from orig_node directly.
+ *
+ * Return: the TQ value of the OGM or 0 if it describes more than one link.
+ */
+static u8
+batadv_iv_ogm_nc_link_quality(struct batadv_orig_node *orig_node,
+			      const struct batadv_ogm_packet *ogm_packet)
+{
+	struct batadv_orig_ifinfo *orig_ifinfo;
+	u32 last_real_seqno;
+	u8 last_ttl;
+
+	orig_ifinfo = batadv_orig_ifinfo_get(orig_node, BATADV_IF_DEFAULT);
+	if (!orig_ifinfo)
+		return 0;
+
+	last_ttl = orig_ifinfo->last_ttl;
+	last_real_seqno = orig_ifinfo->last_real_seqno;
+	batadv_orig_ifinfo_put(orig_ifinfo);
+
+	if (last_real_seqno != ntohl(ogm_packet->seqno))
+		return 0;
+	if (last_ttl != ogm_packet->ttl + 1)
+		return 0;
+	if (!batadv_compare_eth(ogm_packet->orig, ogm_packet->prev_sender))
+		return 0;
+
+	return ogm_packet->tq;
+}
+
 /**
  * batadv_iv_ogm_process_per_outif() - process a batman iv OGM for an outgoing
  *  interface
@@ -1282,25 +1417,28 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 	struct batadv_orig_ifinfo *orig_ifinfo;
 	struct batadv_neigh_node *orig_neigh_router = NULL;
 	struct batadv_neigh_ifinfo *router_ifinfo = NULL;
-	struct batadv_ogm_packet *ogm_packet;
+	struct batadv_ogm_packet *ogm_packet, ogm_hdr;
+	struct batadv_ogm_packet *skb_ogm_packet;
+	const unsigned char *tvlv_buff;
 	enum batadv_dup_status dup_status;
 	bool is_from_best_next_hop = false;
 	bool is_single_hop_neigh = false;
 	bool sameseq, similar_ttl;
-	struct sk_buff *skb_priv;
 	struct ethhdr *ethhdr;
 	u8 *prev_sender;
+	u8 nc_link_quality;
 	bool is_bidirect;
 
-	/* create a private copy of the skb, as some functions change tq value
-	 * and/or flags.
+	/* the skb is shared between all outgoing interfaces. Only create a
+	 * private copy of the OGM header, as some functions change tq value
+	 * and/or flags. The TVLV data is only read and is copied directly from
+	 * the skb when the OGM gets forwarded.
 	 */
-	skb_priv = skb_copy(skb, GFP_ATOMIC);
-	if (!skb_priv)
-		return;
-
-	ethhdr = eth_hdr(skb_priv);
-	ogm_packet = (struct batadv_ogm_packet *)(skb_priv->data + ogm_offset);
+	ethhdr = eth_hdr(skb);
+	skb_ogm_packet = (struct batadv_ogm_packet *)(skb->data + ogm_offset);
+	tvlv_buff = (const unsigned char *)(skb_ogm_packet + 1);
+	ogm_hdr = *skb_ogm_packet;
+	ogm_packet = &ogm_hdr;
 
 	dup_status = batadv_iv_ogm_update_seqnos(ethhdr, ogm_packet,
 						 if_incoming, if_outgoing);
@@ -1351,7 +1489,7 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 	}
 
 	if (if_outgoing == BATADV_IF_DEFAULT)
-		batadv_tvlv_ogm_receive(bat_priv, ogm_packet, orig_node);
+		batadv_tvlv_ogm_receive(bat_priv, skb_ogm_packet, orig_node);
 
 	/* if sender is a direct neighbor the sender mac equals
 	 * originator mac
@@ -1366,8 +1504,12 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 		goto out;
 
 	/* Update nc_nodes of the originator */
-	batadv_nc_update_nc_node(bat_priv, orig_node, orig_neigh_node,
-				 ogm_packet, is_single_hop_neigh);
+	if (batadv_nc_enabled(bat_priv)) {
+		nc_link_quality = batadv_iv_ogm_nc_link_quality(orig_node,
+								ogm_packet);
+		batadv_nc_update_nc_node(bat_priv, orig_node, orig_neigh_node,
+					 nc_link_quality, is_single_hop_neigh);
+	}
 
 	orig_neigh_router = batadv_orig_router_get(orig_neigh_node,
 						   if_outgoing);
@@ -1420,7 +1562,7 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 			goto out_neigh;
 		}
 		/* mark direct link on incoming interface */
-		batadv_iv_ogm_forward(orig_node, ethhdr, ogm_packet,
+		batadv_iv_ogm_forward(orig_node, ethhdr, ogm_packet, tvlv_buff,
 				      is_single_hop_neigh,
 				      is_from_best_next_hop, if_incoming,
 				      if_outgoing);
@@ -1445,7 +1587,7 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 
 	batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
 		   "Forwarding packet: rebroadcast originator packet\n");
-	batadv_iv_ogm_forward(orig_node, ethhdr, ogm_packet,
+	batadv_iv_ogm_forward(orig_node, ethhdr, ogm_packet, tvlv_buff,
 			      is_single_hop_neigh, is_from_best_next_hop,
 			      if_incoming, if_outgoing);
 
@@ -1463,8 +1605,6 @@ batadv_iv_ogm_process_per_outif(const struct sk_buff *skb, int ogm_offset,
 		batadv_neigh_node_put(orig_neigh_router);
 	if (hardif_neigh)
 		batadv_hardif_neigh_put(hardif_neigh);
-
-	consume_skb(skb_priv);
 }
 
 /**
@@ -2515,6 +2655,39 @@ static bool batadv_iv_gw_is_eligible(struct batadv_priv *bat_priv,
 	return ret;
 }
 
+/**
+ * batadv_iv_gw_get_lb_weight() - compute the load balancing weight of a GW
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_node: the GW to compute the weight for
+ *
+ * Return: the advertised download bandwidth of the GW scaled by the TQ of the
+ * path towards it, 0 if the GW is unreachable
+ */
+static u32 batadv_iv_gw_get_lb_weight(struct batadv_priv *bat_priv,
+				      struct batadv_gw_node *gw_node)
+{
+	struct batadv_neigh_ifinfo *router_ifinfo;
+	struct batadv_neigh_node *router;
+	u32 weight = 0;
+
+	router = batadv_orig_router_get(gw_node->orig_node, BATADV_IF_DEFAULT);
+	if (!router)
+		return 0;
+
+	router_ifinfo = batadv_neigh_ifinfo_get(router, BATADV_IF_DEFAULT);
+	if (!router_ifinfo)
+		goto out;
+
+	weight = div_u64((u64)gw_node->bandwidth_down *
+			 router_ifinfo->bat_iv.tq_avg, BATADV_TQ_MAX_VALUE);
+
+	batadv_neigh_ifinfo_put(router_ifinfo);
+out:
+	batadv_neigh_node_put(router);
+
+	return weight;
+}
+
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 /* fails if orig_node has no router */
 static int batadv_iv_gw_write_buffer_text(struct batadv_priv *bat_priv,
@@ -2714,6 +2887,7 @@ static struct batadv_algo_ops batadv_batman_iv __read_mostly = {
 		.init_sel_class = batadv_iv_init_sel_class,
 		.get_best_gw_node = batadv_iv_gw_get_best_gw_node,
 		.is_eligible = batadv_iv_gw_is_eligible,
+		.get_lb_weight = batadv_iv_gw_get_lb_weight,
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 		.print = batadv_iv_gw_print,
 #endif
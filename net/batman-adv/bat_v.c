@@ -32,6 +32,8 @@
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/types.h>
 #include <linux/workqueue.h>
@@ -53,6 +55,35 @@
 
 struct sk_buff;
 
+/**
+ * batadv_v_iface_backoff_reset() - bring backed off ELP and OGM messages
+ *  forward
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+static void batadv_v_iface_backoff_reset(struct batadv_priv *bat_priv)
+{
+	struct batadv_hard_iface *hard_iface;
+	unsigned int interval;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(hard_iface, &batadv_hardif_list, list) {
+		if (hard_iface->soft_iface != bat_priv->soft_iface)
+			continue;
+
+		/* the ELP work is cancelled once the interface is deactivated */
+		if (hard_iface->if_status != BATADV_IF_ACTIVE)
+			continue;
+
+		interval = atomic_read(&hard_iface->bat_v.elp_interval);
+		batadv_interval_backoff_reset(&hard_iface->bat_v.elp_wq,
+					      interval);
+	}
+	rcu_read_unlock();
+
+	interval = atomic_read(&bat_priv->orig_interval);
+	batadv_interval_backoff_reset(&bat_priv->bat_v.ogm_wq, interval);
+}
+
 static void batadv_v_iface_activate(struct batadv_hard_iface *hard_iface)
 {
 	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
@@ -90,6 +121,7 @@ static int batadv_v_iface_enable(struct batadv_hard_iface *hard_iface)
 
 static void batadv_v_iface_disable(struct batadv_hard_iface *hard_iface)
 {
+	batadv_v_ogm_iface_disable(hard_iface);
 	batadv_v_elp_iface_disable(hard_iface);
 }
 
@@ -125,8 +157,8 @@ static void
 batadv_v_hardif_neigh_init(struct batadv_hardif_neigh_node *hardif_neigh)
 {
 	ewma_throughput_init(&hardif_neigh->bat_v.throughput);
-	INIT_WORK(&hardif_neigh->bat_v.metric_work,
-		  batadv_v_elp_throughput_metric_update);
+	ewma_throughput_init(&hardif_neigh->bat_v.est_throughput);
+	hardif_neigh->bat_v.tx_start = jiffies;
 }
 
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
@@ -228,13 +260,18 @@ static int
 batadv_v_neigh_dump_neigh(struct sk_buff *msg, u32 portid, u32 seq,
 			  struct batadv_hardif_neigh_node *hardif_neigh)
 {
+	struct batadv_hardif_neigh_node_bat_v *bat_v = &hardif_neigh->bat_v;
 	void *hdr;
 	unsigned int last_seen_msecs;
-	u32 throughput;
+	u32 throughput, est_throughput;
+	u32 est_samples;
 
 	last_seen_msecs = jiffies_to_msecs(jiffies - hardif_neigh->last_seen);
 	throughput = ewma_throughput_read(&hardif_neigh->bat_v.throughput);
 	throughput = throughput * 100;
+	est_throughput = ewma_throughput_read(&bat_v->est_throughput);
+	est_throughput = est_throughput * 100;
+	est_samples = atomic_read(&bat_v->est_samples);
 
 	hdr = genlmsg_put(msg, portid, seq, &batadv_netlink_family, NLM_F_MULTI,
 			  BATADV_CMD_GET_NEIGHBORS);
@@ -250,6 +287,11 @@ batadv_v_neigh_dump_neigh(struct sk_buff *msg, u32 portid, u32 seq,
 	    nla_put_u32(msg, BATADV_ATTR_THROUGHPUT, throughput))
 		goto nla_put_failure;
 
+	if (est_samples &&
+	    (nla_put_u32(msg, BATADV_ATTR_THROUGHPUT_EST, est_throughput) ||
+	     nla_put_u32(msg, BATADV_ATTR_THROUGHPUT_EST_SAMPLES, est_samples)))
+		goto nla_put_failure;
+
 	genlmsg_end(msg, hdr);
 	return 0;
 
@@ -839,6 +881,25 @@ static bool batadv_v_gw_is_eligible(struct batadv_priv *bat_priv,
 	return ret;
 }
 
+/**
+ * batadv_v_gw_get_lb_weight() - compute the load balancing weight of a GW
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_node: the GW to compute the weight for
+ *
+ * Return: the GW metric (see batadv_v_gw_throughput_get()), 0 if the GW is
+ * unreachable
+ */
+static u32 batadv_v_gw_get_lb_weight(struct batadv_priv *bat_priv,
+				     struct batadv_gw_node *gw_node)
+{
+	u32 bw;
+
+	if (batadv_v_gw_throughput_get(gw_node, &bw) < 0)
+		return 0;
+
+	return bw;
+}
+
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 /* fails if orig_node has no router */
 static int batadv_v_gw_write_buffer_text(struct batadv_priv *bat_priv,
@@ -1045,6 +1106,8 @@ static struct batadv_algo_ops batadv_batman_v __read_mostly = {
 		.disable = batadv_v_iface_disable,
 		.update_mac = batadv_v_iface_update_mac,
 		.primary_set = batadv_v_primary_iface_set,
+		.link_update = batadv_v_elp_iface_link_update,
+		.backoff_reset = batadv_v_iface_backoff_reset,
 	},
 	.neigh = {
 		.hardif_init = batadv_v_hardif_neigh_init,
@@ -1067,6 +1130,7 @@ static struct batadv_algo_ops batadv_batman_v __read_mostly = {
 		.show_sel_class = batadv_v_show_sel_class,
 		.get_best_gw_node = batadv_v_gw_get_best_gw_node,
 		.is_eligible = batadv_v_gw_is_eligible,
+		.get_lb_weight = batadv_v_gw_get_lb_weight,
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 		.print = batadv_v_gw_print,
 #endif
@@ -1086,6 +1150,12 @@ void batadv_v_hardif_init(struct batadv_hard_iface *hard_iface)
 	 */
 	atomic_set(&hard_iface->bat_v.throughput_override, 0);
 	atomic_set(&hard_iface->bat_v.elp_interval, 500);
+
+	hard_iface->bat_v.aggr_len = 0;
+	skb_queue_head_init(&hard_iface->bat_v.aggr_list);
+	spin_lock_init(&hard_iface->bat_v.aggr_list_lock);
+	INIT_DELAYED_WORK(&hard_iface->bat_v.aggr_wq,
+			  batadv_v_ogm_aggr_work);
 }
 
 /**
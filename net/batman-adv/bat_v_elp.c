@@ -30,6 +30,9 @@
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/nl80211.h>
 #include <linux/random.h>
@@ -55,34 +58,93 @@
 /**
  * batadv_v_elp_start_timer() - restart timer for ELP periodic work
  * @hard_iface: the interface for which the timer has to be reset
+ * @elp_interval: the interval until the next ELP transmission in milliseconds
  */
-static void batadv_v_elp_start_timer(struct batadv_hard_iface *hard_iface)
+static void batadv_v_elp_start_timer(struct batadv_hard_iface *hard_iface,
+				     u32 elp_interval)
 {
 	unsigned int msecs;
 
-	msecs = atomic_read(&hard_iface->bat_v.elp_interval) - BATADV_JITTER;
+	msecs = elp_interval - BATADV_JITTER;
 	msecs += prandom_u32() % (2 * BATADV_JITTER);
 
 	queue_delayed_work(batadv_event_workqueue, &hard_iface->bat_v.elp_wq,
 			   msecs_to_jiffies(msecs));
 }
 
+/**
+ * batadv_v_elp_iface_link_update() - refresh the cached link throughput of an
+ *  interface
+ * @hard_iface: the interface whose link state changed
+ *
+ * Non-wifi devices may provide their link speed via ethtool. Querying it
+ * requires the rtnl lock, so it is only done when the link state changes and
+ * the result is cached for the throughput metric updates of all neighbors.
+ *
+ * Caller must hold the rtnl lock.
+ */
+void batadv_v_elp_iface_link_update(struct batadv_hard_iface *hard_iface)
+{
+	struct ethtool_link_ksettings link_settings;
+	u32 throughput = 0;
+	int ret;
+
+	ASSERT_RTNL();
+
+	if (batadv_is_wifi_hardif(hard_iface))
+		goto out;
+
+	memset(&link_settings, 0, sizeof(link_settings));
+	ret = __ethtool_get_link_ksettings(hard_iface->net_dev, &link_settings);
+
+	/* Virtual interface drivers such as tun / tap interfaces, VLAN, etc
+	 * tend to initialize the interface throughput with some value for the
+	 * sake of having a throughput number to export via ethtool. This
+	 * exported throughput leaves batman-adv to conclude the interface
+	 * throughput is genuine (reflecting reality), thus no measurements
+	 * are necessary.
+	 *
+	 * Based on the observation that those interface types also tend to set
+	 * the link auto-negotiation to 'off', batman-adv shall check this
+	 * setting to differentiate between genuine link throughput information
+	 * and placeholders installed by virtual interfaces.
+	 */
+	if (ret != 0 || link_settings.base.autoneg != AUTONEG_ENABLE)
+		goto out;
+
+	/* link characteristics might change over time */
+	if (link_settings.base.duplex == DUPLEX_FULL)
+		set_bit(BATADV_FULL_DUPLEX, &hard_iface->bat_v.flags);
+	else
+		clear_bit(BATADV_FULL_DUPLEX, &hard_iface->bat_v.flags);
+
+	if (link_settings.base.speed &&
+	    link_settings.base.speed != SPEED_UNKNOWN)
+		throughput = link_settings.base.speed * 10;
+
+out:
+	atomic_set(&hard_iface->bat_v.link_throughput, throughput);
+}
+
 /**
  * batadv_v_elp_get_throughput() - get the throughput towards a neighbour
  * @neigh: the neighbour for which the throughput has to be obtained
+ * @real_netdev: the cfg80211 device below the incoming interface of the
+ *  neighbour or NULL if not available
  *
  * Return: The throughput towards the given neighbour in multiples of 100kpbs
  *         (a value of '1' equals to 0.1Mbps, '10' equals 1Mbps, etc).
  */
-static u32 batadv_v_elp_get_throughput(struct batadv_hardif_neigh_node *neigh)
+static u32 batadv_v_elp_get_throughput(struct batadv_hardif_neigh_node *neigh,
+				       struct net_device *real_netdev)
 {
 	struct batadv_hard_iface *hard_iface = neigh->if_incoming;
-	struct ethtool_link_ksettings link_settings;
-	struct net_device *real_netdev;
 	struct station_info sinfo;
 	u32 throughput;
 	int ret;
 
+	neigh->bat_v.est_needed = false;
+
 	/* if the user specified a customised value for this interface, then
 	 * return it directly
 	 */
@@ -98,13 +160,10 @@ static u32 batadv_v_elp_get_throughput(struct batadv_hardif_neigh_node *neigh)
 			/* unsupported WiFi driver version */
 			goto default_throughput;
 
-		real_netdev = batadv_get_real_netdev(hard_iface->net_dev);
 		if (!real_netdev)
 			goto default_throughput;
 
 		ret = cfg80211_get_station(real_netdev, neigh->addr, &sinfo);
-
-		dev_put(real_netdev);
 		if (ret == -ENOENT) {
 			/* Node is not associated anymore! It would be
 			 * possible to delete this neighbor. For now set
@@ -120,99 +179,183 @@ static u32 batadv_v_elp_get_throughput(struct batadv_hardif_neigh_node *neigh)
 		return sinfo.expected_throughput / 100;
 	}
 
-	/* if not a wifi interface, check if this device provides data via
-	 * ethtool (e.g. an Ethernet adapter)
+	/* if not a wifi interface, check if this device provided data via
+	 * ethtool (e.g. an Ethernet adapter) on the last link change
 	 */
-	memset(&link_settings, 0, sizeof(link_settings));
-	rtnl_lock();
-	ret = __ethtool_get_link_ksettings(hard_iface->net_dev, &link_settings);
-	rtnl_unlock();
+	throughput = atomic_read(&hard_iface->bat_v.link_throughput);
+	if (throughput != 0)
+		return throughput;
 
-	/* Virtual interface drivers such as tun / tap interfaces, VLAN, etc
-	 * tend to initialize the interface throughput with some value for the
-	 * sake of having a throughput number to export via ethtool. This
-	 * exported throughput leaves batman-adv to conclude the interface
-	 * throughput is genuine (reflecting reality), thus no measurements
-	 * are necessary.
-	 *
-	 * Based on the observation that those interface types also tend to set
-	 * the link auto-negotiation to 'off', batman-adv shall check this
-	 * setting to differentiate between genuine link throughput information
-	 * and placeholders installed by virtual interfaces.
+default_throughput:
+	/* fall back to the throughput estimated from ELP probe trains and
+	 * unicast traffic
 	 */
-	if (ret == 0 && link_settings.base.autoneg == AUTONEG_ENABLE) {
-		/* link characteristics might change over time */
-		if (link_settings.base.duplex == DUPLEX_FULL)
-			hard_iface->bat_v.flags |= BATADV_FULL_DUPLEX;
-		else
-			hard_iface->bat_v.flags &= ~BATADV_FULL_DUPLEX;
-
-		throughput = link_settings.base.speed;
-		if (throughput && throughput != SPEED_UNKNOWN)
-			return throughput * 10;
-	}
+	neigh->bat_v.est_needed = true;
+	throughput = ewma_throughput_read(&neigh->bat_v.est_throughput);
+	if (throughput != 0)
+		return throughput;
 
-default_throughput:
-	if (!(hard_iface->bat_v.flags & BATADV_WARNING_DEFAULT)) {
+	if (!test_and_set_bit(BATADV_WARNING_DEFAULT, &hard_iface->bat_v.flags))
 		batadv_info(hard_iface->soft_iface,
 			    "WiFi driver or ethtool info does not provide information about link speeds on interface %s, therefore defaulting to hardcoded throughput values of %u.%1u Mbps. Consider overriding the throughput manually or checking your driver.\n",
 			    hard_iface->net_dev->name,
 			    BATADV_THROUGHPUT_DEFAULT_VALUE / 10,
 			    BATADV_THROUGHPUT_DEFAULT_VALUE % 10);
-		hard_iface->bat_v.flags |= BATADV_WARNING_DEFAULT;
-	}
 
 	/* if none of the above cases apply, return the base_throughput */
 	return BATADV_THROUGHPUT_DEFAULT_VALUE;
 }
 
 /**
- * batadv_v_elp_throughput_metric_update() - worker updating the throughput
- *  metric of a single hop neighbour
- * @work: the work queue item
+ * batadv_v_elp_est_add() - add a sample to the throughput estimation
+ * @bat_v: B.A.T.M.A.N. V private data of the neighbour
+ * @throughput: the sampled throughput in multiples of 100kbps
+ */
+static void batadv_v_elp_est_add(struct batadv_hardif_neigh_node_bat_v *bat_v,
+				 u64 throughput)
+{
+	throughput = min_t(u64, throughput, BATADV_THROUGHPUT_MAX_VALUE);
+	if (throughput == 0)
+		return;
+
+	ewma_throughput_add(&bat_v->est_throughput, throughput);
+	atomic_inc(&bat_v->est_samples);
+}
+
+/**
+ * batadv_v_elp_est_tx_sample() - sample the unicast traffic sent to a
+ *  neighbour
+ * @neigh: the neighbour to sample
+ *
+ * The throughput achieved by the unicast traffic sent since the last sample
+ * is a lower bound of the link throughput. It is only added to the estimation
+ * when it exceeds the current estimate.
+ */
+static void batadv_v_elp_est_tx_sample(struct batadv_hardif_neigh_node *neigh)
+{
+	struct batadv_hardif_neigh_node_bat_v *bat_v = &neigh->bat_v;
+	unsigned int elapsed;
+	u64 throughput;
+	u32 tx_bytes;
+
+	elapsed = jiffies_to_msecs(jiffies - bat_v->tx_start);
+	if (elapsed == 0)
+		return;
+
+	tx_bytes = atomic_xchg(&bat_v->tx_bytes, 0);
+	bat_v->tx_start = jiffies;
+
+	if (!bat_v->est_needed)
+		return;
+
+	/* bits per millisecond are kbit/s */
+	throughput = div_u64((u64)tx_bytes * 8, elapsed * 100);
+	if (throughput <= ewma_throughput_read(&bat_v->est_throughput))
+		return;
+
+	batadv_v_elp_est_add(bat_v, throughput);
+}
+
+/**
+ * batadv_v_elp_throughput_metric_update() - update the throughput metric of
+ *  a batch of single hop neighbours
+ * @hard_iface: the interface the neighbours were seen on
+ * @neighs: list of neighbours linked via &batadv_hardif_neigh_node_bat_v.
+ *  metric_list. The reference of each neighbour is released
+ *
+ * The cfg80211 device below the interface is looked up only once for all
+ * neighbours as this requires the rtnl lock. The rtnl lock is only tried:
+ * batadv_v_elp_iface_disable() waits for this work while holding it. The
+ * update is skipped for this interval when the lock is busy.
  */
-void batadv_v_elp_throughput_metric_update(struct work_struct *work)
+static void
+batadv_v_elp_throughput_metric_update(struct batadv_hard_iface *hard_iface,
+				      struct hlist_head *neighs)
 {
-	struct batadv_hardif_neigh_node_bat_v *neigh_bat_v;
+	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
+	struct net_device *net_dev = hard_iface->net_dev;
 	struct batadv_hardif_neigh_node *neigh;
+	struct net_device *real_netdev = NULL;
+	struct hlist_node *node_tmp;
+	u32 old_throughput, throughput;
+	bool skip = false;
+
+	if (batadv_is_cfg80211_hardif(hard_iface) && !hlist_empty(neighs)) {
+		if (rtnl_trylock()) {
+			real_netdev = batadv_get_real_netdevice(net_dev);
+			rtnl_unlock();
+		} else {
+			skip = true;
+		}
+	}
+
+	hlist_for_each_entry_safe(neigh, node_tmp, neighs,
+				  bat_v.metric_list) {
+		hlist_del(&neigh->bat_v.metric_list);
+
+		if (skip) {
+			batadv_hardif_neigh_put(neigh);
+			continue;
+		}
 
-	neigh_bat_v = container_of(work, struct batadv_hardif_neigh_node_bat_v,
-				   metric_work);
-	neigh = container_of(neigh_bat_v, struct batadv_hardif_neigh_node,
-			     bat_v);
+		batadv_v_elp_est_tx_sample(neigh);
 
-	ewma_throughput_add(&neigh->bat_v.throughput,
-			    batadv_v_elp_get_throughput(neigh));
+		old_throughput = ewma_throughput_read(&neigh->bat_v.throughput);
+		ewma_throughput_add(&neigh->bat_v.throughput,
+				    batadv_v_elp_get_throughput(neigh,
+								real_netdev));
+		throughput = ewma_throughput_read(&neigh->bat_v.throughput);
 
-	/* decrement refcounter to balance increment performed before scheduling
-	 * this task
-	 */
-	batadv_hardif_neigh_put(neigh);
+		/* changes of more than 1/8 end the ELP/OGM interval backoff */
+		if (throughput > old_throughput + old_throughput / 8 ||
+		    throughput < old_throughput - old_throughput / 8)
+			batadv_topology_changed(bat_priv);
+
+		/* decrement refcounter to balance increment performed before
+		 * adding the neighbour to the list
+		 */
+		batadv_hardif_neigh_put(neigh);
+	}
+
+	if (real_netdev)
+		dev_put(real_netdev);
 }
 
 /**
- * batadv_v_elp_wifi_neigh_probe() - send link probing packets to a neighbour
+ * batadv_v_elp_neigh_probe() - send link probing packets to a neighbour
  * @neigh: the neighbour to probe
  *
  * Sends a predefined number of unicast wifi packets to a given neighbour in
  * order to trigger the throughput estimation on this link by the RC algorithm.
+ * The throughput is estimated by the receiver of a probe train. If no driver
+ * provides the throughput towards the neighbour, a longer train of larger
+ * packets is sent which asks the neighbour to answer with a train of its own.
+ * The same train is sent to answer such a request of the neighbour.
  * Packets are sent only if there there is not enough payload unicast traffic
- * towards this neighbour..
+ * towards this neighbour or if the neighbour requested a train..
  *
  * Return: True on success and false in case of error during skb preparation.
  */
-static bool
-batadv_v_elp_wifi_neigh_probe(struct batadv_hardif_neigh_node *neigh)
+static bool batadv_v_elp_neigh_probe(struct batadv_hardif_neigh_node *neigh)
 {
 	struct batadv_hard_iface *hard_iface = neigh->if_incoming;
 	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
+	struct batadv_elp_packet *elp_packet;
+	bool request = neigh->bat_v.est_needed;
+	struct batadv_elp_probe *probe;
 	unsigned long last_tx_diff;
+	bool estimate;
 	struct sk_buff *skb;
 	int probe_len, i;
 	int elp_skb_len;
+	int probes;
+	u32 seqno;
 
-	/* this probing routine is for Wifi neighbours only */
-	if (!batadv_is_wifi_hardif(hard_iface))
+	/* this probing routine is for Wifi neighbours and neighbours whose
+	 * throughput has to be estimated only
+	 */
+	estimate = request || neigh->bat_v.peer_est_needed;
+	if (!batadv_is_wifi_hardif(hard_iface) && !estimate)
 		return true;
 
 	/* probe the neighbor only if no unicast packets have been sent
@@ -223,13 +366,25 @@ batadv_v_elp_wifi_neigh_probe(struct batadv_hardif_neigh_node *neigh)
 	 * the sampling
 	 */
 	last_tx_diff = jiffies_to_msecs(jiffies - neigh->bat_v.last_unicast_tx);
-	if (last_tx_diff <= BATADV_ELP_PROBE_MAX_TX_DIFF)
+	if (last_tx_diff <= BATADV_ELP_PROBE_MAX_TX_DIFF &&
+	    !neigh->bat_v.peer_est_needed)
 		return true;
 
-	probe_len = max_t(int, sizeof(struct batadv_elp_packet),
-			  BATADV_ELP_MIN_PROBE_SIZE);
+	if (estimate) {
+		probes = BATADV_ELP_EST_PROBES;
+		probe_len = min_t(int, hard_iface->net_dev->mtu,
+				  BATADV_ELP_EST_PROBE_SIZE);
+	} else {
+		probes = BATADV_ELP_PROBES_PER_NODE;
+		probe_len = BATADV_ELP_MIN_PROBE_SIZE;
+	}
+
+	probe_len = max_t(int, sizeof(struct batadv_elp_packet), probe_len);
+
+	/* the probes of a train carry the seqno of the last broadcast ELP */
+	seqno = atomic_read(&hard_iface->bat_v.elp_seqno) - 1;
 
-	for (i = 0; i < BATADV_ELP_PROBES_PER_NODE; i++) {
+	for (i = 0; i < probes; i++) {
 		elp_skb_len = hard_iface->bat_v.elp_skb->len;
 		skb = skb_copy_expand(hard_iface->bat_v.elp_skb, 0,
 				      probe_len - elp_skb_len,
@@ -243,6 +398,14 @@ batadv_v_elp_wifi_neigh_probe(struct batadv_hardif_neigh_node *neigh)
 		 */
 		skb_put_zero(skb, probe_len - hard_iface->bat_v.elp_skb->len);
 
+		elp_packet = (struct batadv_elp_packet *)skb->data;
+		elp_packet->seqno = htonl(seqno);
+
+		if (request && probe_len >= BATADV_ELP_HLEN + sizeof(*probe)) {
+			probe = (struct batadv_elp_probe *)(elp_packet + 1);
+			probe->flags = BATADV_ELP_PROBE_EST_REQUEST;
+		}
+
 		batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
 			   "Sending unicast (probe) ELP packet on interface %s to %pM\n",
 			   hard_iface->net_dev->name, neigh->addr);
@@ -250,6 +413,9 @@ batadv_v_elp_wifi_neigh_probe(struct batadv_hardif_neigh_node *neigh)
 		batadv_send_skb_packet(skb, hard_iface, neigh->addr);
 	}
 
+	if (estimate)
+		neigh->bat_v.peer_est_needed = false;
+
 	return true;
 }
 
@@ -266,13 +432,14 @@ static void batadv_v_elp_periodic_work(struct work_struct *work)
 	struct batadv_hard_iface_bat_v *bat_v;
 	struct batadv_elp_packet *elp_packet;
 	struct batadv_priv *bat_priv;
+	struct hlist_head metric_list;
 	struct sk_buff *skb;
 	u32 elp_interval;
-	bool ret;
 
 	bat_v = container_of(work, struct batadv_hard_iface_bat_v, elp_wq.work);
 	hard_iface = container_of(bat_v, struct batadv_hard_iface, bat_v);
 	bat_priv = netdev_priv(hard_iface->soft_iface);
+	elp_interval = atomic_read(&hard_iface->bat_v.elp_interval);
 
 	if (atomic_read(&bat_priv->mesh_state) == BATADV_MESH_DEACTIVATING)
 		goto out;
@@ -290,9 +457,13 @@ static void batadv_v_elp_periodic_work(struct work_struct *work)
 	if (!skb)
 		goto restart_timer;
 
+	/* metric changes detected in the previous run reset the interval */
+	elp_interval = batadv_interval_backoff(bat_priv,
+					       &hard_iface->bat_v.elp_backoff,
+					       elp_interval);
+
 	elp_packet = (struct batadv_elp_packet *)skb->data;
 	elp_packet->seqno = htonl(atomic_read(&hard_iface->bat_v.elp_seqno));
-	elp_interval = atomic_read(&hard_iface->bat_v.elp_interval);
 	elp_packet->elp_interval = htonl(elp_interval);
 
 	batadv_dbg(BATADV_DBG_BATMAN, bat_priv,
@@ -309,15 +480,17 @@ static void batadv_v_elp_periodic_work(struct work_struct *work)
 	 * react timely to its death.
 	 *
 	 * The throughput metric is updated by following these steps:
-	 * 1) if the hard_iface is wifi => send a number of unicast ELPs for
-	 *    probing/sampling to each neighbor
+	 * 1) if the hard_iface is wifi or the throughput has to be estimated =>
+	 *    send a number of unicast ELPs for probing/sampling to each neighbor
 	 * 2) update the throughput metric value of each neighbor (note that the
 	 *    value retrieved in this step might be 100ms old because the
 	 *    probing packets at point 1) could still be in the HW queue)
 	 */
+	INIT_HLIST_HEAD(&metric_list);
+
 	rcu_read_lock();
 	hlist_for_each_entry_rcu(hardif_neigh, &hard_iface->neigh_list, list) {
-		if (!batadv_v_elp_wifi_neigh_probe(hardif_neigh))
+		if (!batadv_v_elp_neigh_probe(hardif_neigh))
 			/* if something goes wrong while probing, better to stop
 			 * sending packets immediately and reschedule the task
 			 */
@@ -328,18 +501,16 @@ static void batadv_v_elp_periodic_work(struct work_struct *work)
 
 		/* Reading the estimated throughput from cfg80211 is a task that
 		 * may sleep and that is not allowed in an rcu protected
-		 * context. Therefore schedule a task for that.
+		 * context. Therefore collect the neighbors first.
 		 */
-		ret = queue_work(batadv_event_workqueue,
-				 &hardif_neigh->bat_v.metric_work);
-
-		if (!ret)
-			batadv_hardif_neigh_put(hardif_neigh);
+		hlist_add_head(&hardif_neigh->bat_v.metric_list, &metric_list);
 	}
 	rcu_read_unlock();
 
+	batadv_v_elp_throughput_metric_update(hard_iface, &metric_list);
+
 restart_timer:
-	batadv_v_elp_start_timer(hard_iface);
+	batadv_v_elp_start_timer(hard_iface, elp_interval);
 out:
 	return;
 }
@@ -377,17 +548,20 @@ int batadv_v_elp_iface_enable(struct batadv_hard_iface *hard_iface)
 	atomic_set(&hard_iface->bat_v.elp_seqno, random_seqno);
 
 	/* assume full-duplex by default */
-	hard_iface->bat_v.flags |= BATADV_FULL_DUPLEX;
+	set_bit(BATADV_FULL_DUPLEX, &hard_iface->bat_v.flags);
 
 	/* warn the user (again) if there is no throughput data is available */
-	hard_iface->bat_v.flags &= ~BATADV_WARNING_DEFAULT;
+	clear_bit(BATADV_WARNING_DEFAULT, &hard_iface->bat_v.flags);
 
 	if (batadv_is_wifi_hardif(hard_iface))
-		hard_iface->bat_v.flags &= ~BATADV_FULL_DUPLEX;
+		clear_bit(BATADV_FULL_DUPLEX, &hard_iface->bat_v.flags);
+
+	batadv_v_elp_iface_link_update(hard_iface);
 
 	INIT_DELAYED_WORK(&hard_iface->bat_v.elp_wq,
 			  batadv_v_elp_periodic_work);
-	batadv_v_elp_start_timer(hard_iface);
+	batadv_v_elp_start_timer(hard_iface,
+				 atomic_read(&hard_iface->bat_v.elp_interval));
 	res = 0;
 
 out:
@@ -507,6 +681,85 @@ static void batadv_v_elp_neigh_update(struct batadv_priv *bat_priv,
 		batadv_orig_node_put(orig_neigh);
 }
 
+/**
+ * batadv_v_elp_probe_recv() - estimate the throughput from an ELP probe
+ * @skb: the received probe
+ * @if_incoming: the interface this probe was received through
+ *
+ * The probes of a train are sent back-to-back. The time between the arrival
+ * of two probes of the same train therefore is the time the link needed to
+ * transmit the second one. Links are assumed to be symmetric, so the result
+ * is used as estimation of the throughput towards the neighbour. A train
+ * flagged as request is answered with a train of this node at the next ELP
+ * interval, so that the neighbour gets its estimation as well.
+ *
+ * Return: NET_RX_SUCCESS and consumes the skb if the probe was properly
+ * processed or NET_RX_DROP in case of failure.
+ */
+static int batadv_v_elp_probe_recv(struct sk_buff *skb,
+				   struct batadv_hard_iface *if_incoming)
+{
+	struct batadv_priv *bat_priv = netdev_priv(if_incoming->soft_iface);
+	struct ethhdr *ethhdr = (struct ethhdr *)skb_mac_header(skb);
+	struct batadv_hardif_neigh_node *hardif_neigh;
+	struct batadv_hardif_neigh_node_bat_v *bat_v;
+	struct batadv_elp_packet *elp_packet;
+	struct batadv_elp_probe *probe;
+	ktime_t now = ktime_get();
+	int ret = NET_RX_DROP;
+	u64 throughput;
+	s64 gap;
+	u32 seqno;
+
+	if (unlikely(!pskb_may_pull(skb, BATADV_ELP_HLEN)))
+		goto free_skb;
+
+	if (!batadv_is_my_mac(bat_priv, ethhdr->h_dest))
+		goto free_skb;
+
+	if (strcmp(bat_priv->algo_ops->name, "BATMAN_V") != 0)
+		goto free_skb;
+
+	hardif_neigh = batadv_hardif_neigh_get(if_incoming, ethhdr->h_source);
+	if (!hardif_neigh)
+		goto free_skb;
+
+	bat_v = &hardif_neigh->bat_v;
+	elp_packet = (struct batadv_elp_packet *)skb->data;
+	seqno = ntohl(elp_packet->seqno);
+
+	if (seqno == bat_v->probe_seqno) {
+		gap = ktime_to_ns(ktime_sub(now, bat_v->probe_last));
+
+		/* bits per nanosecond are Gbit/s */
+		if (gap > 0) {
+			throughput = (u64)(skb->len + ETH_HLEN) * 8 * 10000;
+			throughput = div64_u64(throughput, gap);
+			batadv_v_elp_est_add(bat_v, throughput);
+		}
+	}
+
+	bat_v->probe_seqno = seqno;
+	bat_v->probe_last = now;
+
+	if (pskb_may_pull(skb, BATADV_ELP_HLEN + sizeof(*probe))) {
+		probe = (struct batadv_elp_probe *)(skb->data + BATADV_ELP_HLEN);
+		if (probe->flags & BATADV_ELP_PROBE_EST_REQUEST)
+			bat_v->peer_est_needed = true;
+	}
+
+	batadv_hardif_neigh_put(hardif_neigh);
+	ret = NET_RX_SUCCESS;
+
+free_skb:
+	if (ret == NET_RX_SUCCESS)
+		consume_skb(skb);
+	else
+		kfree_skb(skb);
+
+	return ret;
+}
+
 /**
  * batadv_v_elp_packet_recv() - main ELP packet handler
  * @skb: the received packet
@@ -525,6 +778,10 @@ int batadv_v_elp_packet_recv(struct sk_buff *skb,
 	bool res;
 	int ret = NET_RX_DROP;
 
+	/* unicast ELP packets are probes and carry no neighbour state */
+	if (!is_broadcast_ether_addr(ethhdr->h_dest))
+		return batadv_v_elp_probe_recv(skb, if_incoming);
+
 	res = batadv_check_management_packet(skb, if_incoming, BATADV_ELP_HLEN);
 	if (!res)
 		goto free_skb;
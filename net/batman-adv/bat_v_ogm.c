@@ -20,6 +20,7 @@
 #include "main.h"
 
 #include <linux/atomic.h>
+#include <linux/bitops.h>
 #include <linux/byteorder/generic.h>
 #include <linux/errno.h>
 #include <linux/etherdevice.h>
@@ -28,13 +29,16 @@
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
+#include <linux/lockdep.h>
 #include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/random.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
 #include <linux/types.h>
@@ -45,6 +49,7 @@
 #include "hard-interface.h"
 #include "hash.h"
 #include "log.h"
+#include "network-coding.h"
 #include "originator.h"
 #include "routing.h"
 #include "send.h"
@@ -101,12 +106,28 @@ static void batadv_v_ogm_start_timer(struct batadv_priv *bat_priv)
 	if (delayed_work_pending(&bat_priv->bat_v.ogm_wq))
 		return;
 
-	msecs = atomic_read(&bat_priv->orig_interval) - BATADV_JITTER;
+	msecs = batadv_interval_backoff(bat_priv, &bat_priv->bat_v.ogm_backoff,
+					atomic_read(&bat_priv->orig_interval));
+	msecs -= BATADV_JITTER;
 	msecs += prandom_u32() % (2 * BATADV_JITTER);
 	queue_delayed_work(batadv_event_workqueue, &bat_priv->bat_v.ogm_wq,
 			   msecs_to_jiffies(msecs));
 }
 
+/**
+ * batadv_v_ogm_start_queue_timer() - restart the OGM aggregation timer
+ * @hard_iface: the interface to use to send the OGM
+ */
+static void batadv_v_ogm_start_queue_timer(struct batadv_hard_iface *hard_iface)
+{
+	unsigned int msecs = BATADV_MAX_AGGREGATION_MS * 1000;
+
+	/* msecs * [0.9, 1.1] */
+	msecs += prandom_u32() % (msecs / 5) - (msecs / 10);
+	queue_delayed_work(batadv_event_workqueue, &hard_iface->bat_v.aggr_wq,
+			   msecs_to_jiffies(msecs / 1000));
+}
+
 /**
  * batadv_v_ogm_send_to_if() - send a batman ogm using a given interface
  * @skb: the OGM to send
@@ -117,8 +138,10 @@ static void batadv_v_ogm_send_to_if(struct sk_buff *skb,
 {
 	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
 
-	if (hard_iface->if_status != BATADV_IF_ACTIVE)
+	if (hard_iface->if_status != BATADV_IF_ACTIVE) {
+		kfree_skb(skb);
 		return;
+	}
 
 	batadv_inc_counter(bat_priv, BATADV_CNT_MGMT_TX);
 	batadv_add_counter(bat_priv, BATADV_CNT_MGMT_TX_BYTES,
@@ -127,6 +150,134 @@ static void batadv_v_ogm_send_to_if(struct sk_buff *skb,
 	batadv_send_broadcast_skb(skb, hard_iface);
 }
 
+/**
+ * batadv_v_ogm_len() - OGMv2 packet length
+ * @skb: the OGM to check
+ *
+ * Return: Length of the given OGMv2 packet, including tvlv length, excluding
+ * ethernet header length.
+ */
+static unsigned int batadv_v_ogm_len(struct sk_buff *skb)
+{
+	struct batadv_ogm2_packet *ogm_packet;
+
+	ogm_packet = (struct batadv_ogm2_packet *)skb->data;
+	return BATADV_OGM2_HLEN + ntohs(ogm_packet->tvlv_len);
+}
+
+/**
+ * batadv_v_ogm_queue_left() - check if given OGM still fits aggregation queue
+ * @skb: the OGM to check
+ * @hard_iface: the interface to use to send the OGM
+ *
+ * Caller needs to hold the hard_iface->bat_v.aggr_list_lock.
+ *
+ * Return: True, if the given OGMv2 packet still fits, false otherwise.
+ */
+static bool batadv_v_ogm_queue_left(struct sk_buff *skb,
+				    struct batadv_hard_iface *hard_iface)
+{
+	unsigned int max = min_t(unsigned int, hard_iface->net_dev->mtu,
+				 BATADV_MAX_AGGREGATION_BYTES);
+	unsigned int ogm_len = batadv_v_ogm_len(skb);
+
+	lockdep_assert_held(&hard_iface->bat_v.aggr_list_lock);
+
+	return hard_iface->bat_v.aggr_len + ogm_len <= max;
+}
+
+/**
+ * batadv_v_ogm_aggr_list_free() - free all elements in an aggregation queue
+ * @hard_iface: the interface holding the aggregation queue
+ *
+ * Empties the OGMv2 aggregation queue and frees all the skbs it contains.
+ *
+ * Caller needs to hold the hard_iface->bat_v.aggr_list_lock.
+ */
+static void batadv_v_ogm_aggr_list_free(struct batadv_hard_iface *hard_iface)
+{
+	lockdep_assert_held(&hard_iface->bat_v.aggr_list_lock);
+
+	__skb_queue_purge(&hard_iface->bat_v.aggr_list);
+	hard_iface->bat_v.aggr_len = 0;
+}
+
+/**
+ * batadv_v_ogm_aggr_send() - flush & send aggregation queue
+ * @hard_iface: the interface with the aggregation queue to flush
+ *
+ * Aggregates all OGMv2 packets currently in the aggregation queue into a
+ * single OGMv2 packet and transmits this aggregate.
+ *
+ * The aggregation queue is empty after this call.
+ *
+ * Caller needs to hold the hard_iface->bat_v.aggr_list_lock.
+ */
+static void batadv_v_ogm_aggr_send(struct batadv_hard_iface *hard_iface)
+{
+	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
+	unsigned int aggr_len = hard_iface->bat_v.aggr_len;
+	struct sk_buff *skb_aggr;
+	unsigned int ogm_len;
+	unsigned int ogms = 0;
+	struct sk_buff *skb;
+
+	lockdep_assert_held(&hard_iface->bat_v.aggr_list_lock);
+
+	if (!aggr_len)
+		return;
+
+	skb_aggr = dev_alloc_skb(aggr_len + ETH_HLEN + NET_IP_ALIGN);
+	if (!skb_aggr) {
+		batadv_v_ogm_aggr_list_free(hard_iface);
+		return;
+	}
+
+	skb_reserve(skb_aggr, ETH_HLEN + NET_IP_ALIGN);
+	skb_reset_network_header(skb_aggr);
+
+	while ((skb = __skb_dequeue(&hard_iface->bat_v.aggr_list))) {
+		ogm_len = batadv_v_ogm_len(skb);
+		hard_iface->bat_v.aggr_len -= ogm_len;
+
+		skb_put_data(skb_aggr, skb->data, ogm_len);
+		consume_skb(skb);
+		ogms++;
+	}
+
+	if (ogms > 1) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_OGM2_AGGR_TX);
+		batadv_add_counter(bat_priv, BATADV_CNT_OGM2_AGGR_TX_OGMS,
+				   ogms);
+	}
+
+	batadv_v_ogm_send_to_if(skb_aggr, hard_iface);
+}
+
+/**
+ * batadv_v_ogm_queue_on_if() - queue a batman ogm on a given interface
+ * @skb: the OGM to queue
+ * @hard_iface: the interface to queue the OGM on
+ */
+static void batadv_v_ogm_queue_on_if(struct sk_buff *skb,
+				     struct batadv_hard_iface *hard_iface)
+{
+	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
+
+	if (!atomic_read(&bat_priv->aggregated_ogms)) {
+		batadv_v_ogm_send_to_if(skb, hard_iface);
+		return;
+	}
+
+	spin_lock_bh(&hard_iface->bat_v.aggr_list_lock);
+	if (!batadv_v_ogm_queue_left(skb, hard_iface))
+		batadv_v_ogm_aggr_send(hard_iface);
+
+	hard_iface->bat_v.aggr_len += batadv_v_ogm_len(skb);
+	__skb_queue_tail(&hard_iface->bat_v.aggr_list, skb);
+	spin_unlock_bh(&hard_iface->bat_v.aggr_list_lock);
+}
+
 /**
  * batadv_v_ogm_send() - periodic worker broadcasting the own OGM
  * @work: work queue item
@@ -215,14 +366,14 @@ static void batadv_v_ogm_send(struct work_struct *work)
 			   hard_iface->net_dev->name,
 			   hard_iface->net_dev->dev_addr);
 
-		/* this skb gets consumed by batadv_v_ogm_send_to_if() */
+		/* this skb gets consumed by batadv_v_ogm_queue_on_if() */
 		skb_tmp = skb_clone(skb, GFP_ATOMIC);
 		if (!skb_tmp) {
 			batadv_hardif_put(hard_iface);
 			break;
 		}
 
-		batadv_v_ogm_send_to_if(skb_tmp, hard_iface);
+		batadv_v_ogm_queue_on_if(skb_tmp, hard_iface);
 		batadv_hardif_put(hard_iface);
 	}
 	rcu_read_unlock();
@@ -235,6 +386,27 @@ static void batadv_v_ogm_send(struct work_struct *work)
 	return;
 }
 
+/**
+ * batadv_v_ogm_aggr_work() - OGM queue periodic task per interface
+ * @work: work queue item
+ *
+ * Emits aggregated OGM messages in regular intervals.
+ */
+void batadv_v_ogm_aggr_work(struct work_struct *work)
+{
+	struct batadv_hard_iface_bat_v *batv;
+	struct batadv_hard_iface *hard_iface;
+
+	batv = container_of(work, struct batadv_hard_iface_bat_v, aggr_wq.work);
+	hard_iface = container_of(batv, struct batadv_hard_iface, bat_v);
+
+	spin_lock_bh(&hard_iface->bat_v.aggr_list_lock);
+	batadv_v_ogm_aggr_send(hard_iface);
+	spin_unlock_bh(&hard_iface->bat_v.aggr_list_lock);
+
+	batadv_v_ogm_start_queue_timer(hard_iface);
+}
+
 /**
  * batadv_v_ogm_iface_enable() - prepare an interface for B.A.T.M.A.N. V
  * @hard_iface: the interface to prepare
@@ -247,11 +419,25 @@ int batadv_v_ogm_iface_enable(struct batadv_hard_iface *hard_iface)
 {
 	struct batadv_priv *bat_priv = netdev_priv(hard_iface->soft_iface);
 
+	batadv_v_ogm_start_queue_timer(hard_iface);
 	batadv_v_ogm_start_timer(bat_priv);
 
 	return 0;
 }
 
+/**
+ * batadv_v_ogm_iface_disable() - release OGM interface private resources
+ * @hard_iface: interface for which the resources have to be released
+ */
+void batadv_v_ogm_iface_disable(struct batadv_hard_iface *hard_iface)
+{
+	cancel_delayed_work_sync(&hard_iface->bat_v.aggr_wq);
+
+	spin_lock_bh(&hard_iface->bat_v.aggr_list_lock);
+	batadv_v_ogm_aggr_list_free(hard_iface);
+	spin_unlock_bh(&hard_iface->bat_v.aggr_list_lock);
+}
+
 /**
  * batadv_v_ogm_primary_iface_set() - set a new primary interface
  * @primary_iface: the new primary interface
@@ -307,7 +493,7 @@ static u32 batadv_v_forward_penalty(struct batadv_priv *bat_priv,
 	 */
 	if (throughput > 10 &&
 	    if_incoming == if_outgoing &&
-	    !(if_incoming->bat_v.flags & BATADV_FULL_DUPLEX))
+	    !test_bit(BATADV_FULL_DUPLEX, &if_incoming->bat_v.flags))
 		return throughput / 2;
 
 	/* hop penalty of 255 equals 100% */
@@ -394,7 +580,7 @@ static void batadv_v_ogm_forward(struct batadv_priv *bat_priv,
 		   if_outgoing->net_dev->name, ntohl(ogm_forward->throughput),
 		   ogm_forward->ttl, if_incoming->net_dev->name);
 
-	batadv_v_ogm_send_to_if(skb, if_outgoing);
+	batadv_v_ogm_queue_on_if(skb, if_outgoing);
 
 out:
 	if (orig_ifinfo)
@@ -659,6 +845,95 @@ static bool batadv_v_ogm_aggr_packet(int buff_pos, int packet_len,
 	       (next_buff_pos <= BATADV_MAX_AGGREGATION_BYTES);
 }
 
+/**
+ * batadv_v_ogm_nc_link_quality() - get the quality of the link between the
+ *  originator of an OGM and the neighbor it was received from
+ * @bat_priv: the bat priv with all the soft interface information
+ * @if_incoming: the interface where the OGM has been received
+ * @ogm_throughput: the throughput metric announced in the OGM
+ * @link_throughput: the throughput of the link towards the neighbor
+ *
+ * The neighbor penalised the throughput of its link towards the originator
+ * when forwarding the OGM. The same penalty is applied to the link towards the
+ * neighbor to make both comparable.
+ *
+ * Return: the throughput of the link between the originator and the neighbor
+ * relative to the link towards the neighbor, scaled to 0 - BATADV_TQ_MAX_VALUE.
+ */
+static u8 batadv_v_ogm_nc_link_quality(struct batadv_priv *bat_priv,
+				       struct batadv_hard_iface *if_incoming,
+				       u32 ogm_throughput, u32 link_throughput)
+{
+	u32 neigh_throughput;
+
+	neigh_throughput = batadv_v_forward_penalty(bat_priv, if_incoming,
+						    if_incoming,
+						    link_throughput);
+	if (!neigh_throughput)
+		return 0;
+
+	if (ogm_throughput >= neigh_throughput)
+		return BATADV_TQ_MAX_VALUE;
+
+	return div_u64((u64)ogm_throughput * BATADV_TQ_MAX_VALUE,
+		       neigh_throughput);
+}
+
+/**
+ * batadv_v_ogm_update_nc() - update the network coding neighbors of the
+ *  originator of an OGM
+ * @bat_priv: the bat priv with all the soft interface information
+ * @ogm_packet: the received OGM
+ * @orig_node: the originator which emitted the OGM
+ * @hardif_neigh: the single hop neighbor the OGM has been received from
+ * @if_incoming: the interface where the OGM has been received
+ * @ogm_throughput: the throughput metric announced in the OGM
+ * @link_throughput: the throughput of the link towards hardif_neigh
+ */
+static void
+batadv_v_ogm_update_nc(struct batadv_priv *bat_priv,
+		       const struct batadv_ogm2_packet *ogm_packet,
+		       struct batadv_orig_node *orig_node,
+		       struct batadv_hardif_neigh_node *hardif_neigh,
+		       struct batadv_hard_iface *if_incoming,
+		       u32 ogm_throughput, u32 link_throughput)
+{
+	struct batadv_orig_node *orig_neigh_node;
+	bool is_single_hop_neigh;
+	u8 link_quality = 0;
+
+	/* spare the originator lookup for every OGM */
+	if (!batadv_nc_enabled(bat_priv))
+		return;
+
+	is_single_hop_neigh = batadv_compare_eth(ogm_packet->orig,
+						 hardif_neigh->orig);
+	if (is_single_hop_neigh) {
+		kref_get(&orig_node->refcount);
+		orig_neigh_node = orig_node;
+	} else {
+		orig_neigh_node = batadv_orig_hash_find(bat_priv,
+							hardif_neigh->orig);
+		if (!orig_neigh_node)
+			return;
+
+		/* only an OGM forwarded exactly once describes the link between
+		 * the originator and the neighbor
+		 */
+		if (ogm_packet->ttl == BATADV_TTL - 1)
+			link_quality =
+				batadv_v_ogm_nc_link_quality(bat_priv,
+							     if_incoming,
+							     ogm_throughput,
+							     link_throughput);
+	}
+
+	batadv_nc_update_nc_node(bat_priv, orig_node, orig_neigh_node,
+				 link_quality, is_single_hop_neigh);
+
+	batadv_orig_node_put(orig_neigh_node);
+}
+
 /**
  * batadv_v_ogm_process() - process an incoming batman v OGM
  * @skb: the skb containing the OGM
@@ -727,6 +1002,9 @@ static void batadv_v_ogm_process(const struct sk_buff *skb, int ogm_offset,
 	path_throughput = min_t(u32, link_throughput, ogm_throughput);
 	ogm_packet->throughput = htonl(path_throughput);
 
+	batadv_v_ogm_update_nc(bat_priv, ogm_packet, orig_node, hardif_neigh,
+			       if_incoming, ogm_throughput, link_throughput);
+
 	batadv_v_ogm_process_per_outif(bat_priv, ethhdr, ogm_packet, orig_node,
 				       neigh_node, if_incoming,
 				       BATADV_IF_DEFAULT);
@@ -37,6 +37,7 @@
 #include <linux/lockdep.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
+#include <linux/percpu.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/seq_file.h>
@@ -192,7 +193,7 @@ static void batadv_claim_release(struct kref *ref)
 
 	spin_lock_bh(&claim->backbone_lock);
 	old_backbone_gw = claim->backbone_gw;
-	claim->backbone_gw = NULL;
+	WRITE_ONCE(claim->backbone_gw, NULL);
 	spin_unlock_bh(&claim->backbone_lock);
 
 	spin_lock_bh(&old_backbone_gw->crc_lock);
@@ -252,6 +253,97 @@ batadv_claim_hash_find(struct batadv_priv *bat_priv,
 	return claim_tmp;
 }
 
+/**
+ * batadv_bla_claim_cache_index() - choose the per cpu cache slot of a claim
+ * @addr: the mac address of the claim
+ * @vid: the VLAN ID of the claim
+ *
+ * Return: the index of the cache slot
+ */
+static inline u32 batadv_bla_claim_cache_index(const u8 *addr,
+					       unsigned short vid)
+{
+	u32 index = (addr[4] << 8) | addr[5];
+
+	return (index ^ vid) & (BATADV_BLA_CLAIM_CACHE_SIZE - 1);
+}
+
+/**
+ * batadv_bla_claim_invalidate_cache() - invalidate all per cpu claim caches
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Has to be called after a claim was removed from the claim hash and before
+ * the reference of the hash is dropped.
+ */
+static void batadv_bla_claim_invalidate_cache(struct batadv_priv *bat_priv)
+{
+	/* the unlink from the claim hash has to be visible before the new
+	 * generation. Otherwise a reader could still find the removed claim and
+	 * cache it under the new generation
+	 */
+	smp_mb__before_atomic();
+	atomic_inc(&bat_priv->bla.claim_gen);
+	smp_mb__after_atomic();
+}
+
+/**
+ * batadv_bla_claim_lookup_rcu() - look up a claim without taking a reference
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: the mac address of the claim
+ * @vid: the VLAN ID of the claim
+ *
+ * The per cpu claim cache is consulted first and only on a miss the claim hash
+ * is searched. Must be called from bottom half context while holding the
+ * rcu_read_lock. The returned claim can only be used until rcu_read_unlock()
+ * is called.
+ *
+ * Return: claim if found or NULL otherwise.
+ */
+static struct batadv_bla_claim *
+batadv_bla_claim_lookup_rcu(struct batadv_priv *bat_priv, const u8 *addr,
+			    unsigned short vid)
+{
+	struct batadv_hashtable *hash = bat_priv->bla.claim_hash;
+	struct batadv_bla_claim_cache_entry *entry;
+	struct batadv_bla_claim_cache *cache;
+	struct batadv_bla_claim search_claim;
+	struct batadv_bla_claim *claim;
+	struct hlist_head *head;
+	unsigned int gen;
+	u32 index;
+
+	if (!hash)
+		return NULL;
+
+	gen = atomic_read(&bat_priv->bla.claim_gen);
+	smp_rmb(); /* read generation before the cached claim pointer */
+
+	cache = this_cpu_ptr(bat_priv->bla.claim_cache);
+	entry = &cache->entries[batadv_bla_claim_cache_index(addr, vid)];
+
+	claim = entry->claim;
+	if (claim && entry->gen == gen && claim->vid == vid &&
+	    batadv_compare_eth(claim->addr, addr))
+		return claim;
+
+	ether_addr_copy(search_claim.addr, addr);
+	search_claim.vid = vid;
+
+	index = batadv_choose_claim(&search_claim, hash->size);
+	head = &hash->table[index];
+
+	hlist_for_each_entry_rcu(claim, head, hash_entry) {
+		if (!batadv_compare_claim(&claim->hash_entry, &search_claim))
+			continue;
+
+		entry->claim = claim;
+		entry->gen = gen;
+		return claim;
+	}
+
+	return NULL;
+}
+
 /**
  * batadv_backbone_hash_find() - looks for a backbone gateway in the hash
  * @bat_priv: the bat priv with all the soft interface information
@@ -324,8 +416,9 @@ batadv_bla_del_backbone_claims(struct batadv_bla_backbone_gw *backbone_gw)
 			if (claim->backbone_gw != backbone_gw)
 				continue;
 
-			batadv_claim_put(claim);
 			hlist_del_rcu(&claim->hash_entry);
+			batadv_bla_claim_invalidate_cache(backbone_gw->bat_priv);
+			batadv_claim_put(claim);
 		}
 		spin_unlock_bh(list_lock);
 	}
@@ -751,7 +844,7 @@ static void batadv_bla_add_claim(struct batadv_priv *bat_priv,
 	spin_lock_bh(&claim->backbone_lock);
 	old_backbone_gw = claim->backbone_gw;
 	kref_get(&backbone_gw->refcount);
-	claim->backbone_gw = backbone_gw;
+	WRITE_ONCE(claim->backbone_gw, backbone_gw);
 	spin_unlock_bh(&claim->backbone_lock);
 
 	if (remove_crc) {
@@ -793,6 +886,32 @@ batadv_bla_claim_get_backbone_gw(struct batadv_bla_claim *claim)
 	return backbone_gw;
 }
 
+/**
+ * batadv_bla_claim_is_own_rcu() - check whether a claim belongs to this host
+ * @claim: claim found via batadv_bla_claim_lookup_rcu()
+ * @primary_if: the selected primary interface
+ * @valid: set to false when the claim is about to be released
+ *
+ * Must be called with the rcu_read_lock held.
+ *
+ * Return: true if the claim is owned by the backbone gw of @primary_if
+ */
+static bool batadv_bla_claim_is_own_rcu(struct batadv_bla_claim *claim,
+					struct batadv_hard_iface *primary_if,
+					bool *valid)
+{
+	struct batadv_bla_backbone_gw *backbone_gw;
+
+	/* backbone gateways are freed only after a rcu grace period */
+	backbone_gw = READ_ONCE(claim->backbone_gw);
+	*valid = !!backbone_gw;
+	if (!backbone_gw)
+		return false;
+
+	return batadv_compare_eth(backbone_gw->orig,
+				  primary_if->net_dev->dev_addr);
+}
+
 /**
  * batadv_bla_del_claim() - delete a claim from the claim hash
  * @bat_priv: the bat priv with all the soft interface information
@@ -813,9 +932,11 @@ static void batadv_bla_del_claim(struct batadv_priv *bat_priv,
 	batadv_dbg(BATADV_DBG_BLA, bat_priv, "%s(): %pM, vid %d\n", __func__,
 		   mac, batadv_print_vid(vid));
 
-	batadv_hash_remove(bat_priv->bla.claim_hash, batadv_compare_claim,
-			   batadv_choose_claim, claim);
-	batadv_claim_put(claim); /* reference from the hash is gone */
+	if (batadv_hash_remove(bat_priv->bla.claim_hash, batadv_compare_claim,
+			       batadv_choose_claim, claim)) {
+		batadv_bla_claim_invalidate_cache(bat_priv);
+		batadv_claim_put(claim); /* reference from the hash is gone */
+	}
 
 	/* don't need the reference from hash_find() anymore */
 	batadv_claim_put(claim);
@@ -1558,12 +1679,17 @@ int batadv_bla_init(struct batadv_priv *bat_priv)
 	if (bat_priv->bla.claim_hash)
 		return 0;
 
-	bat_priv->bla.claim_hash = batadv_hash_new(128);
+	bat_priv->bla.claim_hash = batadv_hash_new(BATADV_BLA_CLAIM_HASH_SIZE);
 	bat_priv->bla.backbone_hash = batadv_hash_new(32);
 
 	if (!bat_priv->bla.claim_hash || !bat_priv->bla.backbone_hash)
 		return -ENOMEM;
 
+	atomic_set(&bat_priv->bla.claim_gen, 0);
+	bat_priv->bla.claim_cache = alloc_percpu(struct batadv_bla_claim_cache);
+	if (!bat_priv->bla.claim_cache)
+		return -ENOMEM;
+
 	batadv_hash_set_lock_class(bat_priv->bla.claim_hash,
 				   &batadv_claim_hash_lock_class_key);
 	batadv_hash_set_lock_class(bat_priv->bla.backbone_hash,
@@ -1748,6 +1874,8 @@ void batadv_bla_free(struct batadv_priv *bat_priv)
 		batadv_hash_destroy(bat_priv->bla.backbone_hash);
 		bat_priv->bla.backbone_hash = NULL;
 	}
+	free_percpu(bat_priv->bla.claim_cache);
+	bat_priv->bla.claim_cache = NULL;
 	if (primary_if)
 		batadv_hardif_put(primary_if);
 }
@@ -1826,10 +1954,11 @@ batadv_bla_loopdetect_check(struct batadv_priv *bat_priv, struct sk_buff *skb,
 bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		   unsigned short vid, bool is_bcast)
 {
-	struct batadv_bla_backbone_gw *backbone_gw;
 	struct ethhdr *ethhdr;
-	struct batadv_bla_claim search_claim, *claim = NULL;
+	struct batadv_bla_claim *claim;
 	struct batadv_hard_iface *primary_if;
+	unsigned long now;
+	bool claim_valid;
 	bool own_claim;
 	bool ret;
 
@@ -1850,11 +1979,22 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		if (is_multicast_ether_addr(ethhdr->h_dest) && is_bcast)
 			goto handled;
 
-	ether_addr_copy(search_claim.addr, ethhdr->h_source);
-	search_claim.vid = vid;
-	claim = batadv_claim_hash_find(bat_priv, &search_claim);
+	rcu_read_lock();
+	claim = batadv_bla_claim_lookup_rcu(bat_priv, ethhdr->h_source, vid);
+	own_claim = false;
+	claim_valid = false;
+	if (claim) {
+		own_claim = batadv_bla_claim_is_own_rcu(claim, primary_if,
+							&claim_valid);
 
-	if (!claim) {
+		/* avoid dirtying the shared cache line on every frame */
+		now = jiffies;
+		if (own_claim && claim->lasttime != now)
+			claim->lasttime = now;
+	}
+	rcu_read_unlock();
+
+	if (!claim_valid) {
 		/* possible optimization: race for a claim */
 		/* No claim exists yet, claim it for us!
 		 */
@@ -1872,16 +2012,9 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	}
 
 	/* if it is our own claim ... */
-	backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
-	own_claim = batadv_compare_eth(backbone_gw->orig,
-				       primary_if->net_dev->dev_addr);
-	batadv_backbone_gw_put(backbone_gw);
-
-	if (own_claim) {
+	if (own_claim)
 		/* ... allow it in any case */
-		claim->lasttime = jiffies;
 		goto allow;
-	}
 
 	/* if it is a broadcast ... */
 	if (is_multicast_ether_addr(ethhdr->h_dest) && is_bcast) {
@@ -1914,8 +2047,6 @@ bool batadv_bla_rx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 out:
 	if (primary_if)
 		batadv_hardif_put(primary_if);
-	if (claim)
-		batadv_claim_put(claim);
 	return ret;
 }
 
@@ -1940,10 +2071,11 @@ bool batadv_bla_tx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		   unsigned short vid)
 {
 	struct ethhdr *ethhdr;
-	struct batadv_bla_claim search_claim, *claim = NULL;
-	struct batadv_bla_backbone_gw *backbone_gw;
+	struct batadv_bla_claim *claim;
 	struct batadv_hard_iface *primary_if;
-	bool client_roamed;
+	bool claim_recent = false;
+	bool claim_valid = false;
+	bool client_roamed = false;
 	bool ret = false;
 
 	primary_if = batadv_primary_if_get_selected(bat_priv);
@@ -1963,26 +2095,25 @@ bool batadv_bla_tx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 		if (is_multicast_ether_addr(ethhdr->h_dest))
 			goto handled;
 
-	ether_addr_copy(search_claim.addr, ethhdr->h_source);
-	search_claim.vid = vid;
-
-	claim = batadv_claim_hash_find(bat_priv, &search_claim);
+	rcu_read_lock();
+	claim = batadv_bla_claim_lookup_rcu(bat_priv, ethhdr->h_source, vid);
+	if (claim) {
+		/* check if we are responsible. */
+		client_roamed = batadv_bla_claim_is_own_rcu(claim, primary_if,
+							    &claim_valid);
+		claim_recent = !batadv_has_timed_out(claim->lasttime, 100);
+	}
+	rcu_read_unlock();
 
 	/* if no claim exists, allow it. */
-	if (!claim)
+	if (!claim_valid)
 		goto allow;
 
-	/* check if we are responsible. */
-	backbone_gw = batadv_bla_claim_get_backbone_gw(claim);
-	client_roamed = batadv_compare_eth(backbone_gw->orig,
-					   primary_if->net_dev->dev_addr);
-	batadv_backbone_gw_put(backbone_gw);
-
 	if (client_roamed) {
 		/* if yes, the client has roamed and we have
 		 * to unclaim it.
 		 */
-		if (batadv_has_timed_out(claim->lasttime, 100)) {
+		if (!claim_recent) {
 			/* only unclaim if the last claim entry is
 			 * older than 100 ms to make sure we really
 			 * have a roaming client here.
@@ -2021,8 +2152,6 @@ bool batadv_bla_tx(struct batadv_priv *bat_priv, struct sk_buff *skb,
 out:
 	if (primary_if)
 		batadv_hardif_put(primary_if);
-	if (claim)
-		batadv_claim_put(claim);
 	return ret;
 }
 
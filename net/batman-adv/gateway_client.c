@@ -21,6 +21,7 @@
 
 #include <linux/atomic.h>
 #include <linux/byteorder/generic.h>
+#include <linux/compiler.h>
 #include <linux/errno.h>
 #include <linux/etherdevice.h>
 #include <linux/gfp.h>
@@ -29,10 +30,13 @@
 #include <linux/in.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/jhash.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/lockdep.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/rculist.h>
@@ -150,6 +154,134 @@ batadv_gw_get_selected_orig(struct batadv_priv *bat_priv)
 	return orig_node;
 }
 
+/**
+ * batadv_gw_hash_neg_log2() - Negative binary logarithm of a normalized hash
+ * @hash: 32 bit hash value
+ *
+ * The hash is mapped to x = (hash + 1) / 2^32 in the interval (0, 1].
+ *
+ * Return: -log2(x) in fixed point with BATADV_GW_LOG2_FRAC_BITS fractional
+ *  bits, at least 1
+ */
+static u32 batadv_gw_hash_neg_log2(u32 hash)
+{
+	u64 x = (u64)hash + 1;
+	u32 log2_x, i;
+	u64 m;
+
+	log2_x = ilog2(x) << BATADV_GW_LOG2_FRAC_BITS;
+
+	/* mantissa in [1, 2) as Q31 fixed point */
+	if (ilog2(x) > 31)
+		m = x >> (ilog2(x) - 31);
+	else
+		m = x << (31 - ilog2(x));
+
+	/* squaring the mantissa yields the fractional bits one by one */
+	for (i = 1; i <= BATADV_GW_LOG2_FRAC_BITS; i++) {
+		m = (m * m) >> 31;
+		if (m < (2ULL << 31))
+			continue;
+
+		m >>= 1;
+		log2_x |= 1U << (BATADV_GW_LOG2_FRAC_BITS - i);
+	}
+
+	return max_t(u32, (32U << BATADV_GW_LOG2_FRAC_BITS) - log2_x, 1);
+}
+
+/**
+ * batadv_gw_lb_weight() - Get the load balancing weight of a gateway
+ * @bat_priv: the bat priv with all the soft interface information
+ * @gw_node: the gateway to get the weight of
+ *
+ * The weight provided by the routing algorithm varies with every metric
+ * update. Clients whose scores are close for two gateways would change their
+ * gateway with each of these variations. The weight used for the distribution
+ * therefore only follows changes of more than 1/BATADV_GW_LB_HYSTERESIS.
+ *
+ * Return: the load balancing weight, 0 if the gateway is unusable
+ */
+static u32 batadv_gw_lb_weight(struct batadv_priv *bat_priv,
+			       struct batadv_gw_node *gw_node)
+{
+	u32 weight, lb_weight, band;
+
+	weight = bat_priv->algo_ops->gw.get_lb_weight(bat_priv, gw_node);
+	lb_weight = READ_ONCE(gw_node->lb_weight);
+	band = lb_weight / BATADV_GW_LB_HYSTERESIS;
+
+	if (weight && lb_weight &&
+	    weight >= lb_weight - band && weight <= lb_weight + band)
+		return lb_weight;
+
+	WRITE_ONCE(gw_node->lb_weight, weight);
+
+	return weight;
+}
+
+/**
+ * batadv_gw_get_client_gw_node() - Get the gateway serving a given client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @client: mac address of the client whose DHCP traffic is to be sent
+ *
+ * With gateway load balancing enabled, the clients are distributed over all
+ * gateways by weighted rendezvous hashing: every gateway scores the client
+ * with -w / ln(h), h being the hash of both addresses normalized to (0, 1] and
+ * w the load balancing weight of this gateway. The gateway with the highest
+ * score serves the client. Each gateway thus gets a share of the clients
+ * proportional to its weight, and only the clients of a vanishing gateway
+ * get redistributed.
+ *
+ * Without load balancing (or without any gateway having a weight) the
+ * currently selected gateway is returned.
+ *
+ * Return: gateway node (with increased refcnt), NULL on errors
+ */
+struct batadv_gw_node *
+batadv_gw_get_client_gw_node(struct batadv_priv *bat_priv, const u8 *client)
+{
+	struct batadv_algo_ops *bao = bat_priv->algo_ops;
+	struct batadv_gw_node *gw_node, *client_gw = NULL;
+	u64 score, max_score = 0;
+	u32 client_hash, hash, weight;
+
+	if (!atomic_read(&bat_priv->gw_load_balancing) ||
+	    !bao->gw.get_lb_weight)
+		return batadv_gw_get_selected_gw_node(bat_priv);
+
+	client_hash = jhash(client, ETH_ALEN, 0);
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(gw_node, &bat_priv->gw.gateway_list, list) {
+		weight = batadv_gw_lb_weight(bat_priv, gw_node);
+		if (!weight)
+			continue;
+
+		/* -ln(h) only differs by a constant factor from -log2(h) */
+		hash = jhash(gw_node->orig_node->orig, ETH_ALEN, client_hash);
+		score = div_u64((u64)weight << 32,
+				batadv_gw_hash_neg_log2(hash));
+		if (score <= max_score)
+			continue;
+
+		if (!kref_get_unless_zero(&gw_node->refcount))
+			continue;
+
+		if (client_gw)
+			batadv_gw_node_put(client_gw);
+
+		client_gw = gw_node;
+		max_score = score;
+	}
+	rcu_read_unlock();
+
+	if (!client_gw)
+		return batadv_gw_get_selected_gw_node(bat_priv);
+
+	return client_gw;
+}
+
 static void batadv_gw_select(struct batadv_priv *bat_priv,
 			     struct batadv_gw_node *new_gw_node)
 {
@@ -613,14 +745,104 @@ int batadv_gw_dump(struct sk_buff *msg, struct netlink_callback *cb)
 	return ret;
 }
 
+/**
+ * batadv_gw_dhcp_candidate() - cheaply check whether a packet might be DHCP
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the packet to check
+ * @offset: offset of the ethernet header in the skb
+ *
+ * Only the ethertype, the IP protocol and the UDP ports are looked at. In
+ * contrast to batadv_gw_dhcp_recipient_get() the skb is never reallocated,
+ * which keeps the many other broadcasts (ARP, mDNS, SSDP, ...) cheap.
+ *
+ * Return: true if the packet is a UDP packet from or to a DHCP server port,
+ * false otherwise
+ */
+static bool batadv_gw_dhcp_candidate(struct batadv_priv *bat_priv,
+				     struct sk_buff *skb, unsigned int offset)
+{
+	struct ipv6hdr *ipv6hdr, ipv6hdr_tmp;
+	struct udphdr *udphdr, udphdr_tmp;
+	struct iphdr *iphdr, iphdr_tmp;
+	__be16 *proto, proto_tmp;
+	__be16 server_port;
+	u8 l4proto;
+
+	/* the protocol is stored in the last bytes of the ethernet header */
+	offset += ETH_HLEN;
+	proto = skb_header_pointer(skb, offset - sizeof(proto_tmp),
+				   sizeof(proto_tmp), &proto_tmp);
+	if (!proto)
+		goto other;
+
+	/* ... and of the vlan header */
+	if (*proto == htons(ETH_P_8021Q)) {
+		offset += VLAN_HLEN;
+		proto = skb_header_pointer(skb, offset - sizeof(proto_tmp),
+					   sizeof(proto_tmp), &proto_tmp);
+		if (!proto)
+			goto other;
+	}
+
+	switch (*proto) {
+	case htons(ETH_P_ARP):
+		batadv_inc_counter(bat_priv, BATADV_CNT_GW_CLASS_ARP);
+		return false;
+	case htons(ETH_P_IP):
+		iphdr = skb_header_pointer(skb, offset, sizeof(iphdr_tmp),
+					   &iphdr_tmp);
+		if (!iphdr)
+			goto other;
+
+		l4proto = iphdr->protocol;
+		offset += iphdr->ihl * 4;
+		server_port = htons(67);
+		break;
+	case htons(ETH_P_IPV6):
+		ipv6hdr = skb_header_pointer(skb, offset, sizeof(ipv6hdr_tmp),
+					     &ipv6hdr_tmp);
+		if (!ipv6hdr)
+			goto other;
+
+		l4proto = ipv6hdr->nexthdr;
+		offset += sizeof(*ipv6hdr);
+		server_port = htons(547);
+		break;
+	default:
+		goto other;
+	}
+
+	if (l4proto != IPPROTO_UDP)
+		goto other;
+
+	udphdr = skb_header_pointer(skb, offset, sizeof(udphdr_tmp),
+				    &udphdr_tmp);
+	if (!udphdr)
+		goto other;
+
+	if (udphdr->dest != server_port && udphdr->source != server_port) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_GW_CLASS_UDP);
+		return false;
+	}
+
+	batadv_inc_counter(bat_priv, BATADV_CNT_GW_CLASS_DHCP);
+	return true;
+
+other:
+	batadv_inc_counter(bat_priv, BATADV_CNT_GW_CLASS_OTHER);
+	return false;
+}
+
 /**
  * batadv_gw_dhcp_recipient_get() - check if a packet is a DHCP message
+ * @bat_priv: the bat priv with all the soft interface information
  * @skb: the packet to check
  * @header_len: a pointer to the batman-adv header size
  * @chaddr: buffer where the client address will be stored. Valid
  *  only if the function returns BATADV_DHCP_TO_CLIENT
  *
- * This function may re-allocate the data buffer of the skb passed as argument.
+ * This function may re-allocate the data buffer of the skb passed as argument
+ * if it carries a DHCP message.
  *
  * Return:
  * - BATADV_DHCP_NO if the packet is not a dhcp message or if there was an error
@@ -629,8 +851,8 @@ int batadv_gw_dump(struct sk_buff *msg, struct netlink_callback *cb)
  * - BATADV_DHCP_TO_CLIENT if this is a message going to a DHCP client
  */
 enum batadv_dhcp_recipient
-batadv_gw_dhcp_recipient_get(struct sk_buff *skb, unsigned int *header_len,
-			     u8 *chaddr)
+batadv_gw_dhcp_recipient_get(struct batadv_priv *bat_priv, struct sk_buff *skb,
+			     unsigned int *header_len, u8 *chaddr)
 {
 	enum batadv_dhcp_recipient ret = BATADV_DHCP_NO;
 	struct ethhdr *ethhdr;
@@ -642,6 +864,9 @@ batadv_gw_dhcp_recipient_get(struct sk_buff *skb, unsigned int *header_len,
 	__be16 proto;
 	u8 *p;
 
+	if (!batadv_gw_dhcp_candidate(bat_priv, skb, *header_len))
+		return BATADV_DHCP_NO;
+
 	/* check for ethernet header */
 	if (!pskb_may_pull(skb, *header_len + ETH_HLEN))
 		return BATADV_DHCP_NO;
@@ -784,7 +1009,8 @@ bool batadv_gw_out_of_range(struct batadv_priv *bat_priv,
 		curr_tq_avg = BATADV_TQ_MAX_VALUE;
 		break;
 	case BATADV_GW_MODE_CLIENT:
-		curr_gw = batadv_gw_get_selected_gw_node(bat_priv);
+		curr_gw = batadv_gw_get_client_gw_node(bat_priv,
+						       ethhdr->h_source);
 		if (!curr_gw)
 			goto out;
 
@@ -46,11 +46,11 @@
 #include "distributed-arp-table.h"
 #include "gateway_client.h"
 #include "log.h"
+#include "multicast.h"
 #include "originator.h"
 #include "send.h"
 #include "soft-interface.h"
 #include "sysfs.h"
-#include "translation-table.h"
 
 /**
  * batadv_hardif_release() - release hard interface from lists and queue for
@@ -219,7 +219,7 @@ static bool batadv_is_valid_iface(const struct net_device *net_dev)
  * Return: the 'real' net device or the original net device and NULL in case
  *  of an error.
  */
-static struct net_device *batadv_get_real_netdevice(struct net_device *netdev)
+struct net_device *batadv_get_real_netdevice(struct net_device *netdev)
 {
 	struct batadv_hard_iface *hard_iface = NULL;
 	struct net_device *real_netdev = NULL;
@@ -608,7 +608,7 @@ int batadv_hardif_min_mtu(struct net_device *soft_iface)
 	/* report to the other components the maximum amount of bytes that
 	 * batman-adv can send over the wire (without considering the payload
 	 * overhead). For example, this value is used by TT to compute the
-	 * maximum local table table size
+	 * number of entries fitting in a full table response
 	 */
 	atomic_set(&bat_priv->packet_size_max, min_mtu);
 
@@ -628,11 +628,6 @@ int batadv_hardif_min_mtu(struct net_device *soft_iface)
 void batadv_update_min_mtu(struct net_device *soft_iface)
 {
 	soft_iface->mtu = batadv_hardif_min_mtu(soft_iface);
-
-	/* Check if the local translate table should be cleaned up to match a
-	 * new (and smaller) MTU.
-	 */
-	batadv_tt_local_resize_to_mtu(soft_iface);
 }
 
 static void
@@ -1019,11 +1014,33 @@ static int batadv_hard_if_event_softif(unsigned long event,
 	case NETDEV_CHANGENAME:
 		batadv_debugfs_rename_meshif(net_dev);
 		break;
+	case NETDEV_CHANGEUPPER:
+		/* a bridge on top changes where listeners are collected from */
+		bat_priv = netdev_priv(net_dev);
+		batadv_mcast_mla_schedule(bat_priv);
+		break;
 	}
 
 	return NOTIFY_DONE;
 }
 
+/**
+ * batadv_hardif_link_update() - inform the routing algorithm about a link
+ *  state change of a hard-interface
+ * @hard_iface: the interface whose link state changed
+ */
+static void batadv_hardif_link_update(struct batadv_hard_iface *hard_iface)
+{
+	struct batadv_priv *bat_priv;
+
+	if (hard_iface->if_status == BATADV_IF_NOT_IN_USE)
+		return;
+
+	bat_priv = netdev_priv(hard_iface->soft_iface);
+	if (bat_priv->algo_ops->iface.link_update)
+		bat_priv->algo_ops->iface.link_update(hard_iface);
+}
+
 static int batadv_hard_if_event(struct notifier_block *this,
 				unsigned long event, void *ptr)
 {
@@ -1046,6 +1063,10 @@ static int batadv_hard_if_event(struct notifier_block *this,
 	switch (event) {
 	case NETDEV_UP:
 		batadv_hardif_activate_interface(hard_iface);
+		batadv_hardif_link_update(hard_iface);
+		break;
+	case NETDEV_CHANGE:
+		batadv_hardif_link_update(hard_iface);
 		break;
 	case NETDEV_GOING_DOWN:
 	case NETDEV_DOWN:
@@ -19,6 +19,7 @@
 #include "main.h"
 
 #include <linux/atomic.h>
+#include <linux/bitops.h>
 #include <linux/build_bug.h>
 #include <linux/byteorder/generic.h>
 #include <linux/crc32c.h>
@@ -30,6 +31,7 @@
 #include <linux/init.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/list.h>
@@ -43,6 +45,7 @@
 #include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
+#include <linux/timer.h>
 #include <linux/workqueue.h>
 #include <net/dsfield.h>
 #include <net/rtnetlink.h>
@@ -149,17 +152,19 @@ static void __exit batadv_exit(void)
 int batadv_mesh_init(struct net_device *soft_iface)
 {
 	struct batadv_priv *bat_priv = netdev_priv(soft_iface);
-	int ret;
+	int ret, i;
 
 	spin_lock_init(&bat_priv->forw_bat_list_lock);
 	spin_lock_init(&bat_priv->forw_bcast_list_lock);
 	spin_lock_init(&bat_priv->tt.changes_list_lock);
 	spin_lock_init(&bat_priv->tt.req_list_lock);
 	spin_lock_init(&bat_priv->tt.roam_list_lock);
+	spin_lock_init(&bat_priv->tt.part_tx_lock);
 	spin_lock_init(&bat_priv->tt.last_changeset_lock);
 	spin_lock_init(&bat_priv->tt.commit_lock);
 	spin_lock_init(&bat_priv->gw.list_lock);
 #ifdef CONFIG_BATMAN_ADV_MCAST
+	spin_lock_init(&bat_priv->mcast.mla_lock);
 	spin_lock_init(&bat_priv->mcast.want_lists_lock);
 #endif
 	spin_lock_init(&bat_priv->tvlv.container_list_lock);
@@ -177,12 +182,15 @@ int batadv_mesh_init(struct net_device *soft_iface)
 #endif
 	INIT_LIST_HEAD(&bat_priv->tt.changes_list);
 	INIT_HLIST_HEAD(&bat_priv->tt.req_list);
+	INIT_HLIST_HEAD(&bat_priv->tt.part_tx_list);
 	INIT_LIST_HEAD(&bat_priv->tt.roam_list);
 #ifdef CONFIG_BATMAN_ADV_MCAST
 	INIT_HLIST_HEAD(&bat_priv->mcast.mla_list);
 #endif
 	INIT_HLIST_HEAD(&bat_priv->tvlv.container_list);
 	INIT_HLIST_HEAD(&bat_priv->tvlv.handler_list);
+	for (i = 0; i < ARRAY_SIZE(bat_priv->tvlv.handler_table); i++)
+		INIT_HLIST_HEAD(&bat_priv->tvlv.handler_table[i]);
 	INIT_HLIST_HEAD(&bat_priv->softif_vlan_list);
 	INIT_HLIST_HEAD(&bat_priv->tp_list);
 
@@ -265,6 +273,88 @@ void batadv_mesh_free(struct net_device *soft_iface)
 	atomic_set(&bat_priv->mesh_state, BATADV_MESH_INACTIVE);
 }
 
+/**
+ * batadv_topology_changed() - reset the backed off ELP and OGM intervals
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * The next transmissions use the configured intervals again. Transmissions
+ * which are already scheduled with a backed off interval are brought forward
+ * by the routing algorithm.
+ */
+void batadv_topology_changed(struct batadv_priv *bat_priv)
+{
+	atomic_inc(&bat_priv->topology_gen);
+
+	if (atomic_read(&bat_priv->mesh_state) != BATADV_MESH_ACTIVE)
+		return;
+
+	if (bat_priv->algo_ops->iface.backoff_reset)
+		bat_priv->algo_ops->iface.backoff_reset(bat_priv);
+}
+
+/**
+ * batadv_interval_backoff_reset() - bring a backed off transmission forward
+ * @work: the pending work of the periodic message
+ * @interval: the configured interval in milliseconds
+ *
+ * Reschedules @work to the configured interval if it is pending with a longer
+ * delay. Works which are not pending (yet) are left untouched.
+ */
+void batadv_interval_backoff_reset(struct delayed_work *work,
+				   unsigned int interval)
+{
+	unsigned long delay = msecs_to_jiffies(interval);
+	unsigned long max_expires;
+
+	if (!timer_pending(&work->timer))
+		return;
+
+	/* the jittered configured interval is not a backed off one */
+	max_expires = jiffies + delay + msecs_to_jiffies(BATADV_JITTER);
+	if (time_before_eq(READ_ONCE(work->timer.expires), max_expires))
+		return;
+
+	mod_delayed_work(batadv_event_workqueue, work, delay);
+}
+
+/**
+ * batadv_interval_backoff() - get the interval until the next transmission of
+ *  a periodic routing protocol message
+ * @bat_priv: the bat priv with all the soft interface information
+ * @backoff: the backoff state of the periodic message
+ * @interval: the configured interval in milliseconds
+ *
+ * The interval is doubled with each transmission as long as the topology is
+ * stable, up to the configured interval_backoff limit. Any topology change
+ * since the previous transmission resets it to the configured interval.
+ *
+ * Return: the interval in milliseconds until the next transmission
+ */
+unsigned int batadv_interval_backoff(struct batadv_priv *bat_priv,
+				     struct batadv_interval_backoff *backoff,
+				     unsigned int interval)
+{
+	unsigned int max_level = atomic_read(&bat_priv->interval_backoff);
+	int topology_gen = atomic_read(&bat_priv->topology_gen);
+
+	if (topology_gen != backoff->topology_gen)
+		backoff->level = 0;
+	else if (backoff->level < max_level)
+		backoff->level++;
+
+	backoff->level = min(backoff->level, max_level);
+	backoff->topology_gen = topology_gen;
+
+	if (backoff->level == 0)
+		return interval;
+
+	/* transmissions saved compared to the configured interval */
+	batadv_add_counter(bat_priv, BATADV_CNT_MGMT_TX_SAVED,
+			   BIT(backoff->level) - 1);
+
+	return min_t(u64, (u64)interval << backoff->level, UINT_MAX);
+}
+
 /**
  * batadv_is_my_mac() - check if the given mac address belongs to any of the
  *  real interfaces in the current mesh
@@ -534,6 +624,8 @@ static void batadv_recv_handler_init(void)
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_hdr) != 4);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_gateway_data) != 8);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_tt_vlan_data) != 8);
+	BUILD_BUG_ON(sizeof(struct batadv_tvlv_tt_part) != 4);
+	BUILD_BUG_ON(sizeof(struct batadv_tvlv_tt_compressed) != 4);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_tt_change) != 12);
 	BUILD_BUG_ON(sizeof(struct batadv_tvlv_roam_adv) != 8);
 
@@ -50,6 +50,7 @@
 #define BATADV_TT_WORK_PERIOD 5000 /* 5 seconds */
 #define BATADV_ORIG_WORK_PERIOD 1000 /* 1 second */
 #define BATADV_MCAST_WORK_PERIOD 500 /* 0.5 seconds */
+#define BATADV_MCAST_SLOW_WORK_PERIOD 10000 /* 10 seconds */
 #define BATADV_DAT_ENTRY_TIMEOUT (5 * 60000) /* 5 mins in milliseconds */
 /* sliding packet range of received originator messages in sequence numbers
  * (should be a multiple of our word size)
@@ -57,6 +58,22 @@
 #define BATADV_TQ_LOCAL_WINDOW_SIZE 64
 /* milliseconds we have to keep pending tt_req */
 #define BATADV_TT_REQUEST_TIMEOUT 3000
+/* maximum number of clients in the local translation table */
+#define BATADV_TT_LOCAL_MAX_ENTRIES 131072
+/* no full table split into several TT responses is being received */
+#define BATADV_TT_PART_NONE U32_MAX
+/* parts of a full table sent at once */
+#define BATADV_TT_PART_WINDOW 16
+/* milliseconds between two windows of full table parts */
+#define BATADV_TT_PART_INTERVAL 10
+/* milliseconds to keep a sent full table for resumptions */
+#define BATADV_TT_PART_TX_TIMEOUT 10000
+/* maximum number of full tables being sent in parts at the same time */
+#define BATADV_TT_PART_TX_MAX 16
+/* number of full table entries inserted into the global table at once */
+#define BATADV_TT_BULK_SIZE 64
+/* per cpu cache of global table misses, has to be a power of 2 */
+#define BATADV_TT_MISS_CACHE_SIZE 64
 
 #define BATADV_TQ_GLOBAL_WINDOW_SIZE 5
 #define BATADV_TQ_LOCAL_BIDRECT_SEND_MINIMUM 1
@@ -68,6 +85,8 @@
 #define BATADV_ELP_PROBES_PER_NODE 2
 #define BATADV_ELP_MIN_PROBE_SIZE 200 /* bytes */
 #define BATADV_ELP_PROBE_MAX_TX_DIFF 100 /* milliseconds */
+#define BATADV_ELP_EST_PROBES 4
+#define BATADV_ELP_EST_PROBE_SIZE 1000 /* bytes */
 #define BATADV_ELP_MAX_AGE 64
 #define BATADV_OGM_MAX_ORIGDIFF 5
 #define BATADV_OGM_MAX_AGE 64
@@ -120,6 +139,9 @@
  */
 #define BATADV_MAX_AGGREGATION_BYTES 512
 #define BATADV_MAX_AGGREGATION_MS 100
+/* maximum number of doublings of the ELP and OGM intervals */
+#define BATADV_INTERVAL_BACKOFF_MAX 4
+#define BATADV_IV_AGGR_SLOTS 16
 
 #define BATADV_BLA_PERIOD_LENGTH	10000	/* 10 seconds */
 #define BATADV_BLA_BACKBONE_TIMEOUT	(BATADV_BLA_PERIOD_LENGTH * 6)
@@ -127,6 +149,8 @@
 #define BATADV_BLA_WAIT_PERIODS		3
 #define BATADV_BLA_LOOPDETECT_PERIODS	6
 #define BATADV_BLA_LOOPDETECT_TIMEOUT	3000	/* 3 seconds */
+#define BATADV_BLA_CLAIM_HASH_SIZE	1024
+#define BATADV_BLA_CLAIM_CACHE_SIZE	32	/* has to be a power of 2 */
 
 #define BATADV_DUPLIST_SIZE		16
 #define BATADV_DUPLIST_TIMEOUT		500	/* 500 ms */
@@ -134,13 +158,36 @@
 #define BATADV_RESET_PROTECTION_MS 30000
 #define BATADV_EXPECTED_SEQNO_RANGE	65536
 
+/* one tvlv handler table slot per possible (u8) tvlv type */
+#define BATADV_TVLV_TYPE_NUM		256
+
 #define BATADV_NC_NODE_TIMEOUT 10000 /* Milliseconds */
+#define BATADV_NC_PURGE_INTERVAL 100 /* Milliseconds */
+#define BATADV_NC_MAX_BUFFER_BYTES (4 * 1024 * 1024)
+#define BATADV_NC_MAX_PATH_BYTES (512 * 1024)
 
 /**
  * BATADV_TP_MAX_NUM - maximum number of simultaneously active tp sessions
  */
 #define BATADV_TP_MAX_NUM 5
 
+/**
+ * BATADV_TP_MAX_STREAMS - maximum number of parallel streams of a tp session
+ */
+#define BATADV_TP_MAX_STREAMS 8
+
+/**
+ * BATADV_TP_MAX_PROBE_INTERVAL - maximum interval between two tp meter latency
+ *  probes (in milliseconds)
+ */
+#define BATADV_TP_MAX_PROBE_INTERVAL 1000
+
+/**
+ * BATADV_TP_LAT_BUCKETS - number of buckets of the tp meter latency histogram.
+ *  Every power of two of the (microsecond) RTT range is split in 8 buckets
+ */
+#define BATADV_TP_LAT_BUCKETS 240
+
 /**
  * enum batadv_mesh_state - State of a soft interface
  */
@@ -196,6 +243,11 @@ enum batadv_uev_type {
 
 #define BATADV_GW_THRESHOLD	50
 
+/* Fractional bits of the hash logarithm used for gateway load balancing */
+#define BATADV_GW_LOG2_FRAC_BITS 16
+/* changes of the GW load balancing weight smaller than 1/4 are ignored */
+#define BATADV_GW_LB_HYSTERESIS 4
+
 /* Number of fragment chains for each orig_node */
 #define BATADV_FRAG_BUFFER_COUNT 8
 /* Maximum number of fragments for one packet */
@@ -217,6 +269,7 @@ enum batadv_uev_type {
 
 /* Kernel headers */
 
+#include <linux/atomic.h>
 #include <linux/compiler.h>
 #include <linux/etherdevice.h>
 #include <linux/if_vlan.h>
@@ -254,6 +307,12 @@ extern struct workqueue_struct *batadv_event_workqueue;
 int batadv_mesh_init(struct net_device *soft_iface);
 void batadv_mesh_free(struct net_device *soft_iface);
 bool batadv_is_my_mac(struct batadv_priv *bat_priv, const u8 *addr);
+void batadv_topology_changed(struct batadv_priv *bat_priv);
+void batadv_interval_backoff_reset(struct delayed_work *work,
+				   unsigned int interval);
+unsigned int batadv_interval_backoff(struct batadv_priv *bat_priv,
+				     struct batadv_interval_backoff *backoff,
+				     unsigned int interval);
 struct batadv_hard_iface *
 batadv_seq_print_text_primary_if_get(struct seq_file *seq);
 int batadv_max_header_len(void);
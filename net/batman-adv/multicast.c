@@ -66,6 +66,7 @@
 #include "hash.h"
 #include "log.h"
 #include "netlink.h"
+#include "send.h"
 #include "soft-interface.h"
 #include "translation-table.h"
 #include "tvlv.h"
@@ -78,8 +79,32 @@ static void batadv_mcast_mla_update(struct work_struct *work);
  */
 static void batadv_mcast_start_timer(struct batadv_priv *bat_priv)
 {
+	unsigned int period = BATADV_MCAST_WORK_PERIOD;
+
+	/* Without a bridge on top all listeners are on the soft interface
+	 * and changes to them are signaled by batadv_mcast_mla_schedule().
+	 * The periodic run is only a consistency check then.
+	 */
+	if (bat_priv->mcast.enabled && !bat_priv->mcast.bridged)
+		period = BATADV_MCAST_SLOW_WORK_PERIOD;
+
 	queue_delayed_work(batadv_event_workqueue, &bat_priv->mcast.work,
-			   msecs_to_jiffies(BATADV_MCAST_WORK_PERIOD));
+			   msecs_to_jiffies(period));
+}
+
+/**
+ * batadv_mcast_mla_schedule() - schedule an update of the own MLAs
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Called when the multicast listeners of the soft interface or its upper
+ * devices might have changed. May be called from atomic context.
+ */
+void batadv_mcast_mla_schedule(struct batadv_priv *bat_priv)
+{
+	if (atomic_read(&bat_priv->mesh_state) != BATADV_MESH_ACTIVE)
+		return;
+
+	mod_delayed_work(batadv_event_workqueue, &bat_priv->mcast.work, 0);
 }
 
 /**
@@ -136,6 +161,64 @@ static bool batadv_mcast_addr_is_ipv6(const u8 *addr)
 	return memcmp(prefix, addr, sizeof(prefix)) == 0;
 }
 
+/**
+ * batadv_mcast_mla_find() - find an address in a list
+ * @mcast_addr: the multicast address to search for
+ * @mcast_list: the list with multicast addresses to search in
+ *
+ * Return: the list entry of the given address or NULL if it is not in the
+ * given list.
+ */
+static struct batadv_hw_addr *
+batadv_mcast_mla_find(const u8 *mcast_addr, struct hlist_head *mcast_list)
+{
+	struct batadv_hw_addr *mcast_entry;
+
+	hlist_for_each_entry(mcast_entry, mcast_list, list)
+		if (batadv_compare_eth(mcast_entry->addr, mcast_addr))
+			return mcast_entry;
+
+	return NULL;
+}
+
+/**
+ * batadv_mcast_mla_collect() - note a multicast listener found by a scan
+ * @bat_priv: the bat priv with all the soft interface information
+ * @mcast_addr: the multicast address of the listener
+ * @mcast_list: a list to put addresses into which are not announced yet
+ *
+ * Addresses which are already announced are only marked as still present, so
+ * a scan over unchanged listeners does not allocate anything.
+ *
+ * Return: -ENOMEM on memory allocation error or 0 otherwise.
+ */
+static int batadv_mcast_mla_collect(struct batadv_priv *bat_priv,
+				    const u8 *mcast_addr,
+				    struct hlist_head *mcast_list)
+{
+	struct batadv_hw_addr *mcast_entry;
+
+	mcast_entry = batadv_mcast_mla_find(mcast_addr,
+					    &bat_priv->mcast.mla_list);
+	if (mcast_entry) {
+		mcast_entry->seen = bat_priv->mcast.mla_round;
+		return 0;
+	}
+
+	if (batadv_mcast_mla_find(mcast_addr, mcast_list))
+		return 0;
+
+	mcast_entry = kmalloc(sizeof(*mcast_entry), GFP_ATOMIC);
+	if (!mcast_entry)
+		return -ENOMEM;
+
+	ether_addr_copy(mcast_entry->addr, mcast_addr);
+	mcast_entry->seen = bat_priv->mcast.mla_round;
+	hlist_add_head(&mcast_entry->list, mcast_list);
+
+	return 0;
+}
+
 /**
  * batadv_mcast_mla_softif_get() - get softif multicast listeners
  * @bat_priv: the bat priv with all the soft interface information
@@ -143,8 +226,8 @@ static bool batadv_mcast_addr_is_ipv6(const u8 *addr)
  * @mcast_list: a list to put found addresses into
  *
  * Collects multicast addresses of multicast listeners residing
- * on this kernel on the given soft interface, dev, in
- * the given mcast_list. In general, multicast listeners provided by
+ * on this kernel on the given soft interface, dev, see
+ * batadv_mcast_mla_collect(). In general, multicast listeners provided by
  * your multicast receiving applications run directly on this node.
  *
  * If there is a bridge interface on top of dev, collects from that one
@@ -152,8 +235,7 @@ static bool batadv_mcast_addr_is_ipv6(const u8 *addr)
  * will(/should) register to the bridge interface instead of an
  * enslaved bat0.
  *
- * Return: -ENOMEM on memory allocation error or the number of
- * items added to the mcast_list otherwise.
+ * Return: -ENOMEM on memory allocation error or 0 otherwise.
  */
 static int batadv_mcast_mla_softif_get(struct batadv_priv *bat_priv,
 				       struct net_device *dev,
@@ -163,7 +245,6 @@ static int batadv_mcast_mla_softif_get(struct batadv_priv *bat_priv,
 	bool all_ipv6 = bat_priv->mcast.flags & BATADV_MCAST_WANT_ALL_IPV6;
 	struct net_device *bridge = batadv_mcast_get_bridge(dev);
 	struct netdev_hw_addr *mc_list_entry;
-	struct batadv_hw_addr *new;
 	int ret = 0;
 
 	netif_addr_lock_bh(bridge ? bridge : dev);
@@ -174,15 +255,10 @@ static int batadv_mcast_mla_softif_get(struct batadv_priv *bat_priv,
 		if (all_ipv6 && batadv_mcast_addr_is_ipv6(mc_list_entry->addr))
 			continue;
 
-		new = kmalloc(sizeof(*new), GFP_ATOMIC);
-		if (!new) {
-			ret = -ENOMEM;
+		ret = batadv_mcast_mla_collect(bat_priv, mc_list_entry->addr,
+					       mcast_list);
+		if (ret < 0)
 			break;
-		}
-
-		ether_addr_copy(new->addr, mc_list_entry->addr);
-		hlist_add_head(&new->list, mcast_list);
-		ret++;
 	}
 	netif_addr_unlock_bh(bridge ? bridge : dev);
 
@@ -192,26 +268,6 @@ static int batadv_mcast_mla_softif_get(struct batadv_priv *bat_priv,
 	return ret;
 }
 
-/**
- * batadv_mcast_mla_is_duplicate() - check whether an address is in a list
- * @mcast_addr: the multicast address to check
- * @mcast_list: the list with multicast addresses to search in
- *
- * Return: true if the given address is already in the given list.
- * Otherwise returns false.
- */
-static bool batadv_mcast_mla_is_duplicate(u8 *mcast_addr,
-					  struct hlist_head *mcast_list)
-{
-	struct batadv_hw_addr *mcast_entry;
-
-	hlist_for_each_entry(mcast_entry, mcast_list, list)
-		if (batadv_compare_eth(mcast_entry->addr, mcast_addr))
-			return true;
-
-	return false;
-}
-
 /**
  * batadv_mcast_mla_br_addr_cpy() - copy a bridge multicast address
  * @dst: destination to write to - a multicast MAC address
@@ -244,11 +300,10 @@ static void batadv_mcast_mla_br_addr_cpy(char *dst, const struct br_ip *src)
  *
  * Collects multicast addresses of multicast listeners residing
  * on foreign, non-mesh devices which we gave access to our mesh via
- * a bridge on top of the given soft interface, dev, in the given
- * mcast_list.
+ * a bridge on top of the given soft interface, dev, see
+ * batadv_mcast_mla_collect().
  *
- * Return: -ENOMEM on memory allocation error or the number of
- * items added to the mcast_list otherwise.
+ * Return: -ENOMEM on memory allocation error or 0 otherwise.
  */
 static int batadv_mcast_mla_bridge_get(struct batadv_priv *bat_priv,
 				       struct net_device *dev,
@@ -258,7 +313,6 @@ static int batadv_mcast_mla_bridge_get(struct batadv_priv *bat_priv,
 	bool all_ipv4 = bat_priv->mcast.flags & BATADV_MCAST_WANT_ALL_IPV4;
 	bool all_ipv6 = bat_priv->mcast.flags & BATADV_MCAST_WANT_ALL_IPV6;
 	struct br_ip_list *br_ip_entry, *tmp;
-	struct batadv_hw_addr *new;
 	u8 mcast_addr[ETH_ALEN];
 	int ret;
 
@@ -277,17 +331,10 @@ static int batadv_mcast_mla_bridge_get(struct batadv_priv *bat_priv,
 			continue;
 
 		batadv_mcast_mla_br_addr_cpy(mcast_addr, &br_ip_entry->addr);
-		if (batadv_mcast_mla_is_duplicate(mcast_addr, mcast_list))
-			continue;
-
-		new = kmalloc(sizeof(*new), GFP_ATOMIC);
-		if (!new) {
-			ret = -ENOMEM;
+		ret = batadv_mcast_mla_collect(bat_priv, mcast_addr,
+					       mcast_list);
+		if (ret < 0)
 			break;
-		}
-
-		ether_addr_copy(new->addr, mcast_addr);
-		hlist_add_head(&new->list, mcast_list);
 	}
 
 out:
@@ -319,28 +366,26 @@ static void batadv_mcast_mla_list_free(struct hlist_head *mcast_list)
 /**
  * batadv_mcast_mla_tt_retract() - clean up multicast listener announcements
  * @bat_priv: the bat priv with all the soft interface information
- * @mcast_list: a list of addresses which should _not_ be removed
+ * @all: whether to retract all announcements
  *
  * Retracts the announcement of any multicast listener from the
- * translation table except the ones listed in the given mcast_list.
+ * translation table which was not found by the current scan.
  *
- * If mcast_list is NULL then all are retracted.
+ * If all is true then all are retracted.
  *
- * Do not call outside of the mcast worker! (or cancel mcast worker first)
+ * Caller needs to hold bat_priv->mcast.mla_lock.
  */
 static void batadv_mcast_mla_tt_retract(struct batadv_priv *bat_priv,
-					struct hlist_head *mcast_list)
+					bool all)
 {
 	struct batadv_hw_addr *mcast_entry;
 	struct hlist_node *tmp;
 
-	WARN_ON(delayed_work_pending(&bat_priv->mcast.work));
+	lockdep_assert_held(&bat_priv->mcast.mla_lock);
 
 	hlist_for_each_entry_safe(mcast_entry, tmp, &bat_priv->mcast.mla_list,
 				  list) {
-		if (mcast_list &&
-		    batadv_mcast_mla_is_duplicate(mcast_entry->addr,
-						  mcast_list))
+		if (!all && mcast_entry->seen == bat_priv->mcast.mla_round)
 			continue;
 
 		batadv_tt_local_remove(bat_priv, mcast_entry->addr,
@@ -358,9 +403,10 @@ static void batadv_mcast_mla_tt_retract(struct batadv_priv *bat_priv,
  * @mcast_list: a list of addresses which are going to get added
  *
  * Adds multicast listener announcements from the given mcast_list to the
- * translation table if they have not been added yet.
+ * translation table. The list only contains addresses which are not announced
+ * yet, see batadv_mcast_mla_collect().
  *
- * Do not call outside of the mcast worker! (or cancel mcast worker first)
+ * Caller needs to hold bat_priv->mcast.mla_lock.
  */
 static void batadv_mcast_mla_tt_add(struct batadv_priv *bat_priv,
 				    struct hlist_head *mcast_list)
@@ -368,16 +414,9 @@ static void batadv_mcast_mla_tt_add(struct batadv_priv *bat_priv,
 	struct batadv_hw_addr *mcast_entry;
 	struct hlist_node *tmp;
 
-	WARN_ON(delayed_work_pending(&bat_priv->mcast.work));
-
-	if (!mcast_list)
-		return;
+	lockdep_assert_held(&bat_priv->mcast.mla_lock);
 
 	hlist_for_each_entry_safe(mcast_entry, tmp, mcast_list, list) {
-		if (batadv_mcast_mla_is_duplicate(mcast_entry->addr,
-						  &bat_priv->mcast.mla_list))
-			continue;
-
 		if (!batadv_tt_local_add(bat_priv->soft_iface,
 					 mcast_entry->addr, BATADV_NO_FLAGS,
 					 BATADV_NULL_IFINDEX, BATADV_NO_MARK))
@@ -609,10 +648,12 @@ static bool batadv_mcast_mla_tvlv_update(struct batadv_priv *bat_priv)
  * Updates the own multicast listener announcements in the translation
  * table as well as the own, announced multicast tvlv container.
  *
- * Note that non-conflicting reads and writes to bat_priv->mcast.mla_list
- * in batadv_mcast_mla_tt_retract() and batadv_mcast_mla_tt_add() are
- * ensured by the non-parallel execution of the worker this function
- * belongs to.
+ * Only the difference to the previous run is applied to the translation
+ * table: announced listeners which are still present are marked by the scan,
+ * the unmarked ones get retracted and only new listeners are allocated and
+ * added.
+ *
+ * Caller needs to hold bat_priv->mcast.mla_lock.
  */
 static void __batadv_mcast_mla_update(struct batadv_priv *bat_priv)
 {
@@ -620,6 +661,10 @@ static void __batadv_mcast_mla_update(struct batadv_priv *bat_priv)
 	struct hlist_head mcast_list = HLIST_HEAD_INIT;
 	int ret;
 
+	lockdep_assert_held(&bat_priv->mcast.mla_lock);
+
+	bat_priv->mcast.mla_round++;
+
 	if (!batadv_mcast_mla_tvlv_update(bat_priv))
 		goto update;
 
@@ -632,7 +677,7 @@ static void __batadv_mcast_mla_update(struct batadv_priv *bat_priv)
 		goto out;
 
 update:
-	batadv_mcast_mla_tt_retract(bat_priv, &mcast_list);
+	batadv_mcast_mla_tt_retract(bat_priv, false);
 	batadv_mcast_mla_tt_add(bat_priv, &mcast_list);
 
 out:
@@ -658,7 +703,10 @@ static void batadv_mcast_mla_update(struct work_struct *work)
 	priv_mcast = container_of(delayed_work, struct batadv_priv_mcast, work);
 	bat_priv = container_of(priv_mcast, struct batadv_priv, mcast);
 
+	spin_lock(&bat_priv->mcast.mla_lock);
 	__batadv_mcast_mla_update(bat_priv);
+	spin_unlock(&bat_priv->mcast.mla_lock);
+
 	batadv_mcast_start_timer(bat_priv);
 }
 
@@ -856,18 +904,28 @@ static int batadv_mcast_forw_want_all_ip_count(struct batadv_priv *bat_priv,
 
 /**
  * batadv_mcast_forw_tt_node_get() - get a multicast tt node
- * @bat_priv: the bat priv with all the soft interface information
- * @ethhdr: the ether header containing the multicast destination
+ * @listeners: the global tt entry of the multicast destination
  *
- * Return: an orig_node matching the multicast address provided by ethhdr
- * via a translation table lookup. This increases the returned nodes refcount.
+ * Return: an orig_node announcing the multicast address of the given global
+ * tt entry. This increases the returned nodes refcount.
  */
 static struct batadv_orig_node *
-batadv_mcast_forw_tt_node_get(struct batadv_priv *bat_priv,
-			      struct ethhdr *ethhdr)
+batadv_mcast_forw_tt_node_get(struct batadv_tt_global_entry *listeners)
 {
-	return batadv_transtable_search(bat_priv, NULL, ethhdr->h_dest,
-					BATADV_NO_FLAGS);
+	struct batadv_tt_orig_list_entry *orig_entry;
+	struct batadv_orig_node *orig_node = NULL;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_entry, &listeners->orig_list, list) {
+		if (!kref_get_unless_zero(&orig_entry->orig_node->refcount))
+			continue;
+
+		orig_node = orig_entry->orig_node;
+		break;
+	}
+	rcu_read_unlock();
+
+	return orig_node;
 }
 
 /**
@@ -980,16 +1038,28 @@ batadv_mcast_forw_unsnoop_node_get(struct batadv_priv *bat_priv)
  * @bat_priv: the bat priv with all the soft interface information
  * @skb: The multicast packet to check
  * @orig: an originator to be set to forward the skb to
+ * @listeners: set to the global tt entry of the multicast destination
+ *
+ * The global tt entry of a multicast address is the index of all originators
+ * announcing a listener for it. It is looked up once per packet and, together
+ * with the want-all lists, used for both the forwarding decision and the
+ * recipients of the packet.
  *
  * Return: the forwarding mode as enum batadv_forw_mode and in case of
  * BATADV_FORW_SINGLE set the orig to the single originator the skb
- * should be forwarded to.
+ * should be forwarded to. BATADV_FORW_SOME is returned if the number of
+ * recipients does not exceed the multicast_fanout setting, listeners is set
+ * to the (possibly NULL) global tt entry to pass to batadv_mcast_forw_send()
+ * then. The caller has to release the references of orig and listeners.
  */
 enum batadv_forw_mode
 batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
-		       struct batadv_orig_node **orig)
+		       struct batadv_orig_node **orig,
+		       struct batadv_tt_global_entry **listeners)
 {
 	int ret, tt_count, ip_count, unsnoop_count, total_count;
+	struct batadv_tt_global_entry *tt_global;
+	enum batadv_forw_mode forw_mode;
 	bool is_unsnoopable = false;
 	struct ethhdr *ethhdr;
 
@@ -1001,8 +1071,9 @@ batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
 
 	ethhdr = eth_hdr(skb);
 
-	tt_count = batadv_tt_global_hash_count(bat_priv, ethhdr->h_dest,
+	tt_global = batadv_tt_global_hash_find(bat_priv, ethhdr->h_dest,
 					       BATADV_NO_FLAGS);
+	tt_count = tt_global ? atomic_read(&tt_global->orig_list_count) : 0;
 	ip_count = batadv_mcast_forw_want_all_ip_count(bat_priv, ethhdr);
 	unsnoop_count = !is_unsnoopable ? 0 :
 			atomic_read(&bat_priv->mcast.num_want_all_unsnoopables);
@@ -1012,21 +1083,241 @@ batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
 	switch (total_count) {
 	case 1:
 		if (tt_count)
-			*orig = batadv_mcast_forw_tt_node_get(bat_priv, ethhdr);
+			*orig = batadv_mcast_forw_tt_node_get(tt_global);
 		else if (ip_count)
 			*orig = batadv_mcast_forw_ip_node_get(bat_priv, ethhdr);
 		else if (unsnoop_count)
 			*orig = batadv_mcast_forw_unsnoop_node_get(bat_priv);
 
-		if (*orig)
-			return BATADV_FORW_SINGLE;
+		if (*orig) {
+			forw_mode = BATADV_FORW_SINGLE;
+			break;
+		}
 
 		/* fall through */
 	case 0:
-		return BATADV_FORW_NONE;
+		forw_mode = BATADV_FORW_NONE;
+		break;
 	default:
-		return BATADV_FORW_ALL;
+		/* link-local groups are usually wanted by most nodes and the
+		 * want-all lists may overlap for them, keep flooding those
+		 */
+		if (!unsnoop_count &&
+		    total_count <= atomic_read(&bat_priv->multicast_fanout)) {
+			/* hand the tt entry over to batadv_mcast_forw_send() */
+			*listeners = tt_global;
+			tt_global = NULL;
+			forw_mode = BATADV_FORW_SOME;
+			break;
+		}
+
+		forw_mode = BATADV_FORW_ALL;
+		break;
 	}
+
+	if (tt_global)
+		batadv_tt_global_entry_put(tt_global);
+
+	return forw_mode;
+}
+
+/**
+ * batadv_mcast_forw_send_orig() - send a copy of a multicast packet to an
+ *  originator
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to copy
+ * @vid: the vlan identifier
+ * @orig_node: the originator to send the copy to
+ *
+ * Return: true if the copy was handed to the unicast routing, false if it
+ * could not be allocated.
+ */
+static bool batadv_mcast_forw_send_orig(struct batadv_priv *bat_priv,
+					struct sk_buff *skb,
+					unsigned short vid,
+					struct batadv_orig_node *orig_node)
+{
+	struct sk_buff *newskb;
+
+	newskb = skb_copy(skb, GFP_ATOMIC);
+	if (!newskb)
+		return false;
+
+	batadv_send_skb_unicast(bat_priv, newskb, BATADV_UNICAST, 0,
+				orig_node, vid);
+	batadv_inc_counter(bat_priv, BATADV_CNT_MCAST_FANOUT_UNICAST_TX);
+
+	return true;
+}
+
+/**
+ * batadv_mcast_forw_tt() - forward a packet to multicast listeners
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ * @listeners: the global tt entry of the multicast destination, may be NULL
+ *
+ * Sends copies of a frame with multicast destination to any multicast
+ * listener registered in the translation table.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure, NET_XMIT_SUCCESS
+ * otherwise.
+ */
+static int
+batadv_mcast_forw_tt(struct batadv_priv *bat_priv, struct sk_buff *skb,
+		     unsigned short vid,
+		     struct batadv_tt_global_entry *listeners)
+{
+	struct batadv_tt_orig_list_entry *orig_entry;
+	int ret = NET_XMIT_SUCCESS;
+
+	if (!listeners)
+		return ret;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_entry, &listeners->orig_list, list) {
+		if (!batadv_mcast_forw_send_orig(bat_priv, skb, vid,
+						 orig_entry->orig_node)) {
+			ret = NET_XMIT_DROP;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/**
+ * batadv_mcast_forw_want_all_ipv4() - forward to nodes with want-all-ipv4
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ *
+ * Sends copies of a frame with multicast destination to any node with a
+ * BATADV_MCAST_WANT_ALL_IPV4 flag set.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure, NET_XMIT_SUCCESS
+ * otherwise.
+ */
+static int
+batadv_mcast_forw_want_all_ipv4(struct batadv_priv *bat_priv,
+				struct sk_buff *skb, unsigned short vid)
+{
+	struct batadv_orig_node *orig_node;
+	int ret = NET_XMIT_SUCCESS;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_node,
+				 &bat_priv->mcast.want_all_ipv4_list,
+				 mcast_want_all_ipv4_node) {
+		if (!batadv_mcast_forw_send_orig(bat_priv, skb, vid,
+						 orig_node)) {
+			ret = NET_XMIT_DROP;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/**
+ * batadv_mcast_forw_want_all_ipv6() - forward to nodes with want-all-ipv6
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ *
+ * Sends copies of a frame with multicast destination to any node with a
+ * BATADV_MCAST_WANT_ALL_IPV6 flag set.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure, NET_XMIT_SUCCESS
+ * otherwise.
+ */
+static int
+batadv_mcast_forw_want_all_ipv6(struct batadv_priv *bat_priv,
+				struct sk_buff *skb, unsigned short vid)
+{
+	struct batadv_orig_node *orig_node;
+	int ret = NET_XMIT_SUCCESS;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(orig_node,
+				 &bat_priv->mcast.want_all_ipv6_list,
+				 mcast_want_all_ipv6_node) {
+		if (!batadv_mcast_forw_send_orig(bat_priv, skb, vid,
+						 orig_node)) {
+			ret = NET_XMIT_DROP;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/**
+ * batadv_mcast_forw_want_all() - forward packet to nodes in a want-all list
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ *
+ * Sends copies of a frame with multicast destination to any node with a
+ * BATADV_MCAST_WANT_ALL_IPV4 or BATADV_MCAST_WANT_ALL_IPV6 flag set, depending
+ * on the protocol family of the frame.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure or if the protocol family
+ * is neither IPv4 nor IPv6. NET_XMIT_SUCCESS otherwise.
+ */
+static int
+batadv_mcast_forw_want_all(struct batadv_priv *bat_priv,
+			   struct sk_buff *skb, unsigned short vid)
+{
+	switch (ntohs(eth_hdr(skb)->h_proto)) {
+	case ETH_P_IP:
+		return batadv_mcast_forw_want_all_ipv4(bat_priv, skb, vid);
+	case ETH_P_IPV6:
+		return batadv_mcast_forw_want_all_ipv6(bat_priv, skb, vid);
+	default:
+		/* we shouldn't be here... */
+		return NET_XMIT_DROP;
+	}
+}
+
+/**
+ * batadv_mcast_forw_send() - send packet to any detected multicast recipient
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the multicast packet to transmit
+ * @vid: the vlan identifier
+ * @listeners: the global tt entry provided by batadv_mcast_forw_mode()
+ *
+ * Sends copies of a frame with multicast destination to any node that signaled
+ * interest in it, that is either via the translation table or the according
+ * want-all flags. The original skb is consumed in any case.
+ *
+ * Return: NET_XMIT_DROP on memory allocation failure or if the protocol family
+ * is neither IPv4 nor IPv6. NET_XMIT_SUCCESS otherwise.
+ */
+int batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+			   unsigned short vid,
+			   struct batadv_tt_global_entry *listeners)
+{
+	int ret;
+
+	ret = batadv_mcast_forw_tt(bat_priv, skb, vid, listeners);
+	if (ret != NET_XMIT_SUCCESS) {
+		kfree_skb(skb);
+		return ret;
+	}
+
+	ret = batadv_mcast_forw_want_all(bat_priv, skb, vid);
+	if (ret != NET_XMIT_SUCCESS) {
+		kfree_skb(skb);
+		return ret;
+	}
+
+	batadv_inc_counter(bat_priv, BATADV_CNT_MCAST_FANOUT_TX);
+	consume_skb(skb);
+	return ret;
 }
 
 /**
@@ -1563,13 +1854,21 @@ int batadv_mcast_flags_dump(struct sk_buff *msg, struct netlink_callback *cb)
  */
 void batadv_mcast_free(struct batadv_priv *bat_priv)
 {
+	/* batadv_mcast_mla_schedule() is called with the addr lock of the
+	 * soft interface held: wait for callers which did not notice the
+	 * deactivation of the mesh yet before canceling the worker
+	 */
+	netif_addr_lock_bh(bat_priv->soft_iface);
+	netif_addr_unlock_bh(bat_priv->soft_iface);
+
 	cancel_delayed_work_sync(&bat_priv->mcast.work);
 
 	batadv_tvlv_container_unregister(bat_priv, BATADV_TVLV_MCAST, 2);
 	batadv_tvlv_handler_unregister(bat_priv, BATADV_TVLV_MCAST, 2);
 
-	/* safely calling outside of worker, as worker was canceled above */
-	batadv_mcast_mla_tt_retract(bat_priv, NULL);
+	spin_lock(&bat_priv->mcast.mla_lock);
+	batadv_mcast_mla_tt_retract(bat_priv, true);
+	spin_unlock(&bat_priv->mcast.mla_lock);
 }
 
 /**
@@ -21,9 +21,11 @@
 
 #include "main.h"
 
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+
 struct netlink_callback;
 struct seq_file;
-struct sk_buff;
 
 /**
  * enum batadv_forw_mode - the way a packet should be forwarded as
@@ -41,6 +43,13 @@ enum batadv_forw_mode {
 	 */
 	BATADV_FORW_SINGLE,
 
+	/**
+	 * @BATADV_FORW_SOME: forward the packet to some nodes (currently via
+	 *  a multicast-to-unicast conversion and the BATMAN unicast routing
+	 *  protocol)
+	 */
+	BATADV_FORW_SOME,
+
 	/** @BATADV_FORW_NONE: don't forward, drop it */
 	BATADV_FORW_NONE,
 };
@@ -49,7 +58,14 @@ enum batadv_forw_mode {
 
 enum batadv_forw_mode
 batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
-		       struct batadv_orig_node **mcast_single_orig);
+		       struct batadv_orig_node **mcast_single_orig,
+		       struct batadv_tt_global_entry **mcast_listeners);
+
+int batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+			   unsigned short vid,
+			   struct batadv_tt_global_entry *mcast_listeners);
+
+void batadv_mcast_mla_schedule(struct batadv_priv *bat_priv);
 
 void batadv_mcast_init(struct batadv_priv *bat_priv);
 
@@ -68,11 +84,25 @@ void batadv_mcast_purge_orig(struct batadv_orig_node *orig_node);
 
 static inline enum batadv_forw_mode
 batadv_mcast_forw_mode(struct batadv_priv *bat_priv, struct sk_buff *skb,
-		       struct batadv_orig_node **mcast_single_orig)
+		       struct batadv_orig_node **mcast_single_orig,
+		       struct batadv_tt_global_entry **mcast_listeners)
 {
 	return BATADV_FORW_ALL;
 }
 
+static inline int
+batadv_mcast_forw_send(struct batadv_priv *bat_priv, struct sk_buff *skb,
+		       unsigned short vid,
+		       struct batadv_tt_global_entry *mcast_listeners)
+{
+	kfree_skb(skb);
+	return NET_XMIT_DROP;
+}
+
+static inline void batadv_mcast_mla_schedule(struct batadv_priv *bat_priv)
+{
+}
+
 static inline int batadv_mcast_init(struct batadv_priv *bat_priv)
 {
 	return 0;
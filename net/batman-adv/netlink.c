@@ -49,6 +49,7 @@
 #include "gateway_client.h"
 #include "hard-interface.h"
 #include "multicast.h"
+#include "network-coding.h"
 #include "originator.h"
 #include "soft-interface.h"
 #include "tp_meter.h"
@@ -104,6 +105,24 @@ static const struct nla_policy batadv_netlink_policy[NUM_BATADV_ATTR] = {
 	[BATADV_ATTR_DAT_CACHE_VID]		= { .type = NLA_U16 },
 	[BATADV_ATTR_MCAST_FLAGS]		= { .type = NLA_U32 },
 	[BATADV_ATTR_MCAST_FLAGS_PRIV]		= { .type = NLA_U32 },
+	[BATADV_ATTR_NC_BUFFER_BYTES]		= { .type = NLA_U32 },
+	[BATADV_ATTR_NC_BUFFER_EVICT]		= { .type = NLA_U64 },
+	[BATADV_ATTR_NC_DECODE]			= { .type = NLA_U64 },
+	[BATADV_ATTR_NC_DECODE_FAILED]		= { .type = NLA_U64 },
+	[BATADV_ATTR_THROUGHPUT_EST]		= { .type = NLA_U32 },
+	[BATADV_ATTR_THROUGHPUT_EST_SAMPLES]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_STREAMS]		= { .type = NLA_U8 },
+	[BATADV_ATTR_TPMETER_STREAM]		= { .type = NLA_U8 },
+	[BATADV_ATTR_TPMETER_PROBE_INTERVAL]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_PROBES_SENT]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_PROBES_LOST]	= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_MIN]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_AVG]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_P50]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_P99]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_RTT_MAX]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_JITTER]		= { .type = NLA_U32 },
+	[BATADV_ATTR_TPMETER_CC]		= { .type = NLA_U8 },
 };
 
 /**
@@ -157,6 +176,9 @@ batadv_netlink_mesh_info_put(struct sk_buff *msg, struct net_device *soft_iface)
 	if (batadv_mcast_mesh_info_put(msg, bat_priv))
 		goto out;
 
+	if (batadv_nc_mesh_info_put(msg, bat_priv))
+		goto out;
+
 	primary_if = batadv_primary_if_get_selected(bat_priv);
 	if (primary_if && primary_if->if_status == BATADV_IF_ACTIVE) {
 		hard_iface = primary_if->net_dev;
@@ -256,6 +278,45 @@ batadv_netlink_tp_meter_put(struct sk_buff *msg, u32 cookie)
 	return 0;
 }
 
+/**
+ * batadv_netlink_tp_meter_latency_put() - Fill latency result of a tp_meter
+ *  session
+ * @msg: netlink message to be sent
+ * @latency: result of the latency probes
+ *
+ * Return: 0 on success, < 0 on error
+ */
+static int
+batadv_netlink_tp_meter_latency_put(struct sk_buff *msg,
+				    const struct batadv_tp_lat_result *latency)
+{
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_PROBES_SENT, latency->sent))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_PROBES_LOST, latency->lost))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_MIN, latency->min))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_AVG, latency->avg))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_P50, latency->p50))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_P99, latency->p99))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_RTT_MAX, latency->max))
+		return -EMSGSIZE;
+
+	if (nla_put_u32(msg, BATADV_ATTR_TPMETER_JITTER, latency->jitter))
+		return -EMSGSIZE;
+
+	return 0;
+}
+
 /**
  * batadv_netlink_tpmeter_notify() - send tp_meter result via netlink to client
  * @bat_priv: the bat priv with all the soft interface information
@@ -264,12 +325,17 @@ batadv_netlink_tp_meter_put(struct sk_buff *msg, u32 cookie)
  * @test_time: total time ot the tp_meter session
  * @total_bytes: bytes acked to the receiver
  * @cookie: cookie of tp_meter session
+ * @num_streams: number of parallel streams of the tp_meter session
+ * @stream: index (starting at 1) of the stream this result belongs to, 0 for
+ *  the result of the whole session
+ * @latency: result of the latency probes, NULL when not available
  *
  * Return: 0 on success, < 0 on error
  */
 int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
 				  u8 result, u32 test_time, u64 total_bytes,
-				  u32 cookie)
+				  u32 cookie, u8 num_streams, u8 stream,
+				  const struct batadv_tp_lat_result *latency)
 {
 	struct sk_buff *msg;
 	void *hdr;
@@ -302,6 +368,16 @@ int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
 	if (nla_put(msg, BATADV_ATTR_ORIG_ADDRESS, ETH_ALEN, dst))
 		goto nla_put_failure;
 
+	if (num_streams > 1 &&
+	    nla_put_u8(msg, BATADV_ATTR_TPMETER_STREAMS, num_streams))
+		goto nla_put_failure;
+
+	if (stream && nla_put_u8(msg, BATADV_ATTR_TPMETER_STREAM, stream))
+		goto nla_put_failure;
+
+	if (latency && batadv_netlink_tp_meter_latency_put(msg, latency))
+		goto nla_put_failure;
+
 	genlmsg_end(msg, hdr);
 
 	genlmsg_multicast_netns(&batadv_netlink_family,
@@ -333,6 +409,10 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 	struct net_device *soft_iface;
 	struct batadv_priv *bat_priv;
 	struct sk_buff *msg = NULL;
+	struct nlattr *attr;
+	u8 cc = BATADV_TP_CC_RENO;
+	u32 probe_interval = 0;
+	u8 num_streams = 1;
 	u32 test_length;
 	void *msg_head;
 	int ifindex;
@@ -357,6 +437,32 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 
 	test_length = nla_get_u32(info->attrs[BATADV_ATTR_TPMETER_TEST_TIME]);
 
+	attr = info->attrs[BATADV_ATTR_TPMETER_PROBE_INTERVAL];
+	if (attr) {
+		probe_interval = nla_get_u32(attr);
+		if (probe_interval < 1 ||
+		    probe_interval > BATADV_TP_MAX_PROBE_INTERVAL)
+			return -EINVAL;
+	}
+
+	attr = info->attrs[BATADV_ATTR_TPMETER_STREAMS];
+	if (attr) {
+		num_streams = nla_get_u8(attr);
+		if (num_streams > BATADV_TP_MAX_STREAMS)
+			return -EINVAL;
+
+		/* a session without streams can only measure the latency */
+		if (!num_streams && !probe_interval)
+			return -EINVAL;
+	}
+
+	attr = info->attrs[BATADV_ATTR_TPMETER_CC];
+	if (attr) {
+		cc = nla_get_u8(attr);
+		if (cc > BATADV_TP_CC_MAX)
+			return -EINVAL;
+	}
+
 	soft_iface = dev_get_by_index(net, ifindex);
 	if (!soft_iface || !batadv_softif_is_valid(soft_iface)) {
 		ret = -ENODEV;
@@ -378,7 +484,8 @@ batadv_netlink_tp_meter_start(struct sk_buff *skb, struct genl_info *info)
 	}
 
 	bat_priv = netdev_priv(soft_iface);
-	batadv_tp_start(bat_priv, dst, test_length, &cookie);
+	batadv_tp_start(bat_priv, dst, test_length, num_streams, probe_interval,
+			cc, &cookie);
 
 	ret = batadv_netlink_tp_meter_put(msg, cookie);
 
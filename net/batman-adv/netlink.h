@@ -32,7 +32,8 @@ int batadv_netlink_get_ifindex(const struct nlmsghdr *nlh, int attrtype);
 
 int batadv_netlink_tpmeter_notify(struct batadv_priv *bat_priv, const u8 *dst,
 				  u8 result, u32 test_time, u64 total_bytes,
-				  u32 cookie);
+				  u32 cookie, u8 num_streams, u8 stream,
+				  const struct batadv_tp_lat_result *latency);
 
 extern struct genl_family batadv_netlink_family;
 
@@ -38,6 +38,7 @@
 #include <linux/lockdep.h>
 #include <linux/net.h>
 #include <linux/netdevice.h>
+#include <linux/netlink.h>
 #include <linux/printk.h>
 #include <linux/random.h>
 #include <linux/rculist.h>
@@ -49,7 +50,10 @@
 #include <linux/stddef.h>
 #include <linux/string.h>
 #include <linux/workqueue.h>
+#include <asm/unaligned.h>
+#include <net/netlink.h>
 #include <uapi/linux/batadv_packet.h>
+#include <uapi/linux/batman_adv.h>
 
 #include "hard-interface.h"
 #include "hash.h"
@@ -57,6 +61,7 @@
 #include "originator.h"
 #include "routing.h"
 #include "send.h"
+#include "soft-interface.h"
 #include "tvlv.h"
 
 static struct lock_class_key batadv_nc_coding_hash_lock_class_key;
@@ -89,7 +94,7 @@ int __init batadv_nc_init(void)
 static void batadv_nc_start_timer(struct batadv_priv *bat_priv)
 {
 	queue_delayed_work(batadv_event_workqueue, &bat_priv->nc.work,
-			   msecs_to_jiffies(10));
+			   msecs_to_jiffies(BATADV_NC_PURGE_INTERVAL));
 }
 
 /**
@@ -153,9 +158,6 @@ static void batadv_nc_tvlv_ogm_handler_v1(struct batadv_priv *bat_priv,
  */
 int batadv_nc_mesh_init(struct batadv_priv *bat_priv)
 {
-	bat_priv->nc.timestamp_fwd_flush = jiffies;
-	bat_priv->nc.timestamp_sniffed_purge = jiffies;
-
 	if (bat_priv->nc.coding_hash || bat_priv->nc.decoding_hash)
 		return 0;
 
@@ -196,6 +198,11 @@ void batadv_nc_init_bat_priv(struct batadv_priv *bat_priv)
 	bat_priv->nc.min_tq = 200;
 	bat_priv->nc.max_fwd_delay = 10;
 	bat_priv->nc.max_buffer_time = 200;
+	bat_priv->nc.max_buffer_bytes = BATADV_NC_MAX_BUFFER_BYTES;
+	bat_priv->nc.max_path_bytes = BATADV_NC_MAX_PATH_BYTES;
+	atomic_set(&bat_priv->nc.decoding_bytes, 0);
+	INIT_LIST_HEAD(&bat_priv->nc.decoding_lru);
+	spin_lock_init(&bat_priv->nc.decoding_lru_lock);
 }
 
 /**
@@ -276,6 +283,90 @@ static void batadv_nc_packet_free(struct batadv_nc_packet *nc_packet,
 	kfree(nc_packet);
 }
 
+/**
+ * batadv_nc_packet_unlink() - remove an nc packet from the queues it is on
+ * @nc_packet: the nc packet to remove
+ *
+ * Has to be called with the packet list lock of the nc path held.
+ */
+static void batadv_nc_packet_unlink(struct batadv_nc_packet *nc_packet)
+{
+	struct batadv_nc_path *nc_path = nc_packet->nc_path;
+	struct batadv_priv_nc *priv_nc = &nc_path->bat_priv->nc;
+
+	lockdep_assert_held(&nc_path->packet_list_lock);
+
+	list_del(&nc_packet->list);
+
+	/* only packets buffered for decoding are accounted */
+	if (list_empty(&nc_packet->lru_list))
+		return;
+
+	spin_lock_bh(&priv_nc->decoding_lru_lock);
+	list_del_init(&nc_packet->lru_list);
+	spin_unlock_bh(&priv_nc->decoding_lru_lock);
+
+	nc_path->buffer_bytes -= nc_packet->size;
+	atomic_sub(nc_packet->size, &priv_nc->decoding_bytes);
+}
+
+/**
+ * batadv_nc_decoding_evict() - make room in the decoding buffer
+ * @bat_priv: the bat priv with all the soft interface information
+ * @size: number of bytes which are about to be added to the buffer
+ *
+ * Drops the least recently buffered packets, regardless of their nc path,
+ * until the buffer can hold another @size bytes without exceeding
+ * max_buffer_bytes.
+ */
+static void batadv_nc_decoding_evict(struct batadv_priv *bat_priv,
+				     unsigned int size)
+{
+	struct batadv_priv_nc *priv_nc = &bat_priv->nc;
+	struct batadv_nc_packet *nc_packet;
+	struct batadv_nc_path *nc_path;
+
+	while (atomic_read(&priv_nc->decoding_bytes) + size >
+	       priv_nc->max_buffer_bytes) {
+		spin_lock_bh(&priv_nc->decoding_lru_lock);
+		if (list_empty(&priv_nc->decoding_lru)) {
+			spin_unlock_bh(&priv_nc->decoding_lru_lock);
+			return;
+		}
+
+		/* the buffered packet holds a reference on its path */
+		nc_packet = list_first_entry(&priv_nc->decoding_lru,
+					     struct batadv_nc_packet, lru_list);
+		nc_path = nc_packet->nc_path;
+		kref_get(&nc_path->refcount);
+		spin_unlock_bh(&priv_nc->decoding_lru_lock);
+
+		/* The path lock has to be taken before the lru lock. The oldest
+		 * packet may have been consumed in the meantime, but the oldest
+		 * packet of a locked path cannot change anymore.
+		 */
+		spin_lock_bh(&nc_path->packet_list_lock);
+		spin_lock_bh(&priv_nc->decoding_lru_lock);
+		nc_packet = list_first_entry_or_null(&priv_nc->decoding_lru,
+						     struct batadv_nc_packet,
+						     lru_list);
+		if (nc_packet && nc_packet->nc_path != nc_path)
+			nc_packet = NULL;
+		spin_unlock_bh(&priv_nc->decoding_lru_lock);
+
+		if (nc_packet)
+			batadv_nc_packet_unlink(nc_packet);
+		spin_unlock_bh(&nc_path->packet_list_lock);
+		batadv_nc_path_put(nc_path);
+
+		if (!nc_packet)
+			continue;
+
+		batadv_nc_packet_free(nc_packet, true);
+		batadv_inc_counter(bat_priv, BATADV_CNT_NC_BUFFER_EVICT);
+	}
+}
+
 /**
  * batadv_nc_to_purge_nc_node() - checks whether an nc node has to be purged
  * @bat_priv: the bat priv with all the soft interface information
@@ -439,6 +530,7 @@ static void batadv_nc_purge_paths(struct batadv_priv *bat_priv,
 				  bool (*to_purge)(struct batadv_priv *,
 						   struct batadv_nc_path *))
 {
+	struct hlist_head unlinked = HLIST_HEAD_INIT;
 	struct hlist_head *head;
 	struct hlist_node *node_tmp;
 	struct batadv_nc_path *nc_path;
@@ -477,10 +569,22 @@ static void batadv_nc_purge_paths(struct batadv_priv *bat_priv,
 				   "Remove nc_path %pM -> %pM\n",
 				   nc_path->prev_hop, nc_path->next_hop);
 			hlist_del_rcu(&nc_path->hash_entry);
-			batadv_nc_path_put(nc_path);
+			hlist_add_head(&nc_path->cleanup_list, &unlinked);
 		}
 		spin_unlock_bh(lock);
 	}
+
+	/* the timeout work of an unlinked path may still be pending and must
+	 * not run after the mesh was freed
+	 */
+	hlist_for_each_entry_safe(nc_path, node_tmp, &unlinked, cleanup_list) {
+		hlist_del(&nc_path->cleanup_list);
+
+		if (cancel_delayed_work_sync(&nc_path->timeout_work))
+			batadv_nc_path_put(nc_path);
+
+		batadv_nc_path_put(nc_path);
+	}
 }
 
 /**
@@ -618,7 +722,7 @@ static bool batadv_nc_sniffed_purge(struct batadv_priv *bat_priv,
 		goto out;
 
 	/* purge nc packet */
-	list_del(&nc_packet->list);
+	batadv_nc_packet_unlink(nc_packet);
 	batadv_nc_packet_free(nc_packet, true);
 
 	res = true;
@@ -659,55 +763,159 @@ static bool batadv_nc_fwd_flush(struct batadv_priv *bat_priv,
 	batadv_inc_counter(bat_priv, BATADV_CNT_FORWARD);
 	batadv_add_counter(bat_priv, BATADV_CNT_FORWARD_BYTES,
 			   nc_packet->skb->len + ETH_HLEN);
-	list_del(&nc_packet->list);
+	batadv_nc_packet_unlink(nc_packet);
 	batadv_nc_send_packet(nc_packet);
 
 	return true;
 }
 
 /**
- * batadv_nc_process_nc_paths() - traverse given nc packet pool and free timed
- *  out nc packets
- * @bat_priv: the bat priv with all the soft interface information
- * @hash: to be processed hash table
+ * batadv_nc_path_schedule() - arm the timeout work of an nc path
+ * @nc_path: the nc path to arm the timeout work for
+ * @timeout: buffering time of packets on this path in milliseconds
+ *
+ * Packets are added to the tail of the packet list, so the oldest packet
+ * always sits at its head and determines when the path has to be looked at
+ * again. Has to be called with the appropriate locks.
+ */
+static void batadv_nc_path_schedule(struct batadv_nc_path *nc_path,
+				    u32 timeout)
+{
+	struct batadv_nc_packet *nc_packet;
+	unsigned long deadline;
+	unsigned long delay = 0;
+
+	lockdep_assert_held(&nc_path->packet_list_lock);
+
+	if (list_empty(&nc_path->packet_list))
+		return;
+
+	nc_packet = list_first_entry(&nc_path->packet_list,
+				     struct batadv_nc_packet, list);
+
+	/* batadv_has_timed_out() only triggers one jiffy after the deadline */
+	deadline = nc_packet->timestamp + msecs_to_jiffies(timeout) + 1;
+	if (time_after(deadline, jiffies))
+		delay = deadline - jiffies;
+
+	kref_get(&nc_path->refcount);
+	if (!queue_delayed_work(batadv_event_workqueue, &nc_path->timeout_work,
+				delay))
+		batadv_nc_path_put(nc_path);
+}
+
+/**
+ * batadv_nc_path_process() - process the timed out packets of an nc path
+ * @nc_path: the nc path to process
+ * @timeout: buffering time of packets on this path in milliseconds
  * @process_fn: Function called to process given nc packet. Should return true
  *	        to encourage this function to proceed with the next packet.
  *	        Otherwise the rest of the current queue is skipped.
  */
 static void
-batadv_nc_process_nc_paths(struct batadv_priv *bat_priv,
-			   struct batadv_hashtable *hash,
-			   bool (*process_fn)(struct batadv_priv *,
-					      struct batadv_nc_path *,
-					      struct batadv_nc_packet *))
+batadv_nc_path_process(struct batadv_nc_path *nc_path, u32 timeout,
+		       bool (*process_fn)(struct batadv_priv *,
+					  struct batadv_nc_path *,
+					  struct batadv_nc_packet *))
 {
-	struct hlist_head *head;
 	struct batadv_nc_packet *nc_packet, *nc_packet_tmp;
-	struct batadv_nc_path *nc_path;
 	bool ret;
-	int i;
+
+	spin_lock_bh(&nc_path->packet_list_lock);
+	list_for_each_entry_safe(nc_packet, nc_packet_tmp,
+				 &nc_path->packet_list, list) {
+		ret = process_fn(nc_path->bat_priv, nc_path, nc_packet);
+		if (!ret)
+			break;
+	}
+
+	batadv_nc_path_schedule(nc_path, timeout);
+	spin_unlock_bh(&nc_path->packet_list_lock);
+}
+
+/**
+ * batadv_nc_fwd_flush_work() - send the coding packets of an nc path which
+ *  waited max_fwd_delay without finding a coding partner
+ * @work: kernel work struct
+ */
+static void batadv_nc_fwd_flush_work(struct work_struct *work)
+{
+	struct delayed_work *delayed_work;
+	struct batadv_nc_path *nc_path;
+
+	delayed_work = to_delayed_work(work);
+	nc_path = container_of(delayed_work, struct batadv_nc_path,
+			       timeout_work);
+
+	batadv_nc_path_process(nc_path, nc_path->bat_priv->nc.max_fwd_delay,
+			       batadv_nc_fwd_flush);
+	batadv_nc_path_put(nc_path);
+}
+
+/**
+ * batadv_nc_sniffed_purge_work() - drop the decoding packets of an nc path
+ *  which were buffered for max_buffer_time
+ * @work: kernel work struct
+ */
+static void batadv_nc_sniffed_purge_work(struct work_struct *work)
+{
+	struct delayed_work *delayed_work;
+	struct batadv_nc_path *nc_path;
+
+	delayed_work = to_delayed_work(work);
+	nc_path = container_of(delayed_work, struct batadv_nc_path,
+			       timeout_work);
+
+	batadv_nc_path_process(nc_path, nc_path->bat_priv->nc.max_buffer_time,
+			       batadv_nc_sniffed_purge);
+	batadv_nc_path_put(nc_path);
+}
+
+/**
+ * batadv_nc_flush_paths() - cancel the timeout work of all nc paths and drop
+ *  their buffered packets
+ * @bat_priv: the bat priv with all the soft interface information
+ * @hash: hash table containing the nc paths to flush
+ */
+static void batadv_nc_flush_paths(struct batadv_priv *bat_priv,
+				  struct batadv_hashtable *hash)
+{
+	struct batadv_nc_packet *nc_packet, *nc_packet_tmp;
+	struct hlist_node *node_tmp;
+	struct batadv_nc_path *nc_path;
+	struct hlist_head head = HLIST_HEAD_INIT;
+	spinlock_t *lock; /* Protects lists in hash */
+	u32 i;
 
 	if (!hash)
 		return;
 
-	/* Loop hash table bins */
 	for (i = 0; i < hash->size; i++) {
-		head = &hash->table[i];
+		lock = &hash->list_locks[i];
 
-		/* Loop coding paths */
-		rcu_read_lock();
-		hlist_for_each_entry_rcu(nc_path, head, hash_entry) {
-			/* Loop packets */
-			spin_lock_bh(&nc_path->packet_list_lock);
-			list_for_each_entry_safe(nc_packet, nc_packet_tmp,
-						 &nc_path->packet_list, list) {
-				ret = process_fn(bat_priv, nc_path, nc_packet);
-				if (!ret)
-					break;
-			}
-			spin_unlock_bh(&nc_path->packet_list_lock);
+		spin_lock_bh(lock);
+		hlist_for_each_entry(nc_path, &hash->table[i], hash_entry) {
+			kref_get(&nc_path->refcount);
+			hlist_add_head(&nc_path->cleanup_list, &head);
 		}
-		rcu_read_unlock();
+		spin_unlock_bh(lock);
+	}
+
+	hlist_for_each_entry_safe(nc_path, node_tmp, &head, cleanup_list) {
+		hlist_del(&nc_path->cleanup_list);
+
+		if (cancel_delayed_work_sync(&nc_path->timeout_work))
+			batadv_nc_path_put(nc_path);
+
+		spin_lock_bh(&nc_path->packet_list_lock);
+		list_for_each_entry_safe(nc_packet, nc_packet_tmp,
+					 &nc_path->packet_list, list) {
+			batadv_nc_packet_unlink(nc_packet);
+			batadv_nc_packet_free(nc_packet, true);
+		}
+		spin_unlock_bh(&nc_path->packet_list_lock);
+
+		batadv_nc_path_put(nc_path);
 	}
 }
 
@@ -721,7 +929,6 @@ static void batadv_nc_worker(struct work_struct *work)
 	struct delayed_work *delayed_work;
 	struct batadv_priv_nc *priv_nc;
 	struct batadv_priv *bat_priv;
-	unsigned long timeout;
 
 	delayed_work = to_delayed_work(work);
 	priv_nc = container_of(delayed_work, struct batadv_priv_nc, work);
@@ -733,66 +940,10 @@ static void batadv_nc_worker(struct work_struct *work)
 	batadv_nc_purge_paths(bat_priv, bat_priv->nc.decoding_hash,
 			      batadv_nc_to_purge_nc_path_decoding);
 
-	timeout = bat_priv->nc.max_fwd_delay;
-
-	if (batadv_has_timed_out(bat_priv->nc.timestamp_fwd_flush, timeout)) {
-		batadv_nc_process_nc_paths(bat_priv, bat_priv->nc.coding_hash,
-					   batadv_nc_fwd_flush);
-		bat_priv->nc.timestamp_fwd_flush = jiffies;
-	}
-
-	if (batadv_has_timed_out(bat_priv->nc.timestamp_sniffed_purge,
-				 bat_priv->nc.max_buffer_time)) {
-		batadv_nc_process_nc_paths(bat_priv, bat_priv->nc.decoding_hash,
-					   batadv_nc_sniffed_purge);
-		bat_priv->nc.timestamp_sniffed_purge = jiffies;
-	}
-
 	/* Schedule a new check */
 	batadv_nc_start_timer(bat_priv);
 }
 
-/**
- * batadv_can_nc_with_orig() - checks whether the given orig node is suitable
- *  for coding or not
- * @bat_priv: the bat priv with all the soft interface information
- * @orig_node: neighboring orig node which may be used as nc candidate
- * @ogm_packet: incoming ogm packet also used for the checks
- *
- * Return: true if:
- *  1) The OGM must have the most recent sequence number.
- *  2) The TTL must be decremented by one and only one.
- *  3) The OGM must be received from the first hop from orig_node.
- *  4) The TQ value of the OGM must be above bat_priv->nc.min_tq.
- */
-static bool batadv_can_nc_with_orig(struct batadv_priv *bat_priv,
-				    struct batadv_orig_node *orig_node,
-				    struct batadv_ogm_packet *ogm_packet)
-{
-	struct batadv_orig_ifinfo *orig_ifinfo;
-	u32 last_real_seqno;
-	u8 last_ttl;
-
-	orig_ifinfo = batadv_orig_ifinfo_get(orig_node, BATADV_IF_DEFAULT);
-	if (!orig_ifinfo)
-		return false;
-
-	last_ttl = orig_ifinfo->last_ttl;
-	last_real_seqno = orig_ifinfo->last_real_seqno;
-	batadv_orig_ifinfo_put(orig_ifinfo);
-
-	if (last_real_seqno != ntohl(ogm_packet->seqno))
-		return false;
-	if (last_ttl != ogm_packet->ttl + 1)
-		return false;
-	if (!batadv_compare_eth(ogm_packet->orig, ogm_packet->prev_sender))
-		return false;
-	if (ogm_packet->tq < bat_priv->nc.min_tq)
-		return false;
-
-	return true;
-}
-
 /**
  * batadv_nc_find_nc_node() - search for an existing nc node and return it
  * @orig_node: orig node originating the ogm packet
@@ -903,14 +1054,15 @@ batadv_nc_get_nc_node(struct batadv_priv *bat_priv,
  * @orig_node: orig node originating the ogm packet
  * @orig_neigh_node: neighboring orig node from which we received the ogm packet
  *  (can be equal to orig_node)
- * @ogm_packet: incoming ogm packet
+ * @link_quality: quality of the link between orig_node and orig_neigh_node
+ *  scaled to 0 - BATADV_TQ_MAX_VALUE as derived by the routing algorithm from
+ *  the ogm packet, 0 if it cannot be determined
  * @is_single_hop_neigh: orig_node is a single hop neighbor
  */
 void batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
 			      struct batadv_orig_node *orig_node,
 			      struct batadv_orig_node *orig_neigh_node,
-			      struct batadv_ogm_packet *ogm_packet,
-			      int is_single_hop_neigh)
+			      u8 link_quality, bool is_single_hop_neigh)
 {
 	struct batadv_nc_node *in_nc_node = NULL;
 	struct batadv_nc_node *out_nc_node = NULL;
@@ -924,8 +1076,7 @@ void batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
 		goto out;
 
 	/* accept ogms from 'good' neighbors and single hop neighbors */
-	if (!batadv_can_nc_with_orig(bat_priv, orig_node, ogm_packet) &&
-	    !is_single_hop_neigh)
+	if (link_quality < bat_priv->nc.min_tq && !is_single_hop_neigh)
 		goto out;
 
 	/* Add orig_node as in_nc_node on hop */
@@ -957,6 +1108,7 @@ void batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
  * @hash: hash table containing the nc path
  * @src: ethernet source address - first half of the nc path search key
  * @dst: ethernet destination address - second half of the nc path search key
+ * @timeout_fn: work function releasing timed out packets of a new nc path
  *
  * Return: pointer to nc_path if the path was found or created, returns NULL
  * on error.
@@ -964,7 +1116,8 @@ void batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
 static struct batadv_nc_path *batadv_nc_get_path(struct batadv_priv *bat_priv,
 						 struct batadv_hashtable *hash,
 						 u8 *src,
-						 u8 *dst)
+						 u8 *dst,
+						 work_func_t timeout_fn)
 {
 	int hash_added;
 	struct batadv_nc_path *nc_path, nc_path_key;
@@ -990,6 +1143,8 @@ static struct batadv_nc_path *batadv_nc_get_path(struct batadv_priv *bat_priv,
 	INIT_LIST_HEAD(&nc_path->packet_list);
 	spin_lock_init(&nc_path->packet_list_lock);
 	kref_init(&nc_path->refcount);
+	INIT_DELAYED_WORK(&nc_path->timeout_work, timeout_fn);
+	nc_path->bat_priv = bat_priv;
 	nc_path->last_valid = jiffies;
 	ether_addr_copy(nc_path->next_hop, dst);
 	ether_addr_copy(nc_path->prev_hop, src);
@@ -1013,26 +1168,33 @@ static struct batadv_nc_path *batadv_nc_get_path(struct batadv_priv *bat_priv,
 }
 
 /**
- * batadv_nc_random_weight_tq() - scale the receivers TQ-value to avoid unfair
- *  selection of a receiver with slightly lower TQ than the other
- * @tq: to be weighted tq value
+ * batadv_nc_neigh_is_preferred() - compare the links towards two neighbors
+ * @bat_priv: the bat priv with all the soft interface information
+ * @neigh1: the first neighbor
+ * @neigh2: the second neighbor
  *
- * Return: scaled tq value
+ * The comparison is done with the metric of the routing algorithm in use. If
+ * the links are of similar quality, one of them is chosen randomly to avoid
+ * unfair selection of a receiver with a slightly worse metric than the other.
+ *
+ * Return: true if the link towards neigh1 is preferred over the link towards
+ * neigh2, false otherwise.
  */
-static u8 batadv_nc_random_weight_tq(u8 tq)
+static bool batadv_nc_neigh_is_preferred(struct batadv_priv *bat_priv,
+					 struct batadv_neigh_node *neigh1,
+					 struct batadv_neigh_node *neigh2)
 {
-	u8 rand_val, rand_tq;
-
-	get_random_bytes(&rand_val, sizeof(rand_val));
+	struct batadv_algo_neigh_ops *ops = &bat_priv->algo_ops->neigh;
 
-	/* randomize the estimated packet loss (max TQ - estimated TQ) */
-	rand_tq = rand_val * (BATADV_TQ_MAX_VALUE - tq);
+	if (!ops->is_similar_or_better(neigh2, BATADV_IF_DEFAULT,
+				       neigh1, BATADV_IF_DEFAULT))
+		return true;
 
-	/* normalize the randomized packet loss */
-	rand_tq /= BATADV_TQ_MAX_VALUE;
+	if (!ops->is_similar_or_better(neigh1, BATADV_IF_DEFAULT,
+				       neigh2, BATADV_IF_DEFAULT))
+		return false;
 
-	/* convert to (randomized) estimated tq again */
-	return BATADV_TQ_MAX_VALUE - rand_tq;
+	return prandom_u32() & 1;
 }
 
 /**
@@ -1040,13 +1202,40 @@ static u8 batadv_nc_random_weight_tq(u8 tq)
  * @dst: byte array to XOR into
  * @src: byte array to XOR from
  * @len: length of destination array
+ *
+ * The bulk of the payload is processed one machine word at a time. Both
+ * buffers point somewhere behind the batman-adv headers inside an skb and
+ * are therefore rarely word aligned: architectures without efficient
+ * unaligned access only take the word-wise path when dst and src share the
+ * same misalignment and fall back to a byte loop otherwise.
  */
 static void batadv_nc_memxor(char *dst, const char *src, unsigned int len)
 {
-	unsigned int i;
+	unsigned long val;
+
+	if (!IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) &&
+	    !IS_ALIGNED((unsigned long)dst ^ (unsigned long)src,
+			sizeof(unsigned long)))
+		goto tail;
+
+	for (; len && !IS_ALIGNED((unsigned long)dst, sizeof(unsigned long));
+	     len--)
+		*dst++ ^= *src++;
+
+	for (; len >= sizeof(unsigned long); len -= sizeof(unsigned long)) {
+		if (IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS))
+			val = get_unaligned((const unsigned long *)src);
+		else
+			val = *(const unsigned long *)src;
+
+		*(unsigned long *)dst ^= val;
+		dst += sizeof(unsigned long);
+		src += sizeof(unsigned long);
+	}
 
-	for (i = 0; i < len; ++i)
-		dst[i] ^= src[i];
+tail:
+	for (; len; len--)
+		*dst++ ^= *src++;
 }
 
 /**
@@ -1066,15 +1255,12 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 				   struct batadv_nc_packet *nc_packet,
 				   struct batadv_neigh_node *neigh_node)
 {
-	u8 tq_weighted_neigh, tq_weighted_coding, tq_tmp;
 	struct sk_buff *skb_dest, *skb_src;
 	struct batadv_unicast_packet *packet1;
 	struct batadv_unicast_packet *packet2;
 	struct batadv_coded_packet *coded_packet;
 	struct batadv_neigh_node *neigh_tmp, *router_neigh, *first_dest;
 	struct batadv_neigh_node *router_coding = NULL, *second_dest;
-	struct batadv_neigh_ifinfo *router_neigh_ifinfo = NULL;
-	struct batadv_neigh_ifinfo *router_coding_ifinfo = NULL;
 	u8 *first_source, *second_source;
 	__be32 packet_id1, packet_id2;
 	size_t count;
@@ -1092,31 +1278,17 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 	if (!router_neigh)
 		goto out;
 
-	router_neigh_ifinfo = batadv_neigh_ifinfo_get(router_neigh,
-						      BATADV_IF_DEFAULT);
-	if (!router_neigh_ifinfo)
-		goto out;
-
 	neigh_tmp = nc_packet->neigh_node;
 	router_coding = batadv_orig_router_get(neigh_tmp->orig_node,
 					       BATADV_IF_DEFAULT);
 	if (!router_coding)
 		goto out;
 
-	router_coding_ifinfo = batadv_neigh_ifinfo_get(router_coding,
-						       BATADV_IF_DEFAULT);
-	if (!router_coding_ifinfo)
-		goto out;
-
-	tq_tmp = router_neigh_ifinfo->bat_iv.tq_avg;
-	tq_weighted_neigh = batadv_nc_random_weight_tq(tq_tmp);
-	tq_tmp = router_coding_ifinfo->bat_iv.tq_avg;
-	tq_weighted_coding = batadv_nc_random_weight_tq(tq_tmp);
-
-	/* Select one destination for the MAC-header dst-field based on
-	 * weighted TQ-values.
+	/* Select one destination for the MAC-header dst-field based on the
+	 * link metric of the routing algorithm.
 	 */
-	if (tq_weighted_neigh >= tq_weighted_coding) {
+	if (batadv_nc_neigh_is_preferred(bat_priv, router_neigh,
+					 router_coding)) {
 		/* Destination from nc_packet is selected for MAC-header */
 		first_dest = nc_packet->neigh_node;
 		first_source = nc_packet->nc_path->prev_hop;
@@ -1235,10 +1407,6 @@ static bool batadv_nc_code_packets(struct batadv_priv *bat_priv,
 		batadv_neigh_node_put(router_neigh);
 	if (router_coding)
 		batadv_neigh_node_put(router_coding);
-	if (router_neigh_ifinfo)
-		batadv_neigh_ifinfo_put(router_neigh_ifinfo);
-	if (router_coding_ifinfo)
-		batadv_neigh_ifinfo_put(router_coding_ifinfo);
 	return res;
 }
 
@@ -1321,7 +1489,7 @@ batadv_nc_path_search(struct batadv_priv *bat_priv,
 				continue;
 
 			/* Coding opportunity is found! */
-			list_del(&nc_packet->list);
+			batadv_nc_packet_unlink(nc_packet);
 			nc_packet_out = nc_packet;
 			break;
 		}
@@ -1473,20 +1641,52 @@ static bool batadv_nc_skb_dst_search(struct sk_buff *skb,
 	return false;
 }
 
+/**
+ * batadv_nc_path_evict() - make room for a decoding packet on an nc path
+ * @nc_path: the nc path to add the packet to
+ * @size: number of bytes which are about to be added to the path
+ *
+ * Drops the oldest packets of the path until it can hold another @size bytes
+ * without exceeding max_path_bytes. Has to be called with the appropriate
+ * locks.
+ */
+static void batadv_nc_path_evict(struct batadv_nc_path *nc_path,
+				 unsigned int size)
+{
+	struct batadv_priv *bat_priv = nc_path->bat_priv;
+	struct batadv_nc_packet *nc_packet;
+
+	lockdep_assert_held(&nc_path->packet_list_lock);
+
+	while (nc_path->buffer_bytes + size > bat_priv->nc.max_path_bytes &&
+	       !list_empty(&nc_path->packet_list)) {
+		nc_packet = list_first_entry(&nc_path->packet_list,
+					     struct batadv_nc_packet, list);
+		batadv_nc_packet_unlink(nc_packet);
+		batadv_nc_packet_free(nc_packet, true);
+		batadv_inc_counter(bat_priv, BATADV_CNT_NC_BUFFER_EVICT);
+	}
+}
+
 /**
  * batadv_nc_skb_add_to_path() - buffer skb for later encoding / decoding
  * @skb: skb to add to path
  * @nc_path: path to add skb to
  * @neigh_node: next hop to forward packet to
  * @packet_id: checksum to identify packet
+ * @timeout: buffering time of packets on this path in milliseconds
+ * @decoding: whether the skb is buffered for decoding and has to be accounted
+ *  in the decoding buffer
  *
  * Return: true if the packet was buffered or false in case of an error.
  */
 static bool batadv_nc_skb_add_to_path(struct sk_buff *skb,
 				      struct batadv_nc_path *nc_path,
 				      struct batadv_neigh_node *neigh_node,
-				      __be32 packet_id)
+				      __be32 packet_id, u32 timeout,
+				      bool decoding)
 {
+	struct batadv_priv_nc *priv_nc = &nc_path->bat_priv->nc;
 	struct batadv_nc_packet *nc_packet;
 
 	nc_packet = kzalloc(sizeof(*nc_packet), GFP_ATOMIC);
@@ -1499,10 +1699,31 @@ static bool batadv_nc_skb_add_to_path(struct sk_buff *skb,
 	nc_packet->skb = skb;
 	nc_packet->neigh_node = neigh_node;
 	nc_packet->nc_path = nc_path;
+	INIT_LIST_HEAD(&nc_packet->lru_list);
+
+	if (decoding) {
+		nc_packet->size = skb->truesize;
+		batadv_nc_decoding_evict(nc_path->bat_priv, nc_packet->size);
+	}
 
-	/* Add coding packet to list */
+	/* Add coding packet to list and arm the timeout work when it became
+	 * the oldest packet of the path
+	 */
 	spin_lock_bh(&nc_path->packet_list_lock);
+	if (decoding) {
+		batadv_nc_path_evict(nc_path, nc_packet->size);
+
+		spin_lock_bh(&priv_nc->decoding_lru_lock);
+		list_add_tail(&nc_packet->lru_list, &priv_nc->decoding_lru);
+		spin_unlock_bh(&priv_nc->decoding_lru_lock);
+
+		nc_path->buffer_bytes += nc_packet->size;
+		atomic_add(nc_packet->size, &priv_nc->decoding_bytes);
+	}
+
 	list_add_tail(&nc_packet->list, &nc_path->packet_list);
+	if (list_is_singular(&nc_path->packet_list))
+		batadv_nc_path_schedule(nc_path, timeout);
 	spin_unlock_bh(&nc_path->packet_list_lock);
 
 	return true;
@@ -1545,14 +1766,16 @@ bool batadv_nc_skb_forward(struct sk_buff *skb,
 	nc_path = batadv_nc_get_path(bat_priv,
 				     bat_priv->nc.coding_hash,
 				     ethhdr->h_source,
-				     neigh_node->addr);
+				     neigh_node->addr,
+				     batadv_nc_fwd_flush_work);
 
 	if (!nc_path)
 		goto out;
 
 	/* Add skb to nc_path */
 	packet_id = batadv_skb_crc32(skb, payload + sizeof(*packet));
-	if (!batadv_nc_skb_add_to_path(skb, nc_path, neigh_node, packet_id))
+	if (!batadv_nc_skb_add_to_path(skb, nc_path, neigh_node, packet_id,
+				       bat_priv->nc.max_fwd_delay, false))
 		goto free_nc_path;
 
 	/* Packet is consumed */
@@ -1594,7 +1817,8 @@ void batadv_nc_skb_store_for_decoding(struct batadv_priv *bat_priv,
 	nc_path = batadv_nc_get_path(bat_priv,
 				     bat_priv->nc.decoding_hash,
 				     ethhdr->h_source,
-				     ethhdr->h_dest);
+				     ethhdr->h_dest,
+				     batadv_nc_sniffed_purge_work);
 
 	if (!nc_path)
 		goto out;
@@ -1612,7 +1836,8 @@ void batadv_nc_skb_store_for_decoding(struct batadv_priv *bat_priv,
 
 	/* Add skb to nc_path */
 	packet_id = batadv_skb_crc32(skb, payload + sizeof(*packet));
-	if (!batadv_nc_skb_add_to_path(skb, nc_path, NULL, packet_id))
+	if (!batadv_nc_skb_add_to_path(skb, nc_path, NULL, packet_id,
+				       bat_priv->nc.max_buffer_time, true))
 		goto free_skb;
 
 	batadv_inc_counter(bat_priv, BATADV_CNT_NC_BUFFER);
@@ -1785,7 +2010,7 @@ batadv_nc_find_decoding_packet(struct batadv_priv *bat_priv,
 		list_for_each_entry(tmp_nc_packet,
 				    &nc_path->packet_list, list) {
 			if (packet_id == tmp_nc_packet->packet_id) {
-				list_del(&tmp_nc_packet->list);
+				batadv_nc_packet_unlink(tmp_nc_packet);
 
 				nc_packet = tmp_nc_packet;
 				break;
@@ -1890,6 +2115,9 @@ void batadv_nc_mesh_free(struct batadv_priv *bat_priv)
 	batadv_tvlv_handler_unregister(bat_priv, BATADV_TVLV_NC, 1);
 	cancel_delayed_work_sync(&bat_priv->nc.work);
 
+	batadv_nc_flush_paths(bat_priv, bat_priv->nc.coding_hash);
+	batadv_nc_flush_paths(bat_priv, bat_priv->nc.decoding_hash);
+
 	batadv_nc_purge_paths(bat_priv, bat_priv->nc.coding_hash, NULL);
 	batadv_hash_destroy(bat_priv->nc.coding_hash);
 	batadv_nc_purge_paths(bat_priv, bat_priv->nc.decoding_hash, NULL);
@@ -1988,9 +2216,48 @@ int batadv_nc_init_debugfs(struct batadv_priv *bat_priv)
 	if (!file)
 		goto out;
 
+	file = debugfs_create_u32("max_buffer_bytes", 0644, nc_dir,
+				  &bat_priv->nc.max_buffer_bytes);
+	if (!file)
+		goto out;
+
+	file = debugfs_create_u32("max_path_bytes", 0644, nc_dir,
+				  &bat_priv->nc.max_path_bytes);
+	if (!file)
+		goto out;
+
 	return 0;
 
 out:
 	return -ENOMEM;
 }
 #endif
+
+/**
+ * batadv_nc_mesh_info_put() - put network coding info into a netlink message
+ * @msg: buffer for the message
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: 0 or error code.
+ */
+int batadv_nc_mesh_info_put(struct sk_buff *msg, struct batadv_priv *bat_priv)
+{
+	u64 evict, decode, decode_failed;
+
+	evict = batadv_sum_counter(bat_priv, BATADV_CNT_NC_BUFFER_EVICT);
+	decode = batadv_sum_counter(bat_priv, BATADV_CNT_NC_DECODE);
+	decode_failed = batadv_sum_counter(bat_priv,
+					   BATADV_CNT_NC_DECODE_FAILED);
+
+	if (nla_put_u32(msg, BATADV_ATTR_NC_BUFFER_BYTES,
+			atomic_read(&bat_priv->nc.decoding_bytes)) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_NC_BUFFER_EVICT, evict,
+			      BATADV_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_NC_DECODE, decode,
+			      BATADV_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, BATADV_ATTR_NC_DECODE_FAILED, decode_failed,
+			      BATADV_ATTR_PAD))
+		return -EMSGSIZE;
+
+	return 0;
+}
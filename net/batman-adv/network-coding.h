@@ -21,9 +21,9 @@
 
 #include "main.h"
 
+#include <linux/atomic.h>
 #include <linux/types.h>
 
-struct batadv_ogm_packet;
 struct net_device;
 struct seq_file;
 struct sk_buff;
@@ -37,8 +37,7 @@ void batadv_nc_mesh_free(struct batadv_priv *bat_priv);
 void batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
 			      struct batadv_orig_node *orig_node,
 			      struct batadv_orig_node *orig_neigh_node,
-			      struct batadv_ogm_packet *ogm_packet,
-			      int is_single_hop_neigh);
+			      u8 link_quality, bool is_single_hop_neigh);
 void batadv_nc_purge_orig(struct batadv_priv *bat_priv,
 			  struct batadv_orig_node *orig_node,
 			  bool (*to_purge)(struct batadv_priv *,
@@ -53,6 +52,18 @@ void batadv_nc_skb_store_sniffed_unicast(struct batadv_priv *bat_priv,
 					 struct sk_buff *skb);
 int batadv_nc_nodes_seq_print_text(struct seq_file *seq, void *offset);
 int batadv_nc_init_debugfs(struct batadv_priv *bat_priv);
+int batadv_nc_mesh_info_put(struct sk_buff *msg, struct batadv_priv *bat_priv);
+
+/**
+ * batadv_nc_enabled() - check whether network coding is enabled
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: true if network coding is enabled, false otherwise.
+ */
+static inline bool batadv_nc_enabled(struct batadv_priv *bat_priv)
+{
+	return atomic_read(&bat_priv->network_coding);
+}
 
 #else /* ifdef CONFIG_BATMAN_ADV_NC */
 
@@ -74,12 +85,16 @@ static inline void batadv_nc_mesh_free(struct batadv_priv *bat_priv)
 {
 }
 
+static inline bool batadv_nc_enabled(struct batadv_priv *bat_priv)
+{
+	return false;
+}
+
 static inline void
 batadv_nc_update_nc_node(struct batadv_priv *bat_priv,
 			 struct batadv_orig_node *orig_node,
 			 struct batadv_orig_node *orig_neigh_node,
-			 struct batadv_ogm_packet *ogm_packet,
-			 int is_single_hop_neigh)
+			 u8 link_quality, bool is_single_hop_neigh)
 {
 }
 
@@ -128,6 +143,12 @@ static inline int batadv_nc_init_debugfs(struct batadv_priv *bat_priv)
 	return 0;
 }
 
+static inline int batadv_nc_mesh_info_put(struct sk_buff *msg,
+					  struct batadv_priv *bat_priv)
+{
+	return 0;
+}
+
 #endif /* ifdef CONFIG_BATMAN_ADV_NC */
 
 #endif /* _NET_BATMAN_ADV_NETWORK_CODING_H_ */
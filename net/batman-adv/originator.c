@@ -594,6 +594,7 @@ batadv_hardif_neigh_create(struct batadv_hard_iface *hard_iface,
 		bat_priv->algo_ops->neigh.hardif_init(hardif_neigh);
 
 	hlist_add_head_rcu(&hardif_neigh->list, &hard_iface->neigh_list);
+	batadv_topology_changed(bat_priv);
 
 out:
 	spin_unlock_bh(&hard_iface->neigh_list_lock);
@@ -1048,6 +1049,7 @@ struct batadv_orig_node *batadv_orig_node_new(struct batadv_priv *bat_priv,
 	ether_addr_copy(orig_node->orig, addr);
 	batadv_dat_init_orig_node_addr(orig_node);
 	atomic_set(&orig_node->last_ttvn, 0);
+	orig_node->tt_part_offset = BATADV_TT_PART_NONE;
 	orig_node->tt_buff = NULL;
 	orig_node->tt_buff_len = 0;
 	orig_node->last_seen = jiffies;
@@ -93,6 +93,8 @@ static void _batadv_update_route(struct batadv_priv *bat_priv,
 	spin_unlock_bh(&orig_node->neigh_list_lock);
 	batadv_orig_ifinfo_put(orig_ifinfo);
 
+	batadv_topology_changed(bat_priv);
+
 	/* route deleted */
 	if (curr_router && !neigh_node) {
 		batadv_dbg(BATADV_DBG_ROUTES, bat_priv,
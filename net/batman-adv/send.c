@@ -153,6 +153,7 @@ int batadv_send_unicast_skb(struct sk_buff *skb,
 {
 #ifdef CONFIG_BATMAN_ADV_BATMAN_V
 	struct batadv_hardif_neigh_node *hardif_neigh;
+	unsigned int len = skb->len + ETH_HLEN;
 #endif
 	int ret;
 
@@ -161,8 +162,10 @@ int batadv_send_unicast_skb(struct sk_buff *skb,
 #ifdef CONFIG_BATMAN_ADV_BATMAN_V
 	hardif_neigh = batadv_hardif_neigh_get(neigh->if_incoming, neigh->addr);
 
-	if (hardif_neigh && ret != NET_XMIT_DROP)
+	if (hardif_neigh && ret != NET_XMIT_DROP) {
 		hardif_neigh->bat_v.last_unicast_tx = jiffies;
+		atomic_add(len, &hardif_neigh->bat_v.tx_bytes);
+	}
 
 	if (hardif_neigh)
 		batadv_hardif_neigh_put(hardif_neigh);
@@ -449,23 +452,30 @@ int batadv_send_skb_via_tt_generic(struct batadv_priv *bat_priv,
  * @skb: payload to send
  * @vid: the vid to be used to search the translation table
  *
- * Look up the currently selected gateway. Wrap the given skb into a batman-adv
- * unicast header and send this frame to this gateway node.
+ * Look up the gateway serving the source of the given skb (the currently
+ * selected gateway unless gateway load balancing is enabled). Wrap the given
+ * skb into a batman-adv unicast header and send this frame to this gateway
+ * node.
  *
  * Return: NET_XMIT_DROP in case of error or NET_XMIT_SUCCESS otherwise.
  */
 int batadv_send_skb_via_gw(struct batadv_priv *bat_priv, struct sk_buff *skb,
 			   unsigned short vid)
 {
-	struct batadv_orig_node *orig_node;
+	struct ethhdr *ethhdr = (struct ethhdr *)skb->data;
+	struct batadv_orig_node *orig_node = NULL;
+	struct batadv_gw_node *gw_node;
 	int ret;
 
-	orig_node = batadv_gw_get_selected_orig(bat_priv);
+	gw_node = batadv_gw_get_client_gw_node(bat_priv, ethhdr->h_source);
+	if (gw_node)
+		orig_node = gw_node->orig_node;
+
 	ret = batadv_send_skb_unicast(bat_priv, skb, BATADV_UNICAST_4ADDR,
 				      BATADV_P_DATA, orig_node, vid);
 
-	if (orig_node)
-		batadv_orig_node_put(orig_node);
+	if (gw_node)
+		batadv_gw_node_put(gw_node);
 
 	return ret;
 }
@@ -546,6 +556,7 @@ batadv_forw_packet_alloc(struct batadv_hard_iface *if_incoming,
 
 	INIT_HLIST_NODE(&forw_packet->list);
 	INIT_HLIST_NODE(&forw_packet->cleanup_list);
+	INIT_HLIST_NODE(&forw_packet->aggr_list);
 	forw_packet->skb = skb;
 	forw_packet->queue_left = queue_left;
 	forw_packet->if_incoming = if_incoming;
@@ -599,6 +610,7 @@ bool batadv_forw_packet_steal(struct batadv_forw_packet *forw_packet,
 	}
 
 	hlist_del_init(&forw_packet->list);
+	hlist_del_init(&forw_packet->aggr_list);
 
 	/* Just to spot misuse of this function */
 	hlist_add_fake(&forw_packet->cleanup_list);
@@ -639,6 +651,7 @@ batadv_forw_packet_list_steal(struct hlist_head *forw_list,
 			continue;
 
 		hlist_del(&forw_packet->list);
+		hlist_del_init(&forw_packet->aggr_list);
 		hlist_add_head(&forw_packet->cleanup_list, cleanup_list);
 	}
 }
@@ -672,6 +685,7 @@ static void batadv_forw_packet_list_free(struct hlist_head *head)
  * @forw_packet: the forwarding packet to queue
  * @lock: a key to the store (e.g. forw_{bat,bcast}_list_lock)
  * @head: the shelve to queue it on (e.g. forw_{bat,bcast}_list)
+ * @aggr_head: the aggregation slot to index it in or NULL
  * @send_time: timestamp (jiffies) when the packet is to be sent
  *
  * This function tries to (re)queue a forwarding packet. Requeuing
@@ -686,6 +700,7 @@ static void batadv_forw_packet_list_free(struct hlist_head *head)
  */
 static void batadv_forw_packet_queue(struct batadv_forw_packet *forw_packet,
 				     spinlock_t *lock, struct hlist_head *head,
+				     struct hlist_head *aggr_head,
 				     unsigned long send_time)
 {
 	spin_lock_bh(lock);
@@ -705,6 +720,11 @@ static void batadv_forw_packet_queue(struct batadv_forw_packet *forw_packet,
 	hlist_del_init(&forw_packet->list);
 	hlist_add_head(&forw_packet->list, head);
 
+	if (aggr_head) {
+		hlist_del_init(&forw_packet->aggr_list);
+		hlist_add_head(&forw_packet->aggr_list, aggr_head);
+	}
+
 	queue_delayed_work(batadv_event_workqueue,
 			   &forw_packet->delayed_work,
 			   send_time - jiffies);
@@ -727,13 +747,14 @@ batadv_forw_packet_bcast_queue(struct batadv_priv *bat_priv,
 			       unsigned long send_time)
 {
 	batadv_forw_packet_queue(forw_packet, &bat_priv->forw_bcast_list_lock,
-				 &bat_priv->forw_bcast_list, send_time);
+				 &bat_priv->forw_bcast_list, NULL, send_time);
 }
 
 /**
  * batadv_forw_packet_ogmv1_queue() - try to queue an OGMv1 packet
  * @bat_priv: the bat priv with all the soft interface information
  * @forw_packet: the forwarding packet to queue
+ * @aggr_head: the aggregation slot to index the packet in or NULL
  * @send_time: timestamp (jiffies) when the packet is to be sent
  *
  * This function tries to (re)queue an OGMv1 packet.
@@ -742,10 +763,12 @@ batadv_forw_packet_bcast_queue(struct batadv_priv *bat_priv,
  */
 void batadv_forw_packet_ogmv1_queue(struct batadv_priv *bat_priv,
 				    struct batadv_forw_packet *forw_packet,
+				    struct hlist_head *aggr_head,
 				    unsigned long send_time)
 {
 	batadv_forw_packet_queue(forw_packet, &bat_priv->forw_bat_list_lock,
-				 &bat_priv->forw_bat_list, send_time);
+				 &bat_priv->forw_bat_list, aggr_head,
+				 send_time);
 }
 
 /**
@@ -110,7 +110,7 @@ static int batadv_interface_release(struct net_device *dev)
  *
  * Return: sum of all cpu-local counters
  */
-static u64 batadv_sum_counter(struct batadv_priv *bat_priv,  size_t idx)
+u64 batadv_sum_counter(struct batadv_priv *bat_priv,  size_t idx)
 {
 	u64 *counters, sum = 0;
 	int cpu;
@@ -181,11 +181,13 @@ static int batadv_interface_change_mtu(struct net_device *dev, int new_mtu)
  * @dev: registered network device to modify
  *
  * We do not actually need to set any rx filters for the virtual batman
- * soft interface. However a dummy handler enables a user to set static
- * multicast listeners for instance.
+ * soft interface. However the handler enables a user to set static
+ * multicast listeners for instance and announces changed multicast
+ * listeners without waiting for the next periodic update.
  */
 static void batadv_interface_set_rx_mode(struct net_device *dev)
 {
+	batadv_mcast_mla_schedule(netdev_priv(dev));
 }
 
 static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
@@ -209,8 +211,9 @@ static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
 	unsigned short vid;
 	u32 seqno;
 	int gw_mode;
-	enum batadv_forw_mode forw_mode;
+	enum batadv_forw_mode forw_mode = BATADV_FORW_SINGLE;
 	struct batadv_orig_node *mcast_single_orig = NULL;
+	struct batadv_tt_global_entry *mcast_listeners = NULL;
 	int network_offset = ETH_HLEN;
 
 	if (atomic_read(&bat_priv->mesh_state) != BATADV_MESH_ACTIVE)
@@ -276,8 +279,8 @@ static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
 			goto send;
 		}
 
-		dhcp_rcp = batadv_gw_dhcp_recipient_get(skb, &header_len,
-							chaddr);
+		dhcp_rcp = batadv_gw_dhcp_recipient_get(bat_priv, skb,
+							&header_len, chaddr);
 		/* skb->data may have been modified by
 		 * batadv_gw_dhcp_recipient_get()
 		 */
@@ -302,11 +305,13 @@ static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
 send:
 		if (do_bcast && !is_broadcast_ether_addr(ethhdr->h_dest)) {
 			forw_mode = batadv_mcast_forw_mode(bat_priv, skb,
-							   &mcast_single_orig);
+							   &mcast_single_orig,
+							   &mcast_listeners);
 			if (forw_mode == BATADV_FORW_NONE)
 				goto dropped;
 
-			if (forw_mode == BATADV_FORW_SINGLE)
+			if (forw_mode == BATADV_FORW_SINGLE ||
+			    forw_mode == BATADV_FORW_SOME)
 				do_bcast = false;
 		}
 	}
@@ -366,6 +371,9 @@ static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
 			ret = batadv_send_skb_unicast(bat_priv, skb,
 						      BATADV_UNICAST, 0,
 						      mcast_single_orig, vid);
+		} else if (forw_mode == BATADV_FORW_SOME) {
+			ret = batadv_mcast_forw_send(bat_priv, skb, vid,
+						     mcast_listeners);
 		} else {
 			if (batadv_dat_snoop_outgoing_arp_request(bat_priv,
 								  skb))
@@ -391,6 +399,8 @@ static netdev_tx_t batadv_interface_tx(struct sk_buff *skb,
 end:
 	if (mcast_single_orig)
 		batadv_orig_node_put(mcast_single_orig);
+	if (mcast_listeners)
+		batadv_tt_global_entry_put(mcast_listeners);
 	if (primary_if)
 		batadv_hardif_put(primary_if);
 	return NETDEV_TX_OK;
@@ -807,6 +817,7 @@ static int batadv_softif_init_late(struct net_device *dev)
 	bat_priv->mcast.querier_ipv6.shadowing = false;
 	bat_priv->mcast.flags = BATADV_NO_FLAGS;
 	atomic_set(&bat_priv->multicast_mode, 1);
+	atomic_set(&bat_priv->multicast_fanout, 16);
 	atomic_set(&bat_priv->mcast.num_want_all_unsnoopables, 0);
 	atomic_set(&bat_priv->mcast.num_want_all_ipv4, 0);
 	atomic_set(&bat_priv->mcast.num_want_all_ipv6, 0);
@@ -814,7 +825,10 @@ static int batadv_softif_init_late(struct net_device *dev)
 	atomic_set(&bat_priv->gw.mode, BATADV_GW_MODE_OFF);
 	atomic_set(&bat_priv->gw.bandwidth_down, 100);
 	atomic_set(&bat_priv->gw.bandwidth_up, 20);
+	atomic_set(&bat_priv->gw_load_balancing, 0);
 	atomic_set(&bat_priv->orig_interval, 1000);
+	atomic_set(&bat_priv->interval_backoff, 0);
+	atomic_set(&bat_priv->topology_gen, 0);
 	atomic_set(&bat_priv->hop_penalty, 30);
 #ifdef CONFIG_BATMAN_ADV_DEBUG
 	atomic_set(&bat_priv->log_level, 0);
@@ -968,6 +982,11 @@ static const struct {
 	{ "mgmt_tx_bytes" },
 	{ "mgmt_rx" },
 	{ "mgmt_rx_bytes" },
+	{ "mgmt_tx_saved" },
+#ifdef CONFIG_BATMAN_ADV_BATMAN_V
+	{ "ogm2_aggr_tx" },
+	{ "ogm2_aggr_tx_ogms" },
+#endif
 	{ "frag_tx" },
 	{ "frag_tx_bytes" },
 	{ "frag_rx" },
@@ -980,6 +999,13 @@ static const struct {
 	{ "tt_response_rx" },
 	{ "tt_roam_adv_tx" },
 	{ "tt_roam_adv_rx" },
+	{ "tt_compress_saved_bytes" },
+	{ "tt_search_miss" },
+	{ "tt_search_miss_cached" },
+	{ "gw_class_dhcp" },
+	{ "gw_class_arp" },
+	{ "gw_class_udp" },
+	{ "gw_class_other" },
 #ifdef CONFIG_BATMAN_ADV_DAT
 	{ "dat_get_tx" },
 	{ "dat_get_rx" },
@@ -997,6 +1023,11 @@ static const struct {
 	{ "nc_decode_bytes" },
 	{ "nc_decode_failed" },
 	{ "nc_sniffed" },
+	{ "nc_buffer_evict" },
+#endif
+#ifdef CONFIG_BATMAN_ADV_MCAST
+	{ "mcast_fanout_tx" },
+	{ "mcast_fanout_unicast_tx" },
 #endif
 };
 
@@ -20,10 +20,14 @@
 #include "main.h"
 
 #include <linux/atomic.h>
+#include <linux/bitops.h>
 #include <linux/build_bug.h>
 #include <linux/byteorder/generic.h>
 #include <linux/cache.h>
 #include <linux/compiler.h>
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/delay.h>
 #include <linux/err.h>
 #include <linux/etherdevice.h>
 #include <linux/gfp.h>
@@ -33,7 +37,10 @@
 #include <linux/kernel.h>
 #include <linux/kref.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/lockdep.h>
+#include <linux/math64.h>
 #include <linux/netdevice.h>
 #include <linux/param.h>
 #include <linux/printk.h>
@@ -46,12 +53,14 @@
 #include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
+#include <linux/timekeeping.h>
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
 #include <uapi/linux/batadv_packet.h>
 #include <uapi/linux/batman_adv.h>
 
+#include "bitarray.h"
 #include "hard-interface.h"
 #include "log.h"
 #include "netlink.h"
@@ -95,6 +104,59 @@
 #define BATADV_TP_PLEN (BATADV_TP_PACKET_LEN - ETH_HLEN - \
 			sizeof(struct batadv_unicast_packet))
 
+/**
+ * BATADV_TP_CUBIC_BETA - multiplicative window decrease of CUBIC on loss (in
+ *  1/10th)
+ */
+#define BATADV_TP_CUBIC_BETA 7
+
+/**
+ * BATADV_TP_CUBIC_K_SCALE - 1 / C of the cubic function with the time in
+ *  milliseconds (C = 0.4 segments/s^3)
+ */
+#define BATADV_TP_CUBIC_K_SCALE 2500000000ULL
+
+/**
+ * BATADV_TP_CUBIC_MAX_T - limit of the time (in ms) used in the cubic function
+ *  to avoid overflows
+ */
+#define BATADV_TP_CUBIC_MAX_T 2000000
+
+/**
+ * BATADV_TP_RATE_STARTUP_GAIN - pacing gain (in 1/8th) while the rate based
+ *  congestion control searches the bottleneck bandwidth
+ */
+#define BATADV_TP_RATE_STARTUP_GAIN 23
+
+/**
+ * BATADV_TP_RATE_CYCLE_LEN - number of rounds of the bandwidth probing cycle
+ */
+#define BATADV_TP_RATE_CYCLE_LEN 8
+
+/**
+ * BATADV_TP_RATE_MIN_RTT_WIN - time (in ms) after which the minimal RTT is
+ *  replaced by a new sample
+ */
+#define BATADV_TP_RATE_MIN_RTT_WIN 10000
+
+/**
+ * BATADV_TP_PACING_SLACK - time (in ns) the sender may be ahead of the pacing
+ *  rate before it has to sleep
+ */
+#define BATADV_TP_PACING_SLACK NSEC_PER_MSEC
+
+/**
+ * BATADV_TP_PACING_MAX_SLEEP - longest time (in ns) the sender sleeps for
+ *  pacing before checking whether the session was stopped
+ */
+#define BATADV_TP_PACING_MAX_SLEEP (5 * NSEC_PER_MSEC)
+
+/**
+ * BATADV_TP_PROBE_MAX_USLEEP - longest probe interval (in ms) which is slept
+ *  with hrtimer precision, longer intervals use the less precise msleep
+ */
+#define BATADV_TP_PROBE_MAX_USLEEP 20
+
 static u8 batadv_tp_prerandom[4096] __read_mostly;
 
 /**
@@ -141,7 +203,7 @@ static u32 batadv_tp_cwnd(u32 base, u32 increment, u32 min)
 }
 
 /**
- * batadv_tp_updated_cwnd() - update the Congestion Windows
+ * batadv_tp_reno_cong_avoid() - update the Congestion Windows
  * @tp_vars: the private data of the current TP meter session
  * @mss: maximum segment size of transmission
  *
@@ -150,29 +212,338 @@ static u32 batadv_tp_cwnd(u32 base, u32 increment, u32 min)
  * 2) if the session is in Congestion Avoidance, the CWND has to be
  * increased by MSS * MSS / CWND for every unique received ACK
  */
-static void batadv_tp_update_cwnd(struct batadv_tp_vars *tp_vars, u32 mss)
+static void batadv_tp_reno_cong_avoid(struct batadv_tp_vars *tp_vars, u32 mss)
 {
-	spin_lock_bh(&tp_vars->cwnd_lock);
-
 	/* slow start... */
 	if (tp_vars->cwnd <= tp_vars->ss_threshold) {
 		tp_vars->dec_cwnd = 0;
 		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
-		spin_unlock_bh(&tp_vars->cwnd_lock);
 		return;
 	}
 
 	/* increment CWND at least of 1 (section 3.1 of RFC5681) */
 	tp_vars->dec_cwnd += max_t(u32, 1U << 3,
 				   ((mss * mss) << 6) / (tp_vars->cwnd << 3));
-	if (tp_vars->dec_cwnd < (mss << 3)) {
-		spin_unlock_bh(&tp_vars->cwnd_lock);
+	if (tp_vars->dec_cwnd < (mss << 3))
 		return;
-	}
 
 	tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
 	tp_vars->dec_cwnd = 0;
+}
+
+/**
+ * batadv_tp_reno_ssthresh() - halve the congestion window after a loss
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * Return: the new slow start threshold
+ */
+static u32 batadv_tp_reno_ssthresh(struct batadv_tp_vars *tp_vars)
+{
+	return tp_vars->cwnd >> 1;
+}
+
+static const struct batadv_tp_cc_ops batadv_tp_cc_reno = {
+	.name = "reno",
+	.cong_avoid = batadv_tp_reno_cong_avoid,
+	.ssthresh = batadv_tp_reno_ssthresh,
+};
+
+/**
+ * batadv_tp_cbrt() - compute the integer cube root
+ * @a: the value to take the cube root of
+ *
+ * Return: the largest integer whose cube is not larger than @a
+ */
+static u32 batadv_tp_cbrt(u64 a)
+{
+	u32 lo = 0, hi = BATADV_TP_CUBIC_MAX_T, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi + 1) >> 1;
+		if ((u64)mid * mid * mid <= a)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
+
+/**
+ * batadv_tp_cubic_init() - initialize the CUBIC state of a stream
+ * @tp_vars: the private data of the current TP meter session
+ */
+static void batadv_tp_cubic_init(struct batadv_tp_vars *tp_vars)
+{
+	memset(&tp_vars->cc.cubic, 0, sizeof(tp_vars->cc.cubic));
+}
+
+/**
+ * batadv_tp_cubic_cong_avoid() - grow the CUBIC congestion window
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ *
+ * Outside of Slow Start the window follows W(t) = C * (t - K)^3 + W_max
+ * (Section 4.1 of RFC8312): it quickly returns to the window size of the last
+ * loss, stays there for a while and then probes for more bandwidth. The
+ * window grows at least as fast as the one of Reno.
+ */
+static void batadv_tp_cubic_cong_avoid(struct batadv_tp_vars *tp_vars,
+				       u32 mss)
+{
+	struct batadv_tp_cubic *cubic = &tp_vars->cc.cubic;
+	u32 cwnd = tp_vars->cwnd;
+	s64 offset, target;
+	u32 inc = 0;
+	u64 k3;
+	s64 t;
+
+	/* slow start... */
+	if (cwnd <= tp_vars->ss_threshold) {
+		tp_vars->cwnd = batadv_tp_cwnd(cwnd, mss, mss);
+		return;
+	}
+
+	if (!cubic->epoch_started) {
+		cubic->epoch_started = true;
+		cubic->epoch_start = jiffies;
+
+		if (cwnd < cubic->last_w_max) {
+			cubic->origin = cubic->last_w_max;
+			/* K = cbrt((W_max - cwnd) / C) with C = 0.4 seg/s^3 */
+			k3 = div_u64(BATADV_TP_CUBIC_K_SCALE *
+				     (cubic->origin - cwnd), mss);
+			cubic->k = batadv_tp_cbrt(k3);
+		} else {
+			cubic->origin = cwnd;
+			cubic->k = 0;
+		}
+	}
+
+	t = jiffies_to_msecs(jiffies - cubic->epoch_start);
+	t = clamp_t(s64, t - cubic->k, -BATADV_TP_CUBIC_MAX_T,
+		    BATADV_TP_CUBIC_MAX_T);
+
+	/* C * t^3 in segments with t in ms */
+	offset = div64_s64(t * t * t, BATADV_TP_CUBIC_K_SCALE);
+	target = cubic->origin + offset * mss;
+
+	/* reach the target within one RTT but at most grow by 1.5x per RTT */
+	if (target > cwnd)
+		inc = min_t(u64, div_u64((u64)(target - cwnd) * mss, cwnd),
+			    mss >> 1);
+
+	/* never grow slower than Reno */
+	inc = max_t(u32, inc, mss * mss / cwnd);
+
+	tp_vars->cwnd = batadv_tp_cwnd(cwnd, inc, mss);
+}
+
+/**
+ * batadv_tp_cubic_ssthresh() - reduce the CUBIC congestion window after a loss
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * Return: the new slow start threshold
+ */
+static u32 batadv_tp_cubic_ssthresh(struct batadv_tp_vars *tp_vars)
+{
+	struct batadv_tp_cubic *cubic = &tp_vars->cc.cubic;
+	u32 cwnd = tp_vars->cwnd;
+
+	cubic->epoch_started = false;
+
+	/* fast convergence (Section 4.6 of RFC8312) */
+	if (cwnd < cubic->last_w_max)
+		cubic->last_w_max = div_u64((u64)cwnd *
+					    (10 + BATADV_TP_CUBIC_BETA), 20);
+	else
+		cubic->last_w_max = cwnd;
+
+	return div_u64((u64)cwnd * BATADV_TP_CUBIC_BETA, 10);
+}
+
+static const struct batadv_tp_cc_ops batadv_tp_cc_cubic = {
+	.name = "cubic",
+	.init = batadv_tp_cubic_init,
+	.cong_avoid = batadv_tp_cubic_cong_avoid,
+	.ssthresh = batadv_tp_cubic_ssthresh,
+};
+
+/**
+ * batadv_tp_rate_init() - initialize the rate based state of a stream
+ * @tp_vars: the private data of the current TP meter session
+ */
+static void batadv_tp_rate_init(struct batadv_tp_vars *tp_vars)
+{
+	struct batadv_tp_rate *rate = &tp_vars->cc.rate;
+
+	memset(rate, 0, sizeof(*rate));
+	rate->round_start = jiffies;
+	rate->startup = true;
+}
+
+/**
+ * batadv_tp_rate_gain() - get the current pacing gain
+ * @rate: the rate based state of the stream
+ *
+ * Return: pacing gain in 1/8th
+ */
+static u32 batadv_tp_rate_gain(const struct batadv_tp_rate *rate)
+{
+	/* probe for more bandwidth in one round, drain the queue created by
+	 * it in the next round and cruise for the rest of the cycle
+	 */
+	static const u8 cycle[BATADV_TP_RATE_CYCLE_LEN] = {
+		10, 6, 8, 8, 8, 8, 8, 8,
+	};
+
+	if (rate->startup)
+		return BATADV_TP_RATE_STARTUP_GAIN;
+
+	return cycle[rate->cycle_idx];
+}
+
+/**
+ * batadv_tp_rate_pkts_acked() - update the bottleneck bandwidth estimation
+ * @tp_vars: the private data of the current TP meter session
+ * @acked: amount of newly acked bytes
+ * @rtt: RTT sample of the ACK in ms, 0 if none
+ *
+ * The acked data is sampled once per round (the minimal RTT). The bottleneck
+ * bandwidth is the windowed maximum of the delivery rates of the rounds.
+ */
+static void batadv_tp_rate_pkts_acked(struct batadv_tp_vars *tp_vars,
+				      u32 acked, u32 rtt)
+{
+	struct batadv_tp_rate *rate = &tp_vars->cc.rate;
+	unsigned long round_len;
+	u32 elapsed;
+	u64 bw;
+
+	if (rtt && (!rate->min_rtt || rtt <= rate->min_rtt ||
+		    batadv_has_timed_out(rate->min_rtt_stamp,
+					 BATADV_TP_RATE_MIN_RTT_WIN))) {
+		rate->min_rtt = rtt;
+		rate->min_rtt_stamp = jiffies;
+	}
+
+	rate->delivered += acked;
+
+	round_len = msecs_to_jiffies(max_t(u32, rate->min_rtt, 1));
+	if (time_before(jiffies, rate->round_start + round_len))
+		return;
+
+	elapsed = max_t(u32, jiffies_to_msecs(jiffies - rate->round_start), 1);
+	bw = div_u64(rate->delivered * MSEC_PER_SEC, elapsed);
+
+	rate->delivered = 0;
+	rate->round_start = jiffies;
+
+	/* windowed max filter, old samples fade out by 1/8 per round */
+	rate->btl_bw = max(bw, rate->btl_bw - (rate->btl_bw >> 3));
+
+	if (rate->startup) {
+		/* the bandwidth stopped growing by 25% for 3 rounds */
+		if (bw >= rate->full_bw + (rate->full_bw >> 2)) {
+			rate->full_bw = bw;
+			rate->full_bw_cnt = 0;
+		} else if (++rate->full_bw_cnt >= 3) {
+			rate->startup = false;
+		}
+	} else {
+		rate->cycle_idx++;
+		rate->cycle_idx %= BATADV_TP_RATE_CYCLE_LEN;
+	}
+
+	rate->pacing_rate = (rate->btl_bw * batadv_tp_rate_gain(rate)) >> 3;
+}
+
+/**
+ * batadv_tp_rate_cong_avoid() - move the congestion window towards the
+ *  estimated bandwidth-delay product
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ *
+ * The window changes by at most one MSS per ACK, so a single high bandwidth
+ * sample does not release a burst of the whole window at once.
+ */
+static void batadv_tp_rate_cong_avoid(struct batadv_tp_vars *tp_vars, u32 mss)
+{
+	struct batadv_tp_rate *rate = &tp_vars->cc.rate;
+	u32 cwnd = tp_vars->cwnd;
+	u64 bdp;
+
+	/* slow start until the first bandwidth sample is available */
+	if (!rate->btl_bw) {
+		tp_vars->cwnd = batadv_tp_cwnd(tp_vars->cwnd, mss, mss);
+		return;
+	}
+
+	bdp = div_u64(rate->btl_bw * max_t(u32, rate->min_rtt, 1),
+		      MSEC_PER_SEC);
+
+	/* leave room for delayed and aggregated ACKs */
+	bdp = min_t(u64, bdp * 2, BATADV_TP_AWND);
+	bdp = max_t(u64, bdp, mss * 4);
+
+	/* cwnd is at least mss * 4 and at most BATADV_TP_AWND */
+	if (cwnd < bdp)
+		cwnd = min_t(u64, cwnd + mss, bdp);
+	else
+		cwnd = max_t(u64, cwnd - mss, bdp);
+
+	tp_vars->cwnd = batadv_tp_cwnd(cwnd, 0, mss * 4);
+}
+
+/**
+ * batadv_tp_rate_ssthresh() - ignore losses
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * Losses on radio links are no reliable congestion signal. The sending rate is
+ * only limited by the pacing at the estimated bottleneck bandwidth.
+ *
+ * Return: the new slow start threshold
+ */
+static u32 batadv_tp_rate_ssthresh(struct batadv_tp_vars *tp_vars)
+{
+	return tp_vars->cwnd;
+}
+
+/**
+ * batadv_tp_rate_pacing_rate() - get the rate to pace the packets at
+ * @tp_vars: the private data of the current TP meter session
+ *
+ * Return: the pacing rate in bytes per second, 0 while not yet known
+ */
+static u64 batadv_tp_rate_pacing_rate(struct batadv_tp_vars *tp_vars)
+{
+	return tp_vars->cc.rate.pacing_rate;
+}
+
+static const struct batadv_tp_cc_ops batadv_tp_cc_rate = {
+	.name = "rate",
+	.init = batadv_tp_rate_init,
+	.cong_avoid = batadv_tp_rate_cong_avoid,
+	.ssthresh = batadv_tp_rate_ssthresh,
+	.pkts_acked = batadv_tp_rate_pkts_acked,
+	.pacing_rate = batadv_tp_rate_pacing_rate,
+};
+
+static const struct batadv_tp_cc_ops * const batadv_tp_cc[] = {
+	[BATADV_TP_CC_RENO] = &batadv_tp_cc_reno,
+	[BATADV_TP_CC_CUBIC] = &batadv_tp_cc_cubic,
+	[BATADV_TP_CC_RATE] = &batadv_tp_cc_rate,
+};
 
+/**
+ * batadv_tp_update_cwnd() - update the Congestion Windows
+ * @tp_vars: the private data of the current TP meter session
+ * @mss: maximum segment size of transmission
+ */
+static void batadv_tp_update_cwnd(struct batadv_tp_vars *tp_vars, u32 mss)
+{
+	spin_lock_bh(&tp_vars->cwnd_lock);
+	tp_vars->cc_ops->cong_avoid(tp_vars, mss);
 	spin_unlock_bh(&tp_vars->cwnd_lock);
 }
 
@@ -212,6 +583,148 @@ static void batadv_tp_update_rto(struct batadv_tp_vars *tp_vars,
 	tp_vars->rto = (tp_vars->srtt >> 3) + tp_vars->rttvar;
 }
 
+/**
+ * batadv_tp_lat_bucket() - get the latency histogram bucket of a RTT
+ * @rtt: the RTT in microseconds
+ *
+ * Values below 8 have their own bucket. Every larger power of two is split in
+ * 8 equally sized buckets, which limits the error to 12.5%.
+ *
+ * Return: index of the histogram bucket
+ */
+static unsigned int batadv_tp_lat_bucket(u32 rtt)
+{
+	unsigned int order;
+
+	if (rtt < 8)
+		return rtt;
+
+	order = fls(rtt) - 1;
+
+	return ((order - 2) << 3) | ((rtt >> (order - 3)) & 7);
+}
+
+/**
+ * batadv_tp_lat_bucket_value() - get the smallest RTT of a histogram bucket
+ * @bucket: index of the histogram bucket
+ *
+ * Return: the smallest RTT (in microseconds) counted in @bucket
+ */
+static u32 batadv_tp_lat_bucket_value(unsigned int bucket)
+{
+	if (bucket < 8)
+		return bucket;
+
+	return (8 | (bucket & 7)) << ((bucket >> 3) - 1);
+}
+
+/**
+ * batadv_tp_lat_percentile() - compute a percentile of the measured RTTs
+ * @latency: the latency probe state of the session
+ * @percent: the requested percentile
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (latency->lock) and only when at least one RTT was measured.
+ *
+ * Return: the percentile (in microseconds)
+ */
+static u32 batadv_tp_lat_percentile(struct batadv_tp_latency *latency,
+				    unsigned int percent)
+{
+	unsigned int bucket;
+	u64 target;
+	u64 count = 0;
+
+	target = div_u64((u64)latency->received * percent + 99, 100);
+
+	for (bucket = 0; bucket < BATADV_TP_LAT_BUCKETS - 1; bucket++) {
+		count += latency->hist[bucket];
+		if (count >= target)
+			break;
+	}
+
+	return clamp_t(u32, batadv_tp_lat_bucket_value(bucket), latency->min,
+		       latency->max);
+}
+
+/**
+ * batadv_tp_latency_summary() - summarize the latency probes of a session
+ * @latency: the latency probe state of the session
+ * @result: the summary to fill
+ */
+static void batadv_tp_latency_summary(struct batadv_tp_latency *latency,
+				      struct batadv_tp_lat_result *result)
+{
+	memset(result, 0, sizeof(*result));
+
+	spin_lock_bh(&latency->lock);
+	result->sent = latency->sent;
+	result->lost = latency->sent - latency->received;
+
+	if (latency->received) {
+		result->min = latency->min;
+		result->avg = div_u64(latency->sum, latency->received);
+		result->p50 = batadv_tp_lat_percentile(latency, 50);
+		result->p99 = batadv_tp_lat_percentile(latency, 99);
+		result->max = latency->max;
+		result->jitter = latency->jitter >> 4;
+	}
+	spin_unlock_bh(&latency->lock);
+}
+
+/**
+ * batadv_tp_latency_add() - account a measured RTT
+ * @bat_priv: the bat priv with all the soft interface information
+ * @latency: the latency probe state of the session
+ * @seqno: sequence number of the echoed probe
+ * @rtt: the measured RTT in microseconds
+ */
+static void batadv_tp_latency_add(struct batadv_priv *bat_priv,
+				  struct batadv_tp_latency *latency,
+				  u32 seqno, u32 rtt)
+{
+	s32 seq_diff;
+	u32 delta;
+
+	spin_lock_bh(&latency->lock);
+
+	/* ignore echoes of probes which were never sent */
+	if (seqno >= latency->sent || latency->received >= latency->sent)
+		goto unlock;
+
+	/* ignore duplicated echoes and echoes too late to tell them apart */
+	if (batadv_test_bit(latency->seqno_bits, latency->last_seqno, seqno))
+		goto unlock;
+
+	seq_diff = seqno - latency->last_seqno;
+	if (seq_diff <= -BATADV_TQ_LOCAL_WINDOW_SIZE)
+		goto unlock;
+
+	if (batadv_bit_get_packet(bat_priv, latency->seqno_bits, seq_diff, 1))
+		latency->last_seqno = seqno;
+
+	latency->received++;
+	latency->sum += rtt;
+	latency->min = min(latency->min, rtt);
+	latency->max = max(latency->max, rtt);
+	latency->hist[batadv_tp_lat_bucket(rtt)]++;
+
+	/* J = J + (|D| - J) / 16, Section 6.4.1 of RFC3550 */
+	if (latency->received > 1) {
+		if (rtt > latency->last)
+			delta = rtt - latency->last;
+		else
+			delta = latency->last - rtt;
+
+		latency->jitter += delta - (latency->jitter >> 4);
+	}
+
+	latency->last = rtt;
+
+unlock:
+	spin_unlock_bh(&latency->lock);
+}
+
 /**
  * batadv_tp_batctl_notify() - send client status result to client
  * @reason: reason for tp meter session stop
@@ -220,11 +733,15 @@ static void batadv_tp_update_rto(struct batadv_tp_vars *tp_vars,
  * @start_time: start of transmission in jiffies
  * @total_sent: bytes acked to the receiver
  * @cookie: cookie of tp_meter session
+ * @num_streams: number of parallel streams of the tp_meter session
+ * @stream: index (starting at 1) of the reported stream, 0 for the session
+ * @latency: result of the latency probes, NULL when not available
  */
-static void batadv_tp_batctl_notify(enum batadv_tp_meter_reason reason,
-				    const u8 *dst, struct batadv_priv *bat_priv,
-				    unsigned long start_time, u64 total_sent,
-				    u32 cookie)
+static void
+batadv_tp_batctl_notify(enum batadv_tp_meter_reason reason, const u8 *dst,
+			struct batadv_priv *bat_priv, unsigned long start_time,
+			u64 total_sent, u32 cookie, u8 num_streams, u8 stream,
+			const struct batadv_tp_lat_result *latency)
 {
 	u32 test_time;
 	u8 result;
@@ -238,10 +755,12 @@ static void batadv_tp_batctl_notify(enum batadv_tp_meter_reason reason,
 		result = reason;
 		test_time = 0;
 		total_bytes = 0;
+		latency = NULL;
 	}
 
 	batadv_netlink_tpmeter_notify(bat_priv, dst, result, test_time,
-				      total_bytes, cookie);
+				      total_bytes, cookie, num_streams, stream,
+				      latency);
 }
 
 /**
@@ -256,7 +775,8 @@ static void batadv_tp_batctl_error_notify(enum batadv_tp_meter_reason reason,
 					  struct batadv_priv *bat_priv,
 					  u32 cookie)
 {
-	batadv_tp_batctl_notify(reason, dst, bat_priv, 0, 0, cookie);
+	batadv_tp_batctl_notify(reason, dst, bat_priv, 0, 0, cookie, 1, 0,
+				NULL);
 }
 
 /**
@@ -358,6 +878,7 @@ static void batadv_tp_vars_release(struct kref *ref)
 	}
 	spin_unlock_bh(&tp_vars->unacked_lock);
 
+	kfree(tp_vars->latency);
 	kfree_rcu(tp_vars, rcu);
 }
 
@@ -388,8 +909,6 @@ static void batadv_tp_sender_cleanup(struct batadv_priv *bat_priv,
 	/* drop list reference */
 	batadv_tp_vars_put(tp_vars);
 
-	atomic_dec(&tp_vars->bat_priv->tp_num);
-
 	/* kill the timer and remove its reference */
 	del_timer_sync(&tp_vars->timer);
 	/* the worker might have rearmed itself therefore we kill it again. Note
@@ -402,14 +921,21 @@ static void batadv_tp_sender_cleanup(struct batadv_priv *bat_priv,
 }
 
 /**
- * batadv_tp_sender_end() - print info about ended session and inform client
+ * batadv_tp_sender_end() - print info about ended stream and inform client
  * @bat_priv: the bat priv with all the soft interface information
- * @tp_vars: the private data of the current TP meter session
+ * @tp_vars: the private data of the current TP meter session stream
+ *
+ * The result of each stream is reported separately if the session consists of
+ * multiple streams. The probe stream adds its latency result to the session.
+ * The last finishing stream reports the result of the whole session and
+ * releases it.
  */
 static void batadv_tp_sender_end(struct batadv_priv *bat_priv,
 				 struct batadv_tp_vars *tp_vars)
 {
-	u32 session_cookie;
+	struct batadv_tp_group *group = tp_vars->group;
+	u64 tot_sent = atomic64_read(&tp_vars->tot_sent);
+	struct batadv_tp_lat_result latency;
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 		   "Test towards %pM finished..shutting down (reason=%d)\n",
@@ -423,15 +949,37 @@ static void batadv_tp_sender_end(struct batadv_priv *bat_priv,
 		   "Final values: cwnd=%u ss_threshold=%u\n",
 		   tp_vars->cwnd, tp_vars->ss_threshold);
 
-	session_cookie = batadv_tp_session_cookie(tp_vars->session,
-						  tp_vars->icmp_uid);
+	if (tp_vars->latency)
+		batadv_tp_latency_summary(tp_vars->latency, &latency);
+	else if (group->num_streams > 1)
+		batadv_tp_batctl_notify(tp_vars->reason, tp_vars->other_end,
+					bat_priv, tp_vars->start_time,
+					tot_sent, group->cookie,
+					group->num_streams, tp_vars->stream,
+					NULL);
+
+	spin_lock_bh(&group->lock);
+	if (tp_vars->latency)
+		group->latency = latency;
+
+	if (!batadv_tp_is_error(tp_vars->reason)) {
+		group->tot_sent += tot_sent;
+		group->reason = tp_vars->reason;
+	} else if (batadv_tp_is_error(group->reason)) {
+		group->reason = tp_vars->reason;
+	}
+	spin_unlock_bh(&group->lock);
+
+	if (!atomic_dec_and_test(&group->active))
+		return;
+
+	batadv_tp_batctl_notify(group->reason, group->other_end, bat_priv,
+				group->start_time, group->tot_sent,
+				group->cookie, group->num_streams, 0,
+				group->probing ? &group->latency : NULL);
 
-	batadv_tp_batctl_notify(tp_vars->reason,
-				tp_vars->other_end,
-				bat_priv,
-				tp_vars->start_time,
-				atomic64_read(&tp_vars->tot_sent),
-				session_cookie);
+	atomic_dec(&bat_priv->tp_num);
+	kfree(group);
 }
 
 /**
@@ -487,8 +1035,8 @@ static void batadv_tp_reset_sender_timer(struct batadv_tp_vars *tp_vars)
  * @t: address to timer_list inside tp_vars
  *
  * If fired it means that there was packet loss.
- * Switch to Slow Start, set the ss_threshold to half of the current cwnd and
- * reset the cwnd to 3*MSS
+ * Switch to Slow Start, let the congestion control set the ss_threshold (half
+ * of the current cwnd for Reno) and reset the cwnd to 3*MSS
  */
 static void batadv_tp_sender_timeout(struct timer_list *t)
 {
@@ -512,7 +1060,7 @@ static void batadv_tp_sender_timeout(struct timer_list *t)
 
 	spin_lock_bh(&tp_vars->cwnd_lock);
 
-	tp_vars->ss_threshold = tp_vars->cwnd >> 1;
+	tp_vars->ss_threshold = tp_vars->cc_ops->ssthresh(tp_vars);
 	if (tp_vars->ss_threshold < BATADV_TP_PLEN * 2)
 		tp_vars->ss_threshold = BATADV_TP_PLEN * 2;
 
@@ -639,7 +1187,7 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 	const struct batadv_icmp_tp_packet *icmp;
 	struct batadv_tp_vars *tp_vars;
 	size_t packet_len, mss;
-	u32 rtt, recv_ack, cwnd;
+	u32 rtt, recv_ack, cwnd, acked;
 	unsigned char *dev_addr;
 
 	packet_len = BATADV_TP_PLEN;
@@ -672,7 +1220,10 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 
 	/* update RTO with the new sampled RTT, if any */
 	rtt = jiffies_to_msecs(jiffies) - ntohl(icmp->timestamp);
-	if (icmp->timestamp && rtt)
+	if (!icmp->timestamp)
+		rtt = 0;
+
+	if (rtt)
 		batadv_tp_update_rto(tp_vars, rtt);
 
 	/* ACK for new data... reset the timer */
@@ -703,7 +1254,7 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 		 * is entered. RFC6582, Section 3.2, step 1
 		 */
 		tp_vars->recover = tp_vars->last_sent;
-		tp_vars->ss_threshold = tp_vars->cwnd >> 1;
+		tp_vars->ss_threshold = tp_vars->cc_ops->ssthresh(tp_vars);
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Meter: Fast Recovery, (cur cwnd=%u) ss_thr=%u last_sent=%u recv_ack=%u\n",
 			   tp_vars->cwnd, tp_vars->ss_threshold,
@@ -716,8 +1267,15 @@ static void batadv_tp_recv_ack(struct batadv_priv *bat_priv,
 		spin_unlock_bh(&tp_vars->cwnd_lock);
 	} else {
 		/* count the acked data */
-		atomic64_add(recv_ack - atomic_read(&tp_vars->last_acked),
-			     &tp_vars->tot_sent);
+		acked = recv_ack - atomic_read(&tp_vars->last_acked);
+		atomic64_add(acked, &tp_vars->tot_sent);
+
+		if (tp_vars->cc_ops->pkts_acked) {
+			spin_lock_bh(&tp_vars->cwnd_lock);
+			tp_vars->cc_ops->pkts_acked(tp_vars, acked, rtt);
+			spin_unlock_bh(&tp_vars->cwnd_lock);
+		}
+
 		/* reset the duplicate ACKs counter */
 		atomic_set(&tp_vars->dup_acks, 0);
 
@@ -806,6 +1364,51 @@ static int batadv_tp_wait_available(struct batadv_tp_vars *tp_vars, size_t plen)
 	return ret;
 }
 
+/**
+ * batadv_tp_pace() - delay the next packet according to the pacing rate
+ * @tp_vars: the private data of the current TP meter session
+ * @len: length of the packet which was just sent
+ *
+ * Only congestion control algorithms with a pacing_rate callback pace the
+ * packets. Small bursts within BATADV_TP_PACING_SLACK are allowed to avoid
+ * sleeping after every packet. Long delays of low rates are slept in steps of
+ * BATADV_TP_PACING_MAX_SLEEP to notice a stopped session in time.
+ */
+static void batadv_tp_pace(struct batadv_tp_vars *tp_vars, size_t len)
+{
+	u64 rate, now;
+	u32 delay;
+
+	if (!tp_vars->cc_ops->pacing_rate)
+		return;
+
+	spin_lock_bh(&tp_vars->cwnd_lock);
+	rate = tp_vars->cc_ops->pacing_rate(tp_vars);
+	spin_unlock_bh(&tp_vars->cwnd_lock);
+
+	if (!rate)
+		return;
+
+	now = ktime_get_ns();
+
+	/* don't save up sending credit while the window was full */
+	if (tp_vars->pacing_next < now)
+		tp_vars->pacing_next = now;
+
+	tp_vars->pacing_next += div64_u64((u64)len * NSEC_PER_SEC, rate);
+
+	while (atomic_read(&tp_vars->sending) != 0) {
+		now = ktime_get_ns();
+		if (tp_vars->pacing_next <= now + BATADV_TP_PACING_SLACK)
+			break;
+
+		delay = div_u64(min_t(u64, tp_vars->pacing_next - now,
+				      BATADV_TP_PACING_MAX_SLEEP),
+				NSEC_PER_USEC);
+		usleep_range(delay, delay + USEC_PER_MSEC / 10);
+	}
+}
+
 /**
  * batadv_tp_send() - main sending thread of a tp meter session
  * @arg: address of the related tp_vars
@@ -885,8 +1488,10 @@ static int batadv_tp_send(void *arg)
 		}
 
 		/* right-shift the TWND */
-		if (!err)
+		if (!err) {
 			tp_vars->last_sent += payload_len;
+			batadv_tp_pace(tp_vars, packet_len);
+		}
 
 		cond_resched();
 	}
@@ -906,25 +1511,162 @@ static int batadv_tp_send(void *arg)
 }
 
 /**
- * batadv_tp_start_kthread() - start new thread which manages the tp meter
- *  sender
- * @tp_vars: the private data of the current TP meter session
+ * batadv_tp_send_probe() - send a single latency probe
+ * @tp_vars: the private TP meter data for the probe stream
+ * @src: source mac address
+ * @orig_node: the originator of the destination
+ *
+ * Return: 0 on success, BATADV_TP_REASON_CANT_SEND if the probe could not be
+ * sent, BATADV_TP_REASON_MEMORY_ERROR if the packet couldn't be allocated
  */
-static void batadv_tp_start_kthread(struct batadv_tp_vars *tp_vars)
+static int batadv_tp_send_probe(struct batadv_tp_vars *tp_vars, const u8 *src,
+				struct batadv_orig_node *orig_node)
 {
-	struct task_struct *kthread;
+	struct batadv_tp_latency *latency = tp_vars->latency;
+	struct batadv_icmp_tp_packet *icmp;
+	struct sk_buff *skb;
+	u32 seqno;
+	int r;
+
+	skb = netdev_alloc_skb_ip_align(NULL, sizeof(*icmp) + ETH_HLEN);
+	if (unlikely(!skb))
+		return BATADV_TP_REASON_MEMORY_ERROR;
+
+	skb_reserve(skb, ETH_HLEN);
+	icmp = skb_put(skb, sizeof(*icmp));
+
+	ether_addr_copy(icmp->dst, orig_node->orig);
+	ether_addr_copy(icmp->orig, src);
+	icmp->version = BATADV_COMPAT_VERSION;
+	icmp->packet_type = BATADV_ICMP;
+	icmp->ttl = BATADV_TTL;
+	icmp->msg_type = BATADV_TP;
+	icmp->uid = tp_vars->icmp_uid;
+
+	spin_lock_bh(&latency->lock);
+	seqno = latency->sent++;
+	spin_unlock_bh(&latency->lock);
+
+	icmp->subtype = BATADV_TP_PROBE;
+	memcpy(icmp->session, tp_vars->session, sizeof(icmp->session));
+	icmp->seqno = htonl(seqno);
+	icmp->timestamp = htonl((u32)ktime_to_us(ktime_get()));
+
+	r = batadv_send_skb_to_orig(skb, orig_node, NULL);
+	if (r == NET_XMIT_SUCCESS)
+		return 0;
+
+	return BATADV_TP_REASON_CANT_SEND;
+}
+
+/**
+ * batadv_tp_probe() - main probing thread of a tp meter session
+ * @arg: address of the related tp_vars
+ *
+ * Sends a probe every latency->interval milliseconds until the session is
+ * stopped. The receiver echoes each probe back immediately, the RTT is
+ * measured by batadv_tp_recv_probe_ack().
+ *
+ * Return: nothing, this function never returns
+ */
+static int batadv_tp_probe(void *arg)
+{
+	struct batadv_tp_vars *tp_vars = arg;
+	struct batadv_tp_latency *latency = tp_vars->latency;
 	struct batadv_priv *bat_priv = tp_vars->bat_priv;
-	u32 session_cookie;
+	struct batadv_hard_iface *primary_if = NULL;
+	struct batadv_orig_node *orig_node = NULL;
+	unsigned long interval;
+	unsigned int grace;
+	int err;
+
+	orig_node = batadv_orig_hash_find(bat_priv, tp_vars->other_end);
+	if (unlikely(!orig_node)) {
+		tp_vars->reason = BATADV_TP_REASON_DST_UNREACHABLE;
+		goto out;
+	}
+
+	primary_if = batadv_primary_if_get_selected(bat_priv);
+	if (unlikely(!primary_if)) {
+		tp_vars->reason = BATADV_TP_REASON_DST_UNREACHABLE;
+		goto out;
+	}
+
+	/* queue the worker in charge of terminating the test */
+	queue_delayed_work(batadv_event_workqueue, &tp_vars->finish_work,
+			   msecs_to_jiffies(tp_vars->test_length));
+
+	interval = latency->interval * USEC_PER_MSEC;
+
+	while (atomic_read(&tp_vars->sending) != 0) {
+		err = batadv_tp_send_probe(tp_vars,
+					   primary_if->net_dev->dev_addr,
+					   orig_node);
+
+		/* something went wrong during the preparation/transmission */
+		if (unlikely(err && err != BATADV_TP_REASON_CANT_SEND)) {
+			batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+				   "Meter: %s() cannot send probes (%d)\n",
+				   __func__, err);
+			/* ensure nobody else tries to stop the thread now */
+			if (atomic_dec_and_test(&tp_vars->sending))
+				tp_vars->reason = err;
+			break;
+		}
+
+		if (latency->interval > BATADV_TP_PROBE_MAX_USLEEP)
+			msleep_interruptible(latency->interval);
+		else
+			usleep_range(interval, interval + interval / 8);
+	}
+
+	/* give the echoes of the last probes a chance to arrive */
+	spin_lock_bh(&latency->lock);
+	grace = DIV_ROUND_UP(latency->max, USEC_PER_MSEC) * 2;
+	spin_unlock_bh(&latency->lock);
+
+	msleep(min_t(unsigned int, grace, BATADV_TP_RECV_TIMEOUT));
+
+	/* not a single probe came back */
+	if (!batadv_tp_is_error(tp_vars->reason) &&
+	    !READ_ONCE(latency->received))
+		tp_vars->reason = BATADV_TP_REASON_DST_UNREACHABLE;
+
+out:
+	if (likely(primary_if))
+		batadv_hardif_put(primary_if);
+	if (likely(orig_node))
+		batadv_orig_node_put(orig_node);
+
+	batadv_tp_sender_end(bat_priv, tp_vars);
+	batadv_tp_sender_cleanup(bat_priv, tp_vars);
+
+	batadv_tp_vars_put(tp_vars);
+
+	do_exit(0);
+}
+
+/**
+ * batadv_tp_start_kthread() - start new thread which manages the tp meter
+ *  sender
+ * @tp_vars: the private data of the current TP meter session stream
+ * @cpu: cpu the thread is bound to, negative to let the scheduler choose
+ */
+static void batadv_tp_start_kthread(struct batadv_tp_vars *tp_vars, int cpu)
+{
+	int (*threadfn)(void *data) = batadv_tp_send;
+	struct task_struct *kthread;
+	struct batadv_priv *bat_priv = tp_vars->bat_priv;
+
+	if (tp_vars->latency)
+		threadfn = batadv_tp_probe;
 
 	kref_get(&tp_vars->refcount);
-	kthread = kthread_create(batadv_tp_send, tp_vars, "kbatadv_tp_meter");
+	kthread = kthread_create(threadfn, tp_vars, "kbatadv_tp_meter");
 	if (IS_ERR(kthread)) {
-		session_cookie = batadv_tp_session_cookie(tp_vars->session,
-							  tp_vars->icmp_uid);
 		pr_err("batadv: cannot create tp meter kthread\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_MEMORY_ERROR,
-					      tp_vars->other_end,
-					      bat_priv, session_cookie);
+		tp_vars->reason = BATADV_TP_REASON_MEMORY_ERROR;
+		batadv_tp_sender_end(bat_priv, tp_vars);
 
 		/* drop reserved reference for kthread */
 		batadv_tp_vars_put(tp_vars);
@@ -934,69 +1676,67 @@ static void batadv_tp_start_kthread(struct batadv_tp_vars *tp_vars)
 		return;
 	}
 
+	if (cpu >= 0)
+		kthread_bind(kthread, cpu);
+
 	wake_up_process(kthread);
 }
 
 /**
- * batadv_tp_start() - start a new tp meter session
+ * batadv_tp_sender_init() - allocate and initialize a new tp meter stream
  * @bat_priv: the bat priv with all the soft interface information
- * @dst: the receiver MAC address
+ * @group: the session the new stream is part of
+ * @session_id: the session identifier of the new stream
+ * @icmp_uid: local ICMP "socket" index
  * @test_length: test length in milliseconds
- * @cookie: session cookie
+ * @stream: index (starting at 1) of the new stream in @group, 0 for the probe
+ *  stream
+ * @probe_interval: interval between two latency probes in milliseconds, 0 for
+ *  a throughput stream
+ * @cc: congestion control algorithm (see batadv_tp_meter_cc)
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (tp_list_lock).
+ *
+ * Return: the new stream (with increased refcnt), NULL on errors
  */
-void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
-		     u32 test_length, u32 *cookie)
+static struct batadv_tp_vars *
+batadv_tp_sender_init(struct batadv_priv *bat_priv,
+		      struct batadv_tp_group *group, const u8 *session_id,
+		      u8 icmp_uid, u32 test_length, u8 stream,
+		      u32 probe_interval, u8 cc)
 {
 	struct batadv_tp_vars *tp_vars;
-	u8 session_id[2];
-	u8 icmp_uid;
-	u32 session_cookie;
 
-	get_random_bytes(session_id, sizeof(session_id));
-	get_random_bytes(&icmp_uid, 1);
-	session_cookie = batadv_tp_session_cookie(session_id, icmp_uid);
-	*cookie = session_cookie;
-
-	/* look for an already existing test towards this node */
-	spin_lock_bh(&bat_priv->tp_list_lock);
-	tp_vars = batadv_tp_list_find(bat_priv, dst);
-	if (tp_vars) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_tp_vars_put(tp_vars);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: test to or from the same node already ongoing, aborting\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_ALREADY_ONGOING,
-					      dst, bat_priv, session_cookie);
-		return;
-	}
-
-	if (!atomic_add_unless(&bat_priv->tp_num, 1, BATADV_TP_MAX_NUM)) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: too many ongoing sessions, aborting (SEND)\n");
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_TOO_MANY, dst,
-					      bat_priv, session_cookie);
-		return;
-	}
+	lockdep_assert_held(&bat_priv->tp_list_lock);
 
 	tp_vars = kmalloc(sizeof(*tp_vars), GFP_ATOMIC);
-	if (!tp_vars) {
-		spin_unlock_bh(&bat_priv->tp_list_lock);
-		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-			   "Meter: %s cannot allocate list elements\n",
-			   __func__);
-		batadv_tp_batctl_error_notify(BATADV_TP_REASON_MEMORY_ERROR,
-					      dst, bat_priv, session_cookie);
-		return;
+	if (!tp_vars)
+		return NULL;
+
+	tp_vars->latency = NULL;
+	if (probe_interval) {
+		tp_vars->latency = kzalloc(sizeof(*tp_vars->latency),
+					   GFP_ATOMIC);
+		if (!tp_vars->latency) {
+			kfree(tp_vars);
+			return NULL;
+		}
+
+		tp_vars->latency->interval = probe_interval;
+		tp_vars->latency->min = U32_MAX;
+		spin_lock_init(&tp_vars->latency->lock);
 	}
 
 	/* initialize tp_vars */
-	ether_addr_copy(tp_vars->other_end, dst);
+	ether_addr_copy(tp_vars->other_end, group->other_end);
 	kref_init(&tp_vars->refcount);
 	tp_vars->role = BATADV_TP_SENDER;
 	atomic_set(&tp_vars->sending, 1);
-	memcpy(tp_vars->session, session_id, sizeof(session_id));
+	memcpy(tp_vars->session, session_id, sizeof(tp_vars->session));
 	tp_vars->icmp_uid = icmp_uid;
+	tp_vars->group = group;
+	tp_vars->stream = stream;
 
 	tp_vars->last_sent = BATADV_TP_FIRST_SEQ;
 	atomic_set(&tp_vars->last_acked, BATADV_TP_FIRST_SEQ);
@@ -1035,31 +1775,176 @@ void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
 
 	spin_lock_init(&tp_vars->cwnd_lock);
 
+	tp_vars->cc_ops = batadv_tp_cc[cc];
+	if (tp_vars->cc_ops->init)
+		tp_vars->cc_ops->init(tp_vars);
+	tp_vars->pacing_next = 0;
+
 	tp_vars->prerandom_offset = 0;
 	spin_lock_init(&tp_vars->prerandom_lock);
 
-	kref_get(&tp_vars->refcount);
-	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
-	spin_unlock_bh(&bat_priv->tp_list_lock);
-
 	tp_vars->test_length = test_length;
 	if (!tp_vars->test_length)
 		tp_vars->test_length = BATADV_TP_DEF_TEST_LENGTH;
 
-	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
-		   "Meter: starting throughput meter towards %pM (length=%ums)\n",
-		   dst, test_length);
-
 	/* init work item for finished tp tests */
 	INIT_DELAYED_WORK(&tp_vars->finish_work, batadv_tp_sender_finish);
 
-	/* start tp kthread. This way the write() call issued from userspace can
-	 * happily return and avoid to block
+	kref_get(&tp_vars->refcount);
+	hlist_add_head_rcu(&tp_vars->list, &bat_priv->tp_list);
+
+	return tp_vars;
+}
+
+/**
+ * batadv_tp_start() - start a new tp meter session
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst: the receiver MAC address
+ * @test_length: test length in milliseconds
+ * @num_streams: number of parallel streams
+ * @probe_interval: interval between two latency probes in milliseconds, 0 to
+ *  disable the latency measurement
+ * @cc: congestion control algorithm of the throughput streams (see
+ *  batadv_tp_meter_cc)
+ * @cookie: session cookie
+ *
+ * Each stream of a session is an independent tp meter connection with its own
+ * sender thread. The threads of a multi stream session are spread over the
+ * online cpus.
+ *
+ * The latency is measured by an additional probe stream which sends small
+ * probes at a fixed interval next to the (optional) throughput streams. This
+ * shows the queueing delay caused by the throughput streams.
+ */
+void batadv_tp_start(struct batadv_priv *bat_priv, const u8 *dst,
+		     u32 test_length, u8 num_streams, u32 probe_interval,
+		     u8 cc, u32 *cookie)
+{
+	struct batadv_tp_vars *streams[BATADV_TP_MAX_STREAMS + 1];
+	struct batadv_tp_group *group;
+	struct batadv_tp_vars *tp_vars;
+	u8 session_id[2];
+	u8 icmp_uid;
+	u32 session_cookie;
+	u8 num_started;
+	int cpu = -1;
+	u8 i;
+
+	get_random_bytes(session_id, sizeof(session_id));
+	get_random_bytes(&icmp_uid, 1);
+	session_cookie = batadv_tp_session_cookie(session_id, icmp_uid);
+	*cookie = session_cookie;
+
+	num_streams = min_t(u8, num_streams, BATADV_TP_MAX_STREAMS);
+	if (cc >= ARRAY_SIZE(batadv_tp_cc))
+		cc = BATADV_TP_CC_RENO;
+
+	/* look for an already existing test towards this node */
+	spin_lock_bh(&bat_priv->tp_list_lock);
+	tp_vars = batadv_tp_list_find(bat_priv, dst);
+	if (tp_vars) {
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+		batadv_tp_vars_put(tp_vars);
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: test to or from the same node already ongoing, aborting\n");
+		batadv_tp_batctl_error_notify(BATADV_TP_REASON_ALREADY_ONGOING,
+					      dst, bat_priv, session_cookie);
+		return;
+	}
+
+	if (!atomic_add_unless(&bat_priv->tp_num, 1, BATADV_TP_MAX_NUM)) {
+		spin_unlock_bh(&bat_priv->tp_list_lock);
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: too many ongoing sessions, aborting (SEND)\n");
+		batadv_tp_batctl_error_notify(BATADV_TP_REASON_TOO_MANY, dst,
+					      bat_priv, session_cookie);
+		return;
+	}
+
+	group = kmalloc(sizeof(*group), GFP_ATOMIC);
+	if (!group)
+		goto err_alloc;
+
+	ether_addr_copy(group->other_end, dst);
+	group->cookie = session_cookie;
+	group->start_time = jiffies;
+	group->tot_sent = 0;
+	/* replaced by the reason of the first finished stream */
+	group->reason = BATADV_TP_REASON_DST_UNREACHABLE;
+	group->probing = false;
+	spin_lock_init(&group->lock);
+
+	/* the streams only differ in the second byte of their session id */
+	for (i = 0; i < num_streams; i++) {
+		streams[i] = batadv_tp_sender_init(bat_priv, group, session_id,
+						   icmp_uid, test_length,
+						   i + 1, 0, cc);
+		if (!streams[i])
+			break;
+
+		session_id[1]++;
+	}
+
+	num_started = i;
+	group->num_streams = num_started;
+
+	if (probe_interval) {
+		tp_vars = batadv_tp_sender_init(bat_priv, group, session_id,
+						icmp_uid, test_length, 0,
+						probe_interval, cc);
+		if (tp_vars) {
+			streams[num_started++] = tp_vars;
+			group->probing = true;
+		}
+	}
+
+	atomic_set(&group->active, num_started);
+
+	if (!num_started) {
+		kfree(group);
+		goto err_alloc;
+	}
+
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+
+	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+		   "Meter: starting throughput meter towards %pM (length=%ums, streams=%u, cc=%s, probe interval=%ums)\n",
+		   dst, test_length, group->num_streams, batadv_tp_cc[cc]->name,
+		   probe_interval);
+
+	/* start tp kthreads. This way the write() call issued from userspace
+	 * can happily return and avoid to block.
+	 *
+	 * The group may already be gone once the last stream was started
 	 */
-	batadv_tp_start_kthread(tp_vars);
+	if (num_started > 1)
+		get_online_cpus();
+
+	for (i = 0; i < num_started; i++) {
+		if (num_started > 1) {
+			cpu = cpumask_next(cpu, cpu_online_mask);
+			if (cpu >= nr_cpu_ids)
+				cpu = cpumask_first(cpu_online_mask);
+		}
 
-	/* don't return reference to new tp_vars */
-	batadv_tp_vars_put(tp_vars);
+		batadv_tp_start_kthread(streams[i], cpu);
+
+		/* don't return reference to new tp_vars */
+		batadv_tp_vars_put(streams[i]);
+	}
+
+	if (num_started > 1)
+		put_online_cpus();
+
+	return;
+
+err_alloc:
+	atomic_dec(&bat_priv->tp_num);
+	spin_unlock_bh(&bat_priv->tp_list_lock);
+	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+		   "Meter: %s cannot allocate list elements\n", __func__);
+	batadv_tp_batctl_error_notify(BATADV_TP_REASON_MEMORY_ERROR, dst,
+				      bat_priv, session_cookie);
 }
 
 /**
@@ -1073,6 +1958,7 @@ void batadv_tp_stop(struct batadv_priv *bat_priv, const u8 *dst,
 {
 	struct batadv_orig_node *orig_node;
 	struct batadv_tp_vars *tp_vars;
+	bool found = false;
 
 	batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 		   "Meter: stopping test towards %pM\n", dst);
@@ -1081,16 +1967,24 @@ void batadv_tp_stop(struct batadv_priv *bat_priv, const u8 *dst,
 	if (!orig_node)
 		return;
 
-	tp_vars = batadv_tp_list_find(bat_priv, orig_node->orig);
-	if (!tp_vars) {
+	/* stop all streams of the session */
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(tp_vars, &bat_priv->tp_list, list) {
+		if (tp_vars->role != BATADV_TP_SENDER)
+			continue;
+
+		if (!batadv_compare_eth(tp_vars->other_end, orig_node->orig))
+			continue;
+
+		batadv_tp_sender_shutdown(tp_vars, return_value);
+		found = true;
+	}
+	rcu_read_unlock();
+
+	if (!found)
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Meter: trying to interrupt an already over connection\n");
-		goto out;
-	}
 
-	batadv_tp_sender_shutdown(tp_vars, return_value);
-	batadv_tp_vars_put(tp_vars);
-out:
 	batadv_orig_node_put(orig_node);
 }
 
@@ -1106,6 +2000,41 @@ static void batadv_tp_reset_receiver_timer(struct batadv_tp_vars *tp_vars)
 		  jiffies + msecs_to_jiffies(BATADV_TP_RECV_TIMEOUT));
 }
 
+/**
+ * batadv_tp_receiver_count() - count the streams received from a node
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig: the sender of the streams
+ *
+ * All streams received from the same node belong to the same session (a node
+ * only runs a single session towards another node) and share its slot in
+ * tp_num.
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (tp_list_lock).
+ *
+ * Return: number of receiving tp_vars for streams from @orig
+ */
+static unsigned int batadv_tp_receiver_count(struct batadv_priv *bat_priv,
+					     const u8 *orig)
+{
+	struct batadv_tp_vars *tp_vars;
+	unsigned int count = 0;
+
+	lockdep_assert_held(&bat_priv->tp_list_lock);
+
+	hlist_for_each_entry(tp_vars, &bat_priv->tp_list, list) {
+		if (tp_vars->role != BATADV_TP_RECEIVER)
+			continue;
+
+		if (!batadv_compare_eth(tp_vars->other_end, orig))
+			continue;
+
+		count++;
+	}
+
+	return count;
+}
+
 /**
  * batadv_tp_receiver_shutdown() - stop a tp meter receiver when timeout is
  *  reached without received ack
@@ -1133,13 +2062,15 @@ static void batadv_tp_receiver_shutdown(struct timer_list *t)
 
 	spin_lock_bh(&tp_vars->bat_priv->tp_list_lock);
 	hlist_del_rcu(&tp_vars->list);
+
+	/* the last stream of a session releases its slot */
+	if (!batadv_tp_receiver_count(bat_priv, tp_vars->other_end))
+		atomic_dec(&bat_priv->tp_num);
 	spin_unlock_bh(&tp_vars->bat_priv->tp_list_lock);
 
 	/* drop list reference */
 	batadv_tp_vars_put(tp_vars);
 
-	atomic_dec(&bat_priv->tp_num);
-
 	spin_lock_bh(&tp_vars->unacked_lock);
 	list_for_each_entry_safe(un, safe, &tp_vars->unacked_list, list) {
 		list_del(&un->list);
@@ -1155,6 +2086,7 @@ static void batadv_tp_receiver_shutdown(struct timer_list *t)
  * batadv_tp_send_ack() - send an ACK packet
  * @bat_priv: the bat priv with all the soft interface information
  * @dst: the mac address of the destination originator
+ * @subtype: BATADV_TP_ACK or BATADV_TP_PROBE_ACK
  * @seq: the sequence number to ACK
  * @timestamp: the timestamp to echo back in the ACK
  * @session: session identifier
@@ -1164,8 +2096,8 @@ static void batadv_tp_receiver_shutdown(struct timer_list *t)
  * failure otherwise
  */
 static int batadv_tp_send_ack(struct batadv_priv *bat_priv, const u8 *dst,
-			      u32 seq, __be32 timestamp, const u8 *session,
-			      int socket_index)
+			      u8 subtype, u32 seq, __be32 timestamp,
+			      const u8 *session, int socket_index)
 {
 	struct batadv_hard_iface *primary_if = NULL;
 	struct batadv_orig_node *orig_node;
@@ -1201,7 +2133,7 @@ static int batadv_tp_send_ack(struct batadv_priv *bat_priv, const u8 *dst,
 	ether_addr_copy(icmp->orig, primary_if->net_dev->dev_addr);
 	icmp->uid = socket_index;
 
-	icmp->subtype = BATADV_TP_ACK;
+	icmp->subtype = subtype;
 	memcpy(icmp->session, session, sizeof(icmp->session));
 	icmp->seqno = htonl(seq);
 	icmp->timestamp = timestamp;
@@ -1344,6 +2276,7 @@ batadv_tp_init_recv(struct batadv_priv *bat_priv,
 		    const struct batadv_icmp_tp_packet *icmp)
 {
 	struct batadv_tp_vars *tp_vars;
+	unsigned int num_streams;
 
 	spin_lock_bh(&bat_priv->tp_list_lock);
 	tp_vars = batadv_tp_list_find_session(bat_priv, icmp->orig,
@@ -1351,18 +2284,31 @@ batadv_tp_init_recv(struct batadv_priv *bat_priv,
 	if (tp_vars)
 		goto out_unlock;
 
-	if (!atomic_add_unless(&bat_priv->tp_num, 1, BATADV_TP_MAX_NUM)) {
+	num_streams = batadv_tp_receiver_count(bat_priv, icmp->orig);
+	if (num_streams >= BATADV_TP_MAX_STREAMS) {
+		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
+			   "Meter: too many streams from %pM, aborting (RECV)\n",
+			   icmp->orig);
+		goto out_unlock;
+	}
+
+	if (!num_streams &&
+	    !atomic_add_unless(&bat_priv->tp_num, 1, BATADV_TP_MAX_NUM)) {
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Meter: too many ongoing sessions, aborting (RECV)\n");
 		goto out_unlock;
 	}
 
 	tp_vars = kmalloc(sizeof(*tp_vars), GFP_ATOMIC);
-	if (!tp_vars)
+	if (!tp_vars) {
+		if (!num_streams)
+			atomic_dec(&bat_priv->tp_num);
 		goto out_unlock;
+	}
 
 	ether_addr_copy(tp_vars->other_end, icmp->orig);
 	tp_vars->role = BATADV_TP_RECEIVER;
+	tp_vars->latency = NULL;
 	memcpy(tp_vars->session, icmp->session, sizeof(tp_vars->session));
 	tp_vars->last_recv = BATADV_TP_FIRST_SEQ;
 	tp_vars->bat_priv = bat_priv;
@@ -1463,13 +2409,62 @@ static void batadv_tp_recv_msg(struct batadv_priv *bat_priv,
 	 * is going to be sent is a duplicate (the sender will count them and
 	 * possibly enter Fast Retransmit as soon as it has reached 3)
 	 */
-	batadv_tp_send_ack(bat_priv, icmp->orig, tp_vars->last_recv,
-			   icmp->timestamp, icmp->session, icmp->uid);
+	batadv_tp_send_ack(bat_priv, icmp->orig, BATADV_TP_ACK,
+			   tp_vars->last_recv, icmp->timestamp, icmp->session,
+			   icmp->uid);
 out:
 	if (likely(tp_vars))
 		batadv_tp_vars_put(tp_vars);
 }
 
+/**
+ * batadv_tp_recv_probe() - echo a latency probe back to its sender
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the buffer containing the received packet
+ *
+ * Probes are answered without keeping any state on the receiver side.
+ */
+static void batadv_tp_recv_probe(struct batadv_priv *bat_priv,
+				 const struct sk_buff *skb)
+{
+	const struct batadv_icmp_tp_packet *icmp;
+
+	icmp = (struct batadv_icmp_tp_packet *)skb->data;
+
+	batadv_tp_send_ack(bat_priv, icmp->orig, BATADV_TP_PROBE_ACK,
+			   ntohl(icmp->seqno), icmp->timestamp, icmp->session,
+			   icmp->uid);
+}
+
+/**
+ * batadv_tp_recv_probe_ack() - process an echoed latency probe
+ * @bat_priv: the bat priv with all the soft interface information
+ * @skb: the buffer containing the received packet
+ */
+static void batadv_tp_recv_probe_ack(struct batadv_priv *bat_priv,
+				     const struct sk_buff *skb)
+{
+	u32 now = (u32)ktime_to_us(ktime_get());
+	const struct batadv_icmp_tp_packet *icmp;
+	struct batadv_tp_vars *tp_vars;
+
+	icmp = (struct batadv_icmp_tp_packet *)skb->data;
+
+	tp_vars = batadv_tp_list_find_session(bat_priv, icmp->orig,
+					      icmp->session);
+	if (unlikely(!tp_vars))
+		return;
+
+	if (unlikely(!tp_vars->latency))
+		goto out;
+
+	batadv_tp_latency_add(bat_priv, tp_vars->latency, ntohl(icmp->seqno),
+			      now - ntohl(icmp->timestamp));
+
+out:
+	batadv_tp_vars_put(tp_vars);
+}
+
 /**
  * batadv_tp_meter_recv() - main TP Meter receiving function
  * @bat_priv: the bat priv with all the soft interface information
@@ -1488,6 +2483,12 @@ void batadv_tp_meter_recv(struct batadv_priv *bat_priv, struct sk_buff *skb)
 	case BATADV_TP_ACK:
 		batadv_tp_recv_ack(bat_priv, skb);
 		break;
+	case BATADV_TP_PROBE:
+		batadv_tp_recv_probe(bat_priv, skb);
+		break;
+	case BATADV_TP_PROBE_ACK:
+		batadv_tp_recv_probe_ack(bat_priv, skb);
+		break;
 	default:
 		batadv_dbg(BATADV_DBG_TP_METER, bat_priv,
 			   "Received unknown TP Metric packet type %u\n",
@@ -40,11 +40,13 @@
 #include <linux/net.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
+#include <linux/percpu.h>
 #include <linux/rculist.h>
 #include <linux/rcupdate.h>
 #include <linux/seq_file.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
 #include <linux/spinlock.h>
 #include <linux/stddef.h>
 #include <linux/string.h>
@@ -205,7 +207,7 @@ batadv_tt_local_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
  * Return: a pointer to the corresponding tt_global_entry struct if the client
  * is found, NULL otherwise.
  */
-static struct batadv_tt_global_entry *
+struct batadv_tt_global_entry *
 batadv_tt_global_hash_find(struct batadv_priv *bat_priv, const u8 *addr,
 			   unsigned short vid)
 {
@@ -300,38 +302,12 @@ static void batadv_tt_global_entry_release(struct kref *ref)
  *  possibly release it
  * @tt_global_entry: tt_global_entry to be free'd
  */
-static void
-batadv_tt_global_entry_put(struct batadv_tt_global_entry *tt_global_entry)
+void batadv_tt_global_entry_put(struct batadv_tt_global_entry *tt_global_entry)
 {
 	kref_put(&tt_global_entry->common.refcount,
 		 batadv_tt_global_entry_release);
 }
 
-/**
- * batadv_tt_global_hash_count() - count the number of orig entries
- * @bat_priv: the bat priv with all the soft interface information
- * @addr: the mac address of the client to count entries for
- * @vid: VLAN identifier
- *
- * Return: the number of originators advertising the given address/data
- * (excluding ourself).
- */
-int batadv_tt_global_hash_count(struct batadv_priv *bat_priv,
-				const u8 *addr, unsigned short vid)
-{
-	struct batadv_tt_global_entry *tt_global_entry;
-	int count;
-
-	tt_global_entry = batadv_tt_global_hash_find(bat_priv, addr, vid);
-	if (!tt_global_entry)
-		return 0;
-
-	count = atomic_read(&tt_global_entry->orig_list_count);
-	batadv_tt_global_entry_put(tt_global_entry);
-
-	return count;
-}
-
 /**
  * batadv_tt_local_size_mod() - change the size by v of the local table
  *  identified by vid
@@ -567,33 +543,145 @@ static u16 batadv_tt_entries(u16 tt_len)
 }
 
 /**
- * batadv_tt_local_table_transmit_size() - calculates the local translation
- *  table size when transmitted over the air
+ * batadv_tt_local_num_entries() - count the entries of the local translation
+ *  table
  * @bat_priv: the bat priv with all the soft interface information
  *
- * Return: local translation table size in bytes.
+ * Return: number of local translation table entries over all VLANs.
  */
-static int batadv_tt_local_table_transmit_size(struct batadv_priv *bat_priv)
+static int batadv_tt_local_num_entries(struct batadv_priv *bat_priv)
 {
-	u16 num_vlan = 0;
-	u16 tt_local_entries = 0;
 	struct batadv_softif_vlan *vlan;
+	int tt_local_entries = 0;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(vlan, &bat_priv->softif_vlan_list, list)
+		tt_local_entries += atomic_read(&vlan->tt.num_entries);
+	rcu_read_unlock();
+
+	return tt_local_entries;
+}
+
+/**
+ * batadv_tt_response_size() - calculate the size of a TT response over the air
+ * @tvlv_len: length of the tt tvlv value (tt data, vlan data and tt changes)
+ *
+ * Return: size of the tvlv encapsulated tt response in bytes.
+ */
+static int batadv_tt_response_size(int tvlv_len)
+{
 	int hdr_size;
 
+	hdr_size = sizeof(struct batadv_unicast_tvlv_packet);
+	hdr_size += sizeof(struct batadv_tvlv_hdr);
+
+	return hdr_size + tvlv_len;
+}
+
+/**
+ * batadv_tt_full_table_fits() - check whether a full table can be sent in a
+ *  single TT response
+ * @bat_priv: the bat priv with all the soft interface information
+ * @change_offset: length of the tt data and vlan data header
+ * @num_entries: number of tt entries of the table
+ *
+ * Return: true if the whole table fits into one TT response, false otherwise.
+ */
+static bool batadv_tt_full_table_fits(struct batadv_priv *bat_priv,
+				      int change_offset, int num_entries)
+{
+	int tvlv_len = change_offset + batadv_tt_len(num_entries);
+
+	if (tvlv_len > U16_MAX)
+		return false;
+
+	return batadv_tt_response_size(tvlv_len) <=
+	       atomic_read(&bat_priv->packet_size_max);
+}
+
+/**
+ * batadv_tt_part_max_entries() - compute the number of tt entries fitting in a
+ *  single part of a full table split into several TT responses
+ * @bat_priv: the bat priv with all the soft interface information
+ * @change_offset: length of the tt data and vlan data header
+ *
+ * Return: number of tt entries per part, 0 if not even one entry fits.
+ */
+static int batadv_tt_part_max_entries(struct batadv_priv *bat_priv,
+				      int change_offset)
+{
+	int hdr_len, part_len;
+
+	hdr_len = change_offset + sizeof(struct batadv_tvlv_tt_part);
+
+	part_len = atomic_read(&bat_priv->packet_size_max);
+	part_len -= batadv_tt_response_size(hdr_len);
+	part_len = min_t(int, part_len, U16_MAX - hdr_len);
+	if (part_len < batadv_tt_len(1))
+		return 0;
+
+	return part_len / batadv_tt_len(1);
+}
+
+/**
+ * batadv_tt_local_table_fits() - check whether the local table can be sent in a
+ *  single TT response
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Return: true if the whole local table fits into one TT response.
+ */
+static bool batadv_tt_local_table_fits(struct batadv_priv *bat_priv)
+{
+	struct batadv_softif_vlan *vlan;
+	int num_entries = 0;
+	int change_offset;
+	int num_vlan = 0;
+	int vlan_entries;
+
 	rcu_read_lock();
 	hlist_for_each_entry_rcu(vlan, &bat_priv->softif_vlan_list, list) {
+		vlan_entries = atomic_read(&vlan->tt.num_entries);
+		if (vlan_entries < 1)
+			continue;
+
 		num_vlan++;
-		tt_local_entries += atomic_read(&vlan->tt.num_entries);
+		num_entries += vlan_entries;
 	}
 	rcu_read_unlock();
 
-	/* header size of tvlv encapsulated tt response payload */
-	hdr_size = sizeof(struct batadv_unicast_tvlv_packet);
-	hdr_size += sizeof(struct batadv_tvlv_hdr);
-	hdr_size += sizeof(struct batadv_tvlv_tt_data);
-	hdr_size += num_vlan * sizeof(struct batadv_tvlv_tt_vlan_data);
+	change_offset = sizeof(struct batadv_tvlv_tt_data);
+	change_offset += num_vlan * sizeof(struct batadv_tvlv_tt_vlan_data);
+
+	return batadv_tt_full_table_fits(bat_priv, change_offset, num_entries);
+}
+
+/**
+ * batadv_tt_global_table_fits() - check whether the global table of an
+ *  originator can be sent in a single TT response
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator owning the table
+ *
+ * Return: true if the whole table fits into one TT response.
+ */
+static bool batadv_tt_global_table_fits(struct batadv_priv *bat_priv,
+					struct batadv_orig_node *orig_node)
+{
+	struct batadv_orig_node_vlan *vlan;
+	int num_entries = 0;
+	int change_offset;
+	int num_vlan = 0;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list) {
+		num_vlan++;
+		num_entries += atomic_read(&vlan->tt.num_entries);
+	}
+	rcu_read_unlock();
 
-	return hdr_size + batadv_tt_len(tt_local_entries);
+	change_offset = sizeof(struct batadv_tvlv_tt_data);
+	change_offset += num_vlan * sizeof(struct batadv_tvlv_tt_vlan_data);
+
+	return batadv_tt_full_table_fits(bat_priv, change_offset, num_entries);
 }
 
 static int batadv_tt_local_init(struct batadv_priv *bat_priv)
@@ -651,7 +739,7 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 	struct batadv_hard_iface *in_hardif = NULL;
 	struct hlist_head *head;
 	struct batadv_tt_orig_list_entry *orig_entry;
-	int hash_added, table_size, packet_size_max;
+	int hash_added;
 	bool ret = false;
 	bool roamed_back = false;
 	u8 remote_flags;
@@ -698,14 +786,14 @@ bool batadv_tt_local_add(struct net_device *soft_iface, const u8 *addr,
 		goto check_roaming;
 	}
 
-	/* Ignore the client if we cannot send it in a full table response. */
-	table_size = batadv_tt_local_table_transmit_size(bat_priv);
-	table_size += batadv_tt_len(1);
-	packet_size_max = atomic_read(&bat_priv->packet_size_max);
-	if (table_size > packet_size_max) {
+	/* Ignore the client if the local table is full. Full table responses
+	 * are split into several parts, so the size is not bound by the MTU.
+	 */
+	if (batadv_tt_local_num_entries(bat_priv) >=
+	    BATADV_TT_LOCAL_MAX_ENTRIES) {
 		net_ratelimited_function(batadv_info, soft_iface,
-					 "Local translation table size (%i) exceeds maximum packet size (%i); Ignoring new local tt entry: %pM\n",
-					 table_size, packet_size_max, addr);
+					 "Local translation table has reached its maximum size (%i); Ignoring new local tt entry: %pM\n",
+					 BATADV_TT_LOCAL_MAX_ENTRIES, addr);
 		goto out;
 	}
 
@@ -855,9 +943,9 @@ batadv_tt_prepare_tvlv_global_data(struct batadv_orig_node *orig_node,
 				   s32 *tt_len)
 {
 	u16 num_vlan = 0;
-	u16 num_entries = 0;
-	u16 change_offset;
-	u16 tvlv_len;
+	int num_entries = 0;
+	int change_offset;
+	u16 tvlv_len = 0;
 	struct batadv_tvlv_tt_vlan_data *tt_vlan;
 	struct batadv_orig_node_vlan *vlan;
 	u8 *tt_change_ptr;
@@ -875,6 +963,11 @@ batadv_tt_prepare_tvlv_global_data(struct batadv_orig_node *orig_node,
 	if (*tt_len < 0)
 		*tt_len = batadv_tt_len(num_entries);
 
+	if (*tt_len + change_offset > U16_MAX) {
+		*tt_len = 0;
+		goto out;
+	}
+
 	tvlv_len = *tt_len;
 	tvlv_len += change_offset;
 
@@ -931,9 +1024,9 @@ batadv_tt_prepare_tvlv_local_data(struct batadv_priv *bat_priv,
 	struct batadv_tvlv_tt_vlan_data *tt_vlan;
 	struct batadv_softif_vlan *vlan;
 	u16 num_vlan = 0;
-	u16 vlan_entries = 0;
-	u16 total_entries = 0;
-	u16 tvlv_len;
+	int vlan_entries = 0;
+	int total_entries = 0;
+	u16 tvlv_len = 0;
 	u8 *tt_change_ptr;
 	int change_offset;
 
@@ -954,6 +1047,9 @@ batadv_tt_prepare_tvlv_local_data(struct batadv_priv *bat_priv,
 	if (*tt_len < 0)
 		*tt_len = batadv_tt_len(total_entries);
 
+	if (*tt_len + change_offset > U16_MAX)
+		goto out;
+
 	tvlv_len = *tt_len;
 	tvlv_len += change_offset;
 
@@ -1486,6 +1582,11 @@ static int batadv_tt_global_init(struct batadv_priv *bat_priv)
 	if (!bat_priv->tt.global_hash)
 		return -ENOMEM;
 
+	atomic_set(&bat_priv->tt.global_gen, 0);
+	bat_priv->tt.miss_cache = alloc_percpu(struct batadv_tt_miss_cache);
+	if (!bat_priv->tt.miss_cache)
+		return -ENOMEM;
+
 	batadv_hash_set_lock_class(bat_priv->tt.global_hash,
 				   &batadv_tt_global_hash_lock_class_key);
 
@@ -1651,6 +1752,18 @@ batadv_tt_global_orig_entry_add(struct batadv_tt_global_entry *tt_global,
 	spin_unlock_bh(&tt_global->list_lock);
 }
 
+/**
+ * batadv_tt_global_gen_inc() - invalidate all per cpu miss caches
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * Has to be called after a client was added to the global hash.
+ */
+static void batadv_tt_global_gen_inc(struct batadv_priv *bat_priv)
+{
+	smp_mb__before_atomic();
+	atomic_inc(&bat_priv->tt.global_gen);
+}
+
 /**
  * batadv_tt_global_add() - add a new TT global entry or update an existing one
  * @bat_priv: the bat priv with all the soft interface information
@@ -1735,6 +1848,8 @@ static bool batadv_tt_global_add(struct batadv_priv *bat_priv,
 			batadv_tt_global_entry_put(tt_global_entry);
 			goto out_remove;
 		}
+
+		batadv_tt_global_gen_inc(bat_priv);
 	} else {
 		common = &tt_global_entry->common;
 		/* If there is already a global entry, we can use this one for
@@ -2558,6 +2673,9 @@ static void batadv_tt_global_table_free(struct batadv_priv *bat_priv)
 	batadv_hash_destroy(hash);
 
 	bat_priv->tt.global_hash = NULL;
+
+	free_percpu(bat_priv->tt.miss_cache);
+	bat_priv->tt.miss_cache = NULL;
 }
 
 static bool
@@ -2576,6 +2694,42 @@ _batadv_is_ap_isolated(struct batadv_tt_local_entry *tt_local_entry,
 	return false;
 }
 
+/**
+ * batadv_tt_miss_cache_index() - choose the per cpu miss cache slot of a
+ *  client
+ * @addr: the mac address of the client
+ * @vid: VLAN identifier
+ *
+ * Return: the index of the cache slot
+ */
+static inline u32 batadv_tt_miss_cache_index(const u8 *addr,
+					     unsigned short vid)
+{
+	u32 index = (addr[4] << 8) | addr[5];
+
+	return (index ^ vid) & (BATADV_TT_MISS_CACHE_SIZE - 1);
+}
+
+/**
+ * batadv_tt_miss_cache_slot() - get the per cpu miss cache slot of a client
+ * @bat_priv: the bat priv with all the soft interface information
+ * @addr: the mac address of the client
+ * @vid: VLAN identifier
+ *
+ * Must be called from bottom half context.
+ *
+ * Return: the cache slot of the client
+ */
+static struct batadv_tt_miss_cache_entry *
+batadv_tt_miss_cache_slot(struct batadv_priv *bat_priv, const u8 *addr,
+			  unsigned short vid)
+{
+	struct batadv_tt_miss_cache *cache;
+
+	cache = this_cpu_ptr(bat_priv->tt.miss_cache);
+	return &cache->entries[batadv_tt_miss_cache_index(addr, vid)];
+}
+
 /**
  * batadv_transtable_search() - get the mesh destination for a given client
  * @bat_priv: the bat priv with all the soft interface information
@@ -2598,7 +2752,9 @@ struct batadv_orig_node *batadv_transtable_search(struct batadv_priv *bat_priv,
 	struct batadv_tt_local_entry *tt_local_entry = NULL;
 	struct batadv_tt_global_entry *tt_global_entry = NULL;
 	struct batadv_orig_node *orig_node = NULL;
+	struct batadv_tt_miss_cache_entry *miss;
 	struct batadv_tt_orig_list_entry *best_entry;
+	unsigned int gen;
 
 	if (src && batadv_vlan_ap_isola_get(bat_priv, vid)) {
 		tt_local_entry = batadv_tt_local_hash_find(bat_priv, src, vid);
@@ -2607,9 +2763,27 @@ struct batadv_orig_node *batadv_transtable_search(struct batadv_priv *bat_priv,
 			goto out;
 	}
 
+	/* unknown destinations (e.g. scanners) tend to be looked up again and
+	 * again: remember the misses until the next client is added
+	 */
+	gen = atomic_read(&bat_priv->tt.global_gen);
+	smp_rmb(); /* read generation before searching the global hash */
+
+	miss = batadv_tt_miss_cache_slot(bat_priv, addr, vid);
+	if (miss->gen == gen && miss->vid == vid &&
+	    batadv_compare_eth(miss->addr, addr)) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_TT_SEARCH_MISS_CACHED);
+		goto out;
+	}
+
 	tt_global_entry = batadv_tt_global_hash_find(bat_priv, addr, vid);
-	if (!tt_global_entry)
+	if (!tt_global_entry) {
+		batadv_inc_counter(bat_priv, BATADV_CNT_TT_SEARCH_MISS);
+		ether_addr_copy(miss->addr, addr);
+		miss->vid = vid;
+		miss->gen = gen;
 		goto out;
+	}
 
 	/* check whether the clients should not communicate due to AP
 	 * isolation
@@ -3020,116 +3194,784 @@ static void batadv_tt_tvlv_generate(struct batadv_priv *bat_priv,
 }
 
 /**
- * batadv_tt_global_check_crc() - check if all the CRCs are correct
- * @orig_node: originator for which the CRCs have to be checked
- * @tt_vlan: pointer to the first tvlv VLAN entry
- * @num_vlan: number of tvlv VLAN entries
+ * batadv_tt_change_cmp() - compare two tt changes by vid and address
+ * @a: first tt change
+ * @b: second tt change
  *
- * Return: true if all the received CRCs match the locally stored ones, false
- * otherwise
+ * Return: <0, 0 or >0 if @a sorts before, equal to or after @b
  */
-static bool batadv_tt_global_check_crc(struct batadv_orig_node *orig_node,
-				       struct batadv_tvlv_tt_vlan_data *tt_vlan,
-				       u16 num_vlan)
+static int batadv_tt_change_cmp(const void *a, const void *b)
 {
-	struct batadv_tvlv_tt_vlan_data *tt_vlan_tmp;
-	struct batadv_orig_node_vlan *vlan;
-	int i, orig_num_vlan;
-	u32 crc;
+	const struct batadv_tvlv_tt_change *change_a = a;
+	const struct batadv_tvlv_tt_change *change_b = b;
+	u16 vid_a = ntohs(change_a->vid);
+	u16 vid_b = ntohs(change_b->vid);
 
-	/* check if each received CRC matches the locally stored one */
-	for (i = 0; i < num_vlan; i++) {
-		tt_vlan_tmp = tt_vlan + i;
+	if (vid_a != vid_b)
+		return vid_a < vid_b ? -1 : 1;
 
-		/* if orig_node is a backbone node for this VLAN, don't check
-		 * the CRC as we ignore all the global entries over it
-		 */
-		if (batadv_bla_is_backbone_gw_orig(orig_node->bat_priv,
-						   orig_node->orig,
-						   ntohs(tt_vlan_tmp->vid)))
-			continue;
+	return memcmp(change_a->addr, change_b->addr, ETH_ALEN);
+}
 
-		vlan = batadv_orig_node_vlan_get(orig_node,
-						 ntohs(tt_vlan_tmp->vid));
-		if (!vlan)
-			return false;
+/**
+ * batadv_tt_compress() - encode tt changes as compressed records
+ * @tt_change: tt changes to encode, sorted in place
+ * @num_entries: number of tt changes
+ * @buff: destination buffer
+ * @buff_len: size of @buff
+ *
+ * Every change can be applied independently of the others (TT never holds two
+ * changes for the same client in one message), so the changes are sorted to
+ * let consecutive records share the address prefix, the flags and the vid.
+ *
+ * Return: number of bytes written to @buff or 0 if the encoding does not fit.
+ */
+static int batadv_tt_compress(struct batadv_tvlv_tt_change *tt_change,
+			      u16 num_entries, u8 *buff, int buff_len)
+{
+	struct batadv_tvlv_tt_change *prev = NULL;
+	struct batadv_tvlv_tt_compressed *hdr;
+	int prefix, needed, pos;
+	u8 ctrl;
+	u16 i;
 
-		crc = vlan->tt.crc;
-		batadv_orig_node_vlan_put(vlan);
+	if (buff_len < sizeof(*hdr))
+		return 0;
 
-		if (crc != ntohl(tt_vlan_tmp->crc))
-			return false;
-	}
+	sort(tt_change, num_entries, sizeof(*tt_change), batadv_tt_change_cmp,
+	     NULL);
 
-	/* check if any excess VLANs exist locally for the originator
-	 * which are not mentioned in the TVLV from the originator.
-	 */
-	rcu_read_lock();
-	orig_num_vlan = 0;
-	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list)
-		orig_num_vlan++;
-	rcu_read_unlock();
+	hdr = (struct batadv_tvlv_tt_compressed *)buff;
+	hdr->num_entries = htons(num_entries);
+	hdr->reserved = 0;
+	pos = sizeof(*hdr);
 
-	if (orig_num_vlan > num_vlan)
-		return false;
+	for (i = 0; i < num_entries; i++, tt_change++) {
+		ctrl = 0;
+		prefix = 0;
 
-	return true;
+		if (prev) {
+			while (prefix < ETH_ALEN &&
+			       prev->addr[prefix] == tt_change->addr[prefix])
+				prefix++;
+
+			if (prev->flags == tt_change->flags)
+				ctrl |= BATADV_TT_COMPRESS_SAME_FLAGS;
+
+			if (prev->vid == tt_change->vid)
+				ctrl |= BATADV_TT_COMPRESS_SAME_VID;
+		}
+		ctrl |= prefix;
+
+		needed = 1 + ETH_ALEN - prefix;
+		if (!(ctrl & BATADV_TT_COMPRESS_SAME_FLAGS))
+			needed += sizeof(tt_change->flags);
+		if (!(ctrl & BATADV_TT_COMPRESS_SAME_VID))
+			needed += sizeof(tt_change->vid);
+
+		if (pos + needed > buff_len)
+			return 0;
+
+		buff[pos++] = ctrl;
+		if (!(ctrl & BATADV_TT_COMPRESS_SAME_FLAGS))
+			buff[pos++] = tt_change->flags;
+		if (!(ctrl & BATADV_TT_COMPRESS_SAME_VID)) {
+			memcpy(buff + pos, &tt_change->vid,
+			       sizeof(tt_change->vid));
+			pos += sizeof(tt_change->vid);
+		}
+		memcpy(buff + pos, tt_change->addr + prefix, ETH_ALEN - prefix);
+		pos += ETH_ALEN - prefix;
+
+		prev = tt_change;
+	}
+
+	return pos;
 }
 
 /**
- * batadv_tt_local_update_crc() - update all the local CRCs
- * @bat_priv: the bat priv with all the soft interface information
+ * batadv_tt_decompress() - decode compressed tt records
+ * @buff: compressed records (following the batadv_tvlv_tt_compressed header)
+ * @buff_len: length of @buff
+ * @tt_change: destination array
+ * @num_entries: number of records to decode
+ *
+ * Return: 0 on success, -EINVAL if the records are malformed.
  */
-static void batadv_tt_local_update_crc(struct batadv_priv *bat_priv)
+static int batadv_tt_decompress(const u8 *buff, int buff_len,
+				struct batadv_tvlv_tt_change *tt_change,
+				u16 num_entries)
 {
-	struct batadv_softif_vlan *vlan;
+	struct batadv_tvlv_tt_change *prev = NULL;
+	int prefix, pos = 0;
+	u8 ctrl;
+	u16 i;
 
-	/* recompute the global CRC for each VLAN */
-	rcu_read_lock();
-	hlist_for_each_entry_rcu(vlan, &bat_priv->softif_vlan_list, list) {
-		vlan->tt.crc = batadv_tt_local_crc(bat_priv, vlan->vid);
+	for (i = 0; i < num_entries; i++, tt_change++) {
+		if (pos >= buff_len)
+			return -EINVAL;
+
+		ctrl = buff[pos++];
+		prefix = ctrl & BATADV_TT_COMPRESS_PREFIX_MASK;
+
+		if (prefix > ETH_ALEN)
+			return -EINVAL;
+
+		if (!prev && (prefix || ctrl & BATADV_TT_COMPRESS_SAME_FLAGS ||
+			      ctrl & BATADV_TT_COMPRESS_SAME_VID))
+			return -EINVAL;
+
+		memset(tt_change->reserved, 0, sizeof(tt_change->reserved));
+
+		if (ctrl & BATADV_TT_COMPRESS_SAME_FLAGS) {
+			tt_change->flags = prev->flags;
+		} else {
+			if (pos + sizeof(tt_change->flags) > buff_len)
+				return -EINVAL;
+
+			tt_change->flags = buff[pos++];
+		}
+
+		if (ctrl & BATADV_TT_COMPRESS_SAME_VID) {
+			tt_change->vid = prev->vid;
+		} else {
+			if (pos + sizeof(tt_change->vid) > buff_len)
+				return -EINVAL;
+
+			memcpy(&tt_change->vid, buff + pos,
+			       sizeof(tt_change->vid));
+			pos += sizeof(tt_change->vid);
+		}
+
+		if (pos + ETH_ALEN - prefix > buff_len)
+			return -EINVAL;
+
+		if (prefix)
+			memcpy(tt_change->addr, prev->addr, prefix);
+		memcpy(tt_change->addr + prefix, buff + pos, ETH_ALEN - prefix);
+		pos += ETH_ALEN - prefix;
+
+		prev = tt_change;
 	}
-	rcu_read_unlock();
+
+	return 0;
 }
 
 /**
- * batadv_tt_global_update_crc() - update all the global CRCs for this orig_node
- * @bat_priv: the bat priv with all the soft interface information
- * @orig_node: the orig_node for which the CRCs have to be updated
+ * batadv_tt_response_hdr_len() - length of the header preceding the tt changes
+ *  of a TT response
+ * @tt_data: the TT response
+ *
+ * Return: length of the tt data, vlan data and (if present) part header.
  */
-static void batadv_tt_global_update_crc(struct batadv_priv *bat_priv,
-					struct batadv_orig_node *orig_node)
+static int batadv_tt_response_hdr_len(struct batadv_tvlv_tt_data *tt_data)
 {
-	struct batadv_orig_node_vlan *vlan;
-	u32 crc;
+	int hdr_len;
 
-	/* recompute the global CRC for each VLAN */
-	rcu_read_lock();
-	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list) {
-		/* if orig_node is a backbone node for this VLAN, don't compute
-		 * the CRC as we ignore all the global entries over it
-		 */
-		if (batadv_bla_is_backbone_gw_orig(bat_priv, orig_node->orig,
-						   vlan->vid))
-			continue;
+	hdr_len = sizeof(*tt_data);
+	hdr_len += ntohs(tt_data->num_vlan) *
+		   sizeof(struct batadv_tvlv_tt_vlan_data);
 
-		crc = batadv_tt_global_crc(bat_priv, orig_node, vlan->vid);
-		vlan->tt.crc = crc;
-	}
-	rcu_read_unlock();
+	if (tt_data->flags & BATADV_TT_MULTIPART)
+		hdr_len += sizeof(struct batadv_tvlv_tt_part);
+
+	return hdr_len;
 }
 
 /**
- * batadv_send_tt_request() - send a TT Request message to a given node
+ * batadv_tt_send_response() - send a TT response, compressed when possible
  * @bat_priv: the bat priv with all the soft interface information
- * @dst_orig_node: the destination of the message
- * @ttvn: the version number that the source of the message is looking for
- * @tt_vlan: pointer to the first tvlv VLAN object to request
- * @num_vlan: number of tvlv VLAN entries
- * @full_table: ask for the entire translation table if true, while only for the
- *  last TT diff otherwise
- *
- * Return: true if the TT Request was sent, false otherwise
+ * @src: source address of the response
+ * @dst: destination address of the response
+ * @tt_data: the TT response. The tt changes may get reordered
+ * @tvlv_len: length of @tt_data
+ * @compress: whether the requester accepts compressed tt changes
+ */
+static void batadv_tt_send_response(struct batadv_priv *bat_priv, u8 *src,
+				    u8 *dst, struct batadv_tvlv_tt_data *tt_data,
+				    u16 tvlv_len, bool compress)
+{
+	struct batadv_tvlv_tt_change *tt_change;
+	struct batadv_tvlv_tt_data *compressed;
+	int hdr_len, tt_len, compressed_len;
+
+	batadv_inc_counter(bat_priv, BATADV_CNT_TT_RESPONSE_TX);
+
+	hdr_len = batadv_tt_response_hdr_len(tt_data);
+	tt_len = tvlv_len - hdr_len;
+	if (!compress || tt_len <= 0)
+		goto send_plain;
+
+	compressed = kmalloc(tvlv_len, GFP_ATOMIC);
+	if (!compressed)
+		goto send_plain;
+
+	tt_change = (struct batadv_tvlv_tt_change *)((u8 *)tt_data + hdr_len);
+	compressed_len = batadv_tt_compress(tt_change,
+					    batadv_tt_entries(tt_len),
+					    (u8 *)compressed + hdr_len,
+					    tt_len);
+	if (!compressed_len) {
+		kfree(compressed);
+		goto send_plain;
+	}
+
+	memcpy(compressed, tt_data, hdr_len);
+	compressed->flags |= BATADV_TT_COMPRESSED;
+
+	batadv_tvlv_unicast_send(bat_priv, src, dst, BATADV_TVLV_TT, 1,
+				 compressed, hdr_len + compressed_len);
+	batadv_add_counter(bat_priv, BATADV_CNT_TT_COMPRESS_SAVED,
+			   tt_len - compressed_len);
+
+	kfree(compressed);
+	return;
+
+send_plain:
+	batadv_tvlv_unicast_send(bat_priv, src, dst, BATADV_TVLV_TT, 1,
+				 tt_data, tvlv_len);
+}
+
+/**
+ * batadv_tt_decompress_response() - decode a compressed TT response
+ * @tt_data: the compressed TT response
+ * @tt_len: length of the compressed data following the response header
+ * @num_entries: set to the number of decoded tt changes
+ *
+ * Return: newly allocated uncompressed copy of the TT response or NULL on
+ * error.
+ */
+static struct batadv_tvlv_tt_data *
+batadv_tt_decompress_response(struct batadv_tvlv_tt_data *tt_data,
+			      u16 tt_len, u16 *num_entries)
+{
+	struct batadv_tvlv_tt_compressed *compressed_hdr;
+	struct batadv_tvlv_tt_change *tt_change;
+	struct batadv_tvlv_tt_data *decoded;
+	int hdr_len;
+	u16 entries;
+
+	if (tt_len < sizeof(*compressed_hdr))
+		return NULL;
+
+	hdr_len = batadv_tt_response_hdr_len(tt_data);
+	compressed_hdr = (struct batadv_tvlv_tt_compressed *)((u8 *)tt_data +
+							      hdr_len);
+	entries = ntohs(compressed_hdr->num_entries);
+
+	/* the uncompressed response has to be a valid tvlv again */
+	if (hdr_len + batadv_tt_len(entries) > U16_MAX)
+		return NULL;
+
+	decoded = kmalloc(hdr_len + batadv_tt_len(entries), GFP_ATOMIC);
+	if (!decoded)
+		return NULL;
+
+	memcpy(decoded, tt_data, hdr_len);
+	decoded->flags &= ~BATADV_TT_COMPRESSED;
+
+	tt_change = (struct batadv_tvlv_tt_change *)((u8 *)decoded + hdr_len);
+	if (batadv_tt_decompress((u8 *)(compressed_hdr + 1),
+				 tt_len - sizeof(*compressed_hdr),
+				 tt_change, entries) < 0) {
+		kfree(decoded);
+		return NULL;
+	}
+
+	*num_entries = entries;
+	return decoded;
+}
+
+/**
+ * batadv_tt_part_tx_free() - free a full table transfer
+ * @tx: the transfer to free
+ *
+ * The transfer must already be removed from &batadv_priv_tt.part_tx_list and
+ * its work must not be pending anymore.
+ */
+static void batadv_tt_part_tx_free(struct batadv_tt_part_tx *tx)
+{
+	if (tx->orig_node)
+		batadv_orig_node_put(tx->orig_node);
+
+	kfree(tx->hdr);
+	kfree(tx);
+}
+
+/**
+ * batadv_tt_part_tx_window() - send the next window of parts of a full table
+ * @tx: the transfer to continue
+ * @part_data: buffer for a single part, prepared with the tt data and vlan
+ *  data header of the full table
+ * @change_offset: length of the tt data and vlan data header
+ * @max_entries: number of entries fitting in a single part
+ * @offset: number of entries already sent, updated with the entries sent now
+ *
+ * Every part carries the same header as a single full table response followed
+ * by a batadv_tvlv_tt_part stating how many entries were sent in the previous
+ * parts. The receiver applies the parts in order and only commits the ttvn
+ * once the part flagged with BATADV_TT_LAST_PART arrived.
+ *
+ * Return: true if the last part was sent, false if parts are left.
+ */
+static bool batadv_tt_part_tx_window(struct batadv_tt_part_tx *tx,
+				     struct batadv_tvlv_tt_data *part_data,
+				     u16 change_offset, int max_entries,
+				     u32 *offset)
+{
+	struct batadv_priv *bat_priv = tx->bat_priv;
+	bool (*valid_cb)(const void *, const void *, u8 *flags);
+	struct batadv_tt_common_entry *tt_common_entry;
+	struct batadv_tvlv_tt_change *tt_change_base;
+	struct batadv_tvlv_tt_change *tt_change;
+	struct batadv_tvlv_tt_part *tt_part;
+	struct batadv_hashtable *hash;
+	int num_entries = 0, num_parts = 0;
+	struct hlist_head *head;
+	u32 skip = *offset;
+	u16 part_len;
+	bool last = false;
+	u8 flags;
+	u32 i;
+
+	if (tx->orig_node) {
+		hash = bat_priv->tt.global_hash;
+		valid_cb = batadv_tt_global_valid;
+	} else {
+		hash = bat_priv->tt.local_hash;
+		valid_cb = batadv_tt_local_valid;
+	}
+
+	part_len = change_offset + sizeof(*tt_part);
+	part_len += batadv_tt_len(max_entries);
+
+	tt_part = (struct batadv_tvlv_tt_part *)((u8 *)part_data +
+						 change_offset);
+	tt_change_base = (struct batadv_tvlv_tt_change *)(tt_part + 1);
+	tt_change = tt_change_base;
+
+	rcu_read_lock();
+	for (i = 0; i < hash->size; i++) {
+		head = &hash->table[i];
+
+		hlist_for_each_entry_rcu(tt_common_entry, head, hash_entry) {
+			if (!valid_cb(tt_common_entry, tx->orig_node, &flags))
+				continue;
+
+			/* entries of the previous windows */
+			if (skip) {
+				skip--;
+				continue;
+			}
+
+			ether_addr_copy(tt_change->addr, tt_common_entry->addr);
+			tt_change->flags = flags;
+			tt_change->vid = htons(tt_common_entry->vid);
+			memset(tt_change->reserved, 0,
+			       sizeof(tt_change->reserved));
+
+			num_entries++;
+			tt_change++;
+
+			if (num_entries < max_entries)
+				continue;
+
+			tt_part->offset = htonl(*offset);
+			batadv_tt_send_response(bat_priv, tx->src, tx->dst,
+						part_data, part_len,
+						tx->compress);
+
+			*offset += num_entries;
+			num_entries = 0;
+			tt_change = tt_change_base;
+
+			if (++num_parts == BATADV_TT_PART_WINDOW)
+				goto unlock;
+		}
+	}
+
+	/* the last part is always sent, even without entries, to let the
+	 * receiver commit the table
+	 */
+	part_data->flags |= BATADV_TT_LAST_PART;
+	tt_part->offset = htonl(*offset);
+	part_len = change_offset + sizeof(*tt_part);
+	part_len += batadv_tt_len(num_entries);
+	batadv_tt_send_response(bat_priv, tx->src, tx->dst, part_data,
+				part_len, tx->compress);
+
+	*offset += num_entries;
+	last = true;
+unlock:
+	rcu_read_unlock();
+
+	return last;
+}
+
+/**
+ * batadv_tt_part_tx_work() - send the next window of a full table transfer
+ * @work: work queue item
+ *
+ * At most BATADV_TT_PART_WINDOW parts are sent per run, the next run is
+ * scheduled BATADV_TT_PART_INTERVAL milliseconds later. Once the last part
+ * was sent, the transfer is kept for BATADV_TT_PART_TX_TIMEOUT milliseconds
+ * to let the requester resume it after a lost part. The transfer is dropped
+ * when the table it sends got a new ttvn.
+ */
+static void batadv_tt_part_tx_work(struct work_struct *work)
+{
+	struct batadv_tvlv_tt_data *part_data = NULL;
+	struct delayed_work *delayed_work;
+	struct batadv_tt_part_tx *tx;
+	struct batadv_priv *bat_priv;
+	unsigned long delay;
+	int max_entries;
+	u16 change_offset;
+	u32 offset;
+	bool last;
+	u8 ttvn;
+
+	delayed_work = to_delayed_work(work);
+	tx = container_of(delayed_work, struct batadv_tt_part_tx, work);
+	bat_priv = tx->bat_priv;
+
+	spin_lock_bh(&bat_priv->tt.part_tx_lock);
+	/* already removed by batadv_tt_free() */
+	if (hlist_unhashed(&tx->list))
+		goto unlock;
+
+	if (tx->finished)
+		goto drop;
+
+	change_offset = tx->hdr_len;
+	max_entries = batadv_tt_part_max_entries(bat_priv, change_offset);
+	if (max_entries == 0)
+		goto drop;
+
+	part_data = kmalloc(change_offset + sizeof(struct batadv_tvlv_tt_part) +
+			    batadv_tt_len(max_entries), GFP_ATOMIC);
+	if (!part_data)
+		goto drop;
+
+	memcpy(part_data, tx->hdr, change_offset);
+	part_data->flags |= BATADV_TT_MULTIPART;
+	ttvn = tx->hdr->ttvn;
+	offset = tx->offset;
+	tx->restart = false;
+	spin_unlock_bh(&bat_priv->tt.part_tx_lock);
+
+	if (tx->orig_node) {
+		if (ttvn != (u8)atomic_read(&tx->orig_node->last_ttvn))
+			goto abort;
+	} else if (ttvn != (u8)atomic_read(&bat_priv->tt.vn)) {
+		goto abort;
+	}
+
+	last = batadv_tt_part_tx_window(tx, part_data, change_offset,
+					max_entries, &offset);
+	kfree(part_data);
+
+	if (last)
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Sent full table of %u entries to %pM in several parts (ttvn: %u)\n",
+			   offset, tx->dst, ttvn);
+
+	spin_lock_bh(&bat_priv->tt.part_tx_lock);
+	if (hlist_unhashed(&tx->list))
+		goto unlock;
+
+	/* a new request arrived while this window was sent */
+	if (tx->restart) {
+		delay = 0;
+	} else {
+		tx->offset = offset;
+		tx->finished = last;
+
+		if (last)
+			delay = BATADV_TT_PART_TX_TIMEOUT;
+		else
+			delay = BATADV_TT_PART_INTERVAL;
+	}
+
+	queue_delayed_work(batadv_event_workqueue, &tx->work,
+			   msecs_to_jiffies(delay));
+unlock:
+	spin_unlock_bh(&bat_priv->tt.part_tx_lock);
+	return;
+
+abort:
+	kfree(part_data);
+	spin_lock_bh(&bat_priv->tt.part_tx_lock);
+	if (hlist_unhashed(&tx->list))
+		goto unlock;
+
+	/* the new request may already be for the new ttvn */
+	if (tx->restart) {
+		queue_delayed_work(batadv_event_workqueue, &tx->work, 0);
+		goto unlock;
+	}
+drop:
+	hlist_del_init(&tx->list);
+	spin_unlock_bh(&bat_priv->tt.part_tx_lock);
+
+	batadv_tt_part_tx_free(tx);
+}
+
+/**
+ * batadv_tt_send_full_table_parts() - send a full table split into several TT
+ *  responses
+ * @bat_priv: the bat priv with all the soft interface information
+ * @tt_data: prepared tt data and vlan data header of the full table response
+ * @change_offset: length of @tt_data
+ * @orig_node: originator whose global table is sent, NULL for the local table
+ * @src: address of the node whose table is sent
+ * @dst: address of the node which requested the table
+ * @compress: whether the requester accepts compressed tt changes
+ * @offset: number of entries the requester already received from an
+ *  interrupted transfer of the same table
+ *
+ * The parts are sent by a work item in windows of BATADV_TT_PART_WINDOW parts
+ * instead of a single burst from the receive path. A transfer of the same
+ * table to the same requester which is still known is resumed at @offset.
+ * Otherwise the table is sent from the beginning.
+ *
+ * Return: true if the transfer was scheduled, false otherwise.
+ */
+static bool
+batadv_tt_send_full_table_parts(struct batadv_priv *bat_priv,
+				struct batadv_tvlv_tt_data *tt_data,
+				u16 change_offset,
+				struct batadv_orig_node *orig_node,
+				u8 *src, u8 *dst, bool compress, u32 offset)
+{
+	struct batadv_tt_part_tx *tx, *tx_tmp = NULL;
+	struct batadv_tvlv_tt_data *hdr_old;
+	unsigned int num_tx = 0;
+	bool ret = false;
+
+	if (batadv_tt_part_max_entries(bat_priv, change_offset) == 0)
+		return false;
+
+	spin_lock_bh(&bat_priv->tt.part_tx_lock);
+	hlist_for_each_entry(tx, &bat_priv->tt.part_tx_list, list) {
+		num_tx++;
+
+		if (!batadv_compare_eth(tx->src, src) ||
+		    !batadv_compare_eth(tx->dst, dst))
+			continue;
+
+		tx_tmp = tx;
+		break;
+	}
+
+	if (tx_tmp) {
+		tx = tx_tmp;
+
+		/* only the very same table can be resumed */
+		if (tx->hdr_len != change_offset ||
+		    memcmp(tx->hdr, tt_data, change_offset) != 0) {
+			hdr_old = tx->hdr;
+			tx->hdr = kmemdup(tt_data, change_offset, GFP_ATOMIC);
+			if (!tx->hdr) {
+				tx->hdr = hdr_old;
+				goto unlock;
+			}
+
+			kfree(hdr_old);
+			tx->hdr_len = change_offset;
+			offset = 0;
+		}
+
+		tx->compress = compress;
+		tx->offset = offset;
+		tx->finished = false;
+		tx->restart = true;
+		mod_delayed_work(batadv_event_workqueue, &tx->work, 0);
+
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Sending full table to %pM in several parts from entry %u (ttvn: %u)\n",
+			   dst, offset, tt_data->ttvn);
+		ret = true;
+		goto unlock;
+	}
+
+	if (num_tx >= BATADV_TT_PART_TX_MAX)
+		goto unlock;
+
+	tx = kzalloc(sizeof(*tx), GFP_ATOMIC);
+	if (!tx)
+		goto unlock;
+
+	tx->hdr = kmemdup(tt_data, change_offset, GFP_ATOMIC);
+	if (!tx->hdr) {
+		kfree(tx);
+		goto unlock;
+	}
+
+	if (orig_node) {
+		kref_get(&orig_node->refcount);
+		tx->orig_node = orig_node;
+	}
+
+	tx->bat_priv = bat_priv;
+	tx->hdr_len = change_offset;
+	ether_addr_copy(tx->src, src);
+	ether_addr_copy(tx->dst, dst);
+	tx->compress = compress;
+
+	/* without the state of the interrupted transfer this node cannot tell
+	 * which entries the requester already got
+	 */
+	tx->offset = 0;
+
+	INIT_DELAYED_WORK(&tx->work, batadv_tt_part_tx_work);
+	hlist_add_head(&tx->list, &bat_priv->tt.part_tx_list);
+	queue_delayed_work(batadv_event_workqueue, &tx->work, 0);
+	ret = true;
+unlock:
+	spin_unlock_bh(&bat_priv->tt.part_tx_lock);
+
+	return ret;
+}
+
+/**
+ * batadv_tt_part_tx_list_free() - stop and free all full table transfers
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+static void batadv_tt_part_tx_list_free(struct batadv_priv *bat_priv)
+{
+	struct batadv_tt_part_tx *tx;
+
+	while (true) {
+		spin_lock_bh(&bat_priv->tt.part_tx_lock);
+		tx = hlist_entry_safe(bat_priv->tt.part_tx_list.first,
+				      struct batadv_tt_part_tx, list);
+		if (tx)
+			hlist_del_init(&tx->list);
+		spin_unlock_bh(&bat_priv->tt.part_tx_lock);
+
+		if (!tx)
+			break;
+
+		cancel_delayed_work_sync(&tx->work);
+		batadv_tt_part_tx_free(tx);
+	}
+}
+
+/**
+ * batadv_tt_global_check_crc() - check if all the CRCs are correct
+ * @orig_node: originator for which the CRCs have to be checked
+ * @tt_vlan: pointer to the first tvlv VLAN entry
+ * @num_vlan: number of tvlv VLAN entries
+ *
+ * Return: true if all the received CRCs match the locally stored ones, false
+ * otherwise
+ */
+static bool batadv_tt_global_check_crc(struct batadv_orig_node *orig_node,
+				       struct batadv_tvlv_tt_vlan_data *tt_vlan,
+				       u16 num_vlan)
+{
+	struct batadv_tvlv_tt_vlan_data *tt_vlan_tmp;
+	struct batadv_orig_node_vlan *vlan;
+	int i, orig_num_vlan;
+	u32 crc;
+
+	/* check if each received CRC matches the locally stored one */
+	for (i = 0; i < num_vlan; i++) {
+		tt_vlan_tmp = tt_vlan + i;
+
+		/* if orig_node is a backbone node for this VLAN, don't check
+		 * the CRC as we ignore all the global entries over it
+		 */
+		if (batadv_bla_is_backbone_gw_orig(orig_node->bat_priv,
+						   orig_node->orig,
+						   ntohs(tt_vlan_tmp->vid)))
+			continue;
+
+		vlan = batadv_orig_node_vlan_get(orig_node,
+						 ntohs(tt_vlan_tmp->vid));
+		if (!vlan)
+			return false;
+
+		crc = vlan->tt.crc;
+		batadv_orig_node_vlan_put(vlan);
+
+		if (crc != ntohl(tt_vlan_tmp->crc))
+			return false;
+	}
+
+	/* check if any excess VLANs exist locally for the originator
+	 * which are not mentioned in the TVLV from the originator.
+	 */
+	rcu_read_lock();
+	orig_num_vlan = 0;
+	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list)
+		orig_num_vlan++;
+	rcu_read_unlock();
+
+	if (orig_num_vlan > num_vlan)
+		return false;
+
+	return true;
+}
+
+/**
+ * batadv_tt_local_update_crc() - update all the local CRCs
+ * @bat_priv: the bat priv with all the soft interface information
+ */
+static void batadv_tt_local_update_crc(struct batadv_priv *bat_priv)
+{
+	struct batadv_softif_vlan *vlan;
+
+	/* recompute the global CRC for each VLAN */
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(vlan, &bat_priv->softif_vlan_list, list) {
+		vlan->tt.crc = batadv_tt_local_crc(bat_priv, vlan->vid);
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * batadv_tt_global_update_crc() - update all the global CRCs for this orig_node
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the orig_node for which the CRCs have to be updated
+ */
+static void batadv_tt_global_update_crc(struct batadv_priv *bat_priv,
+					struct batadv_orig_node *orig_node)
+{
+	struct batadv_orig_node_vlan *vlan;
+	u32 crc;
+
+	/* recompute the global CRC for each VLAN */
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(vlan, &orig_node->vlan_list, list) {
+		/* if orig_node is a backbone node for this VLAN, don't compute
+		 * the CRC as we ignore all the global entries over it
+		 */
+		if (batadv_bla_is_backbone_gw_orig(bat_priv, orig_node->orig,
+						   vlan->vid))
+			continue;
+
+		crc = batadv_tt_global_crc(bat_priv, orig_node, vlan->vid);
+		vlan->tt.crc = crc;
+	}
+	rcu_read_unlock();
+}
+
+/**
+ * batadv_send_tt_request() - send a TT Request message to a given node
+ * @bat_priv: the bat priv with all the soft interface information
+ * @dst_orig_node: the destination of the message
+ * @ttvn: the version number that the source of the message is looking for
+ * @tt_vlan: pointer to the first tvlv VLAN object to request
+ * @num_vlan: number of tvlv VLAN entries
+ * @full_table: ask for the entire translation table if true, while only for the
+ *  last TT diff otherwise
+ *
+ * A full table request resumes an interrupted transfer of the same table split
+ * into several parts by stating the number of entries received so far.
+ *
+ * Return: true if the TT Request was sent, false otherwise
  */
 static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
 				   struct batadv_orig_node *dst_orig_node,
@@ -3140,6 +3982,8 @@ static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
 	struct batadv_tvlv_tt_data *tvlv_tt_data = NULL;
 	struct batadv_tt_req_node *tt_req_node = NULL;
 	struct batadv_tvlv_tt_vlan_data *tt_vlan_req;
+	u32 part_offset = BATADV_TT_PART_NONE;
+	struct batadv_tvlv_tt_part *tt_part;
 	struct batadv_hard_iface *primary_if;
 	bool ret = false;
 	int i, size;
@@ -3155,12 +3999,23 @@ static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
 	if (!tt_req_node)
 		goto out;
 
+	if (full_table) {
+		spin_lock_bh(&dst_orig_node->tt_lock);
+		if (dst_orig_node->tt_part_ttvn == ttvn)
+			part_offset = dst_orig_node->tt_part_offset;
+		spin_unlock_bh(&dst_orig_node->tt_lock);
+	}
+
 	size = sizeof(*tvlv_tt_data) + sizeof(*tt_vlan_req) * num_vlan;
+	if (part_offset != BATADV_TT_PART_NONE)
+		size += sizeof(*tt_part);
+
 	tvlv_tt_data = kzalloc(size, GFP_ATOMIC);
 	if (!tvlv_tt_data)
 		goto out;
 
-	tvlv_tt_data->flags = BATADV_TT_REQUEST;
+	tvlv_tt_data->flags = BATADV_TT_REQUEST | BATADV_TT_MULTIPART |
+			      BATADV_TT_COMPRESSED;
 	tvlv_tt_data->ttvn = ttvn;
 	tvlv_tt_data->num_vlan = htons(num_vlan);
 
@@ -3176,11 +4031,18 @@ static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
 		tt_vlan++;
 	}
 
+	if (part_offset != BATADV_TT_PART_NONE) {
+		tt_part = (struct batadv_tvlv_tt_part *)tt_vlan_req;
+		tt_part->offset = htonl(part_offset);
+	}
+
 	if (full_table)
 		tvlv_tt_data->flags |= BATADV_TT_FULL_TABLE;
 
-	batadv_dbg(BATADV_DBG_TT, bat_priv, "Sending TT_REQUEST to %pM [%c]\n",
-		   dst_orig_node->orig, full_table ? 'F' : '.');
+	batadv_dbg(BATADV_DBG_TT, bat_priv,
+		   "Sending TT_REQUEST to %pM [%c] (resume: %u)\n",
+		   dst_orig_node->orig, full_table ? 'F' : '.',
+		   part_offset == BATADV_TT_PART_NONE ? 0 : part_offset);
 
 	batadv_inc_counter(bat_priv, BATADV_CNT_TT_REQUEST_TX);
 	batadv_tvlv_unicast_send(bat_priv, primary_if->net_dev->dev_addr,
@@ -3213,6 +4075,8 @@ static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
  *  node's translation table
  * @bat_priv: the bat priv with all the soft interface information
  * @tt_data: tt data containing the tt request information
+ * @part_offset: number of entries the requester already received of a full
+ *  table sent in several parts
  * @req_src: mac address of tt request sender
  * @req_dst: mac address of tt request recipient
  *
@@ -3220,13 +4084,15 @@ static bool batadv_send_tt_request(struct batadv_priv *bat_priv,
  */
 static bool batadv_send_other_tt_response(struct batadv_priv *bat_priv,
 					  struct batadv_tvlv_tt_data *tt_data,
-					  u8 *req_src, u8 *req_dst)
+					  u32 part_offset, u8 *req_src,
+					  u8 *req_dst)
 {
 	struct batadv_orig_node *req_dst_orig_node;
 	struct batadv_orig_node *res_dst_orig_node = NULL;
 	struct batadv_tvlv_tt_change *tt_change;
 	struct batadv_tvlv_tt_data *tvlv_tt_data = NULL;
 	struct batadv_tvlv_tt_vlan_data *tt_vlan;
+	bool compress = tt_data->flags & BATADV_TT_COMPRESSED;
 	bool ret = false, full_table;
 	u8 orig_ttvn, req_ttvn;
 	u16 tvlv_len;
@@ -3263,9 +4129,6 @@ static bool batadv_send_other_tt_response(struct batadv_priv *bat_priv,
 	else
 		full_table = false;
 
-	/* TT fragmentation hasn't been implemented yet, so send as many
-	 * TT entries fit a single packet as possible only
-	 */
 	if (!full_table) {
 		spin_lock_bh(&req_dst_orig_node->tt_buff_lock);
 		tt_len = req_dst_orig_node->tt_buff_len;
@@ -3281,6 +4144,34 @@ static bool batadv_send_other_tt_response(struct batadv_priv *bat_priv,
 		memcpy(tt_change, req_dst_orig_node->tt_buff,
 		       req_dst_orig_node->tt_buff_len);
 		spin_unlock_bh(&req_dst_orig_node->tt_buff_lock);
+	} else if (tt_data->flags & BATADV_TT_MULTIPART &&
+		   !batadv_tt_global_table_fits(bat_priv, req_dst_orig_node)) {
+		/* the requester accepts the table in several parts: only
+		 * prepare the tt_data and tt_vlan_data header for them
+		 */
+		tt_len = 0;
+		tvlv_len = batadv_tt_prepare_tvlv_global_data(req_dst_orig_node,
+							      &tvlv_tt_data,
+							      &tt_change,
+							      &tt_len);
+		if (!tvlv_tt_data)
+			goto out;
+
+		tvlv_tt_data->flags = BATADV_TT_RESPONSE | BATADV_TT_FULL_TABLE;
+		tvlv_tt_data->ttvn = req_ttvn;
+
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Sending TT_RESPONSE %pM for %pM [F] in parts (ttvn: %u)\n",
+			   res_dst_orig_node->orig, req_dst_orig_node->orig,
+			   req_ttvn);
+
+		ret = batadv_tt_send_full_table_parts(bat_priv, tvlv_tt_data,
+						      tvlv_len,
+						      req_dst_orig_node,
+						      req_dst_orig_node->orig,
+						      req_src, compress,
+						      part_offset);
+		goto out;
 	} else {
 		/* allocate the tvlv, put the tt_data and all the tt_vlan_data
 		 * in the initial part
@@ -3320,11 +4211,8 @@ static bool batadv_send_other_tt_response(struct batadv_priv *bat_priv,
 		   res_dst_orig_node->orig, req_dst_orig_node->orig,
 		   full_table ? 'F' : '.', req_ttvn);
 
-	batadv_inc_counter(bat_priv, BATADV_CNT_TT_RESPONSE_TX);
-
-	batadv_tvlv_unicast_send(bat_priv, req_dst_orig_node->orig,
-				 req_src, BATADV_TVLV_TT, 1, tvlv_tt_data,
-				 tvlv_len);
+	batadv_tt_send_response(bat_priv, req_dst_orig_node->orig, req_src,
+				tvlv_tt_data, tvlv_len, compress);
 
 	ret = true;
 	goto out;
@@ -3346,17 +4234,20 @@ static bool batadv_send_other_tt_response(struct batadv_priv *bat_priv,
  *  node's translation table
  * @bat_priv: the bat priv with all the soft interface information
  * @tt_data: tt data containing the tt request information
+ * @part_offset: number of entries the requester already received of a full
+ *  table sent in several parts
  * @req_src: mac address of tt request sender
  *
  * Return: true if tt request reply was sent, false otherwise.
  */
 static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
 				       struct batadv_tvlv_tt_data *tt_data,
-				       u8 *req_src)
+				       u32 part_offset, u8 *req_src)
 {
 	struct batadv_tvlv_tt_data *tvlv_tt_data = NULL;
 	struct batadv_hard_iface *primary_if = NULL;
 	struct batadv_tvlv_tt_change *tt_change;
+	bool compress = tt_data->flags & BATADV_TT_COMPRESSED;
 	struct batadv_orig_node *orig_node;
 	u8 my_ttvn, req_ttvn;
 	u16 tvlv_len;
@@ -3390,9 +4281,6 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
 	else
 		full_table = false;
 
-	/* TT fragmentation hasn't been implemented yet, so send as many
-	 * TT entries fit a single packet as possible only
-	 */
 	if (!full_table) {
 		spin_lock_bh(&bat_priv->tt.last_changeset_lock);
 
@@ -3408,6 +4296,33 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
 		memcpy(tt_change, bat_priv->tt.last_changeset,
 		       bat_priv->tt.last_changeset_len);
 		spin_unlock_bh(&bat_priv->tt.last_changeset_lock);
+	} else if (tt_data->flags & BATADV_TT_MULTIPART &&
+		   !batadv_tt_local_table_fits(bat_priv)) {
+		req_ttvn = (u8)atomic_read(&bat_priv->tt.vn);
+
+		/* the requester accepts the table in several parts: only
+		 * prepare the tt_data and tt_vlan_data header for them
+		 */
+		tt_len = 0;
+		tvlv_len = batadv_tt_prepare_tvlv_local_data(bat_priv,
+							     &tvlv_tt_data,
+							     &tt_change,
+							     &tt_len);
+		if (!tvlv_len)
+			goto out;
+
+		tvlv_tt_data->flags = BATADV_TT_RESPONSE | BATADV_TT_FULL_TABLE;
+		tvlv_tt_data->ttvn = req_ttvn;
+
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Sending TT_RESPONSE to %pM [F] in parts (ttvn: %u)\n",
+			   orig_node->orig, req_ttvn);
+
+		batadv_tt_send_full_table_parts(bat_priv, tvlv_tt_data,
+						tvlv_len, NULL,
+						primary_if->net_dev->dev_addr,
+						req_src, compress, part_offset);
+		goto out;
 	} else {
 		req_ttvn = (u8)atomic_read(&bat_priv->tt.vn);
 
@@ -3428,6 +4343,15 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
 					batadv_tt_local_valid, NULL);
 	}
 
+	/* Don't send the response, if larger than fragmented packet. */
+	if (batadv_tt_response_size(tvlv_len) >
+	    atomic_read(&bat_priv->packet_size_max)) {
+		net_ratelimited_function(batadv_info, bat_priv->soft_iface,
+					 "Ignoring TT_REQUEST from %pM; Response size exceeds max packet size.\n",
+					 orig_node->orig);
+		goto out;
+	}
+
 	tvlv_tt_data->flags = BATADV_TT_RESPONSE;
 	tvlv_tt_data->ttvn = req_ttvn;
 
@@ -3438,11 +4362,8 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
 		   "Sending TT_RESPONSE to %pM [%c] (ttvn: %u)\n",
 		   orig_node->orig, full_table ? 'F' : '.', req_ttvn);
 
-	batadv_inc_counter(bat_priv, BATADV_CNT_TT_RESPONSE_TX);
-
-	batadv_tvlv_unicast_send(bat_priv, primary_if->net_dev->dev_addr,
-				 req_src, BATADV_TVLV_TT, 1, tvlv_tt_data,
-				 tvlv_len);
+	batadv_tt_send_response(bat_priv, primary_if->net_dev->dev_addr,
+				req_src, tvlv_tt_data, tvlv_len, compress);
 
 	goto out;
 
@@ -3463,6 +4384,8 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
  * batadv_send_tt_response() - send reply to tt request
  * @bat_priv: the bat priv with all the soft interface information
  * @tt_data: tt data containing the tt request information
+ * @part_offset: number of entries the requester already received of a full
+ *  table sent in several parts
  * @req_src: mac address of tt request sender
  * @req_dst: mac address of tt request recipient
  *
@@ -3470,12 +4393,42 @@ static bool batadv_send_my_tt_response(struct batadv_priv *bat_priv,
  */
 static bool batadv_send_tt_response(struct batadv_priv *bat_priv,
 				    struct batadv_tvlv_tt_data *tt_data,
-				    u8 *req_src, u8 *req_dst)
+				    u32 part_offset, u8 *req_src, u8 *req_dst)
 {
 	if (batadv_is_my_mac(bat_priv, req_dst))
-		return batadv_send_my_tt_response(bat_priv, tt_data, req_src);
-	return batadv_send_other_tt_response(bat_priv, tt_data, req_src,
-					     req_dst);
+		return batadv_send_my_tt_response(bat_priv, tt_data,
+						  part_offset, req_src);
+	return batadv_send_other_tt_response(bat_priv, tt_data, part_offset,
+					     req_src, req_dst);
+}
+
+/**
+ * batadv_tt_update_change() - apply a single tt change to the global table
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator announcing the change
+ * @tt_change: the change to apply
+ * @ttvn: translation table version number of the change
+ *
+ * Return: false if a global entry could not be stored, true otherwise.
+ */
+static bool batadv_tt_update_change(struct batadv_priv *bat_priv,
+				    struct batadv_orig_node *orig_node,
+				    struct batadv_tvlv_tt_change *tt_change,
+				    u8 ttvn)
+{
+	int roams;
+
+	if (tt_change->flags & BATADV_TT_CLIENT_DEL) {
+		roams = tt_change->flags & BATADV_TT_CLIENT_ROAM;
+		batadv_tt_global_del(bat_priv, orig_node, tt_change->addr,
+				     ntohs(tt_change->vid),
+				     "tt removed by changes", roams);
+		return true;
+	}
+
+	return batadv_tt_global_add(bat_priv, orig_node, tt_change->addr,
+				    ntohs(tt_change->vid), tt_change->flags,
+				    ttvn);
 }
 
 static void _batadv_tt_update_changes(struct batadv_priv *bat_priv,
@@ -3484,31 +4437,293 @@ static void _batadv_tt_update_changes(struct batadv_priv *bat_priv,
 				      u16 tt_num_changes, u8 ttvn)
 {
 	int i;
-	int roams;
 
 	for (i = 0; i < tt_num_changes; i++) {
-		if ((tt_change + i)->flags & BATADV_TT_CLIENT_DEL) {
-			roams = (tt_change + i)->flags & BATADV_TT_CLIENT_ROAM;
-			batadv_tt_global_del(bat_priv, orig_node,
-					     (tt_change + i)->addr,
-					     ntohs((tt_change + i)->vid),
-					     "tt removed by changes",
-					     roams);
-		} else {
-			if (!batadv_tt_global_add(bat_priv, orig_node,
-						  (tt_change + i)->addr,
-						  ntohs((tt_change + i)->vid),
-						  (tt_change + i)->flags, ttvn))
-				/* In case of problem while storing a
-				 * global_entry, we stop the updating
-				 * procedure without committing the
-				 * ttvn change. This will avoid to send
-				 * corrupted data on tt_request
-				 */
-				return;
+		if (!batadv_tt_update_change(bat_priv, orig_node,
+					     tt_change + i, ttvn))
+			/* In case of problem while storing a
+			 * global_entry, we stop the updating
+			 * procedure without committing the
+			 * ttvn change. This will avoid to send
+			 * corrupted data on tt_request
+			 */
+			return;
+	}
+	set_bit(BATADV_ORIG_CAPA_HAS_TT, &orig_node->capa_initialized);
+}
+
+/**
+ * batadv_tt_bulk_item_cmp() - compare two bulk items by hash bucket
+ * @a: first bulk item
+ * @b: second bulk item
+ *
+ * Return: <0, 0 or >0 if @a sorts before, equal to or after @b
+ */
+static int batadv_tt_bulk_item_cmp(const void *a, const void *b)
+{
+	const struct batadv_tt_bulk_item *item_a = a;
+	const struct batadv_tt_bulk_item *item_b = b;
+
+	if (item_a->index == item_b->index)
+		return 0;
+
+	return item_a->index < item_b->index ? -1 : 1;
+}
+
+/**
+ * batadv_tt_bulk_item_init() - initialize the preallocated objects of a bulk
+ *  item
+ * @orig_node: the originator announcing the client
+ * @item: the bulk item to initialize
+ * @ttvn: translation table version number of the full table
+ *
+ * The objects are only linked together, they are published in the global hash
+ * by batadv_tt_global_add_bulk().
+ */
+static void batadv_tt_bulk_item_init(struct batadv_orig_node *orig_node,
+				     struct batadv_tt_bulk_item *item, u8 ttvn)
+{
+	struct batadv_tt_global_entry *tt_global = item->tt_global;
+	struct batadv_tt_orig_list_entry *orig_entry = item->orig_entry;
+	struct batadv_tt_common_entry *common = &tt_global->common;
+	u8 flags = item->change->flags;
+
+	memset(tt_global, 0, sizeof(*tt_global));
+	ether_addr_copy(common->addr, item->change->addr);
+	common->vid = ntohs(item->change->vid);
+	common->flags = flags & BATADV_TT_SYNC_MASK;
+	if (!is_multicast_ether_addr(common->addr))
+		common->flags |= flags & (~BATADV_TT_SYNC_MASK);
+	common->added_at = jiffies;
+	/* one reference for the hash, one for batadv_tt_global_add_bulk() */
+	kref_init(&common->refcount);
+	kref_get(&common->refcount);
+
+	INIT_HLIST_HEAD(&tt_global->orig_list);
+	atomic_set(&tt_global->orig_list_count, 1);
+	spin_lock_init(&tt_global->list_lock);
+
+	memset(orig_entry, 0, sizeof(*orig_entry));
+	kref_get(&orig_node->refcount);
+	orig_entry->orig_node = orig_node;
+	orig_entry->ttvn = ttvn;
+	orig_entry->flags = flags & BATADV_TT_SYNC_MASK;
+	kref_init(&orig_entry->refcount);
+	hlist_add_head(&orig_entry->list, &tt_global->orig_list);
+}
+
+/**
+ * batadv_tt_bulk_item_release() - free the objects of an unpublished bulk item
+ * @item: the bulk item to release
+ */
+static void batadv_tt_bulk_item_release(struct batadv_tt_bulk_item *item)
+{
+	batadv_orig_node_put(item->orig_entry->orig_node);
+	kmem_cache_free(batadv_tt_orig_cache, item->orig_entry);
+	kmem_cache_free(batadv_tg_cache, item->tt_global);
+}
+
+/**
+ * batadv_tt_global_add_bulk() - add a batch of full table entries to the
+ *  global table
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator announcing the clients
+ * @bulk: scratch space for the batch
+ * @tt_change: the entries to add
+ * @num_entries: number of entries, at most BATADV_TT_BULK_SIZE
+ * @ttvn: translation table version number of the full table
+ *
+ * Plain additions of clients which are not yet in the global table are the
+ * common case when a full table was just purged: their objects are allocated
+ * in one go and the entries are sorted by hash bucket so that every bucket
+ * lock is only taken once. Everything else (temporary and roaming clients,
+ * clients already announced by other originators, allocation failures) falls
+ * back to batadv_tt_update_change().
+ *
+ * Return: false if a global entry could not be stored, true otherwise.
+ */
+static bool batadv_tt_global_add_bulk(struct batadv_priv *bat_priv,
+				      struct batadv_orig_node *orig_node,
+				      struct batadv_tt_bulk *bulk,
+				      struct batadv_tvlv_tt_change *tt_change,
+				      u16 num_entries, u8 ttvn)
+{
+	struct batadv_hashtable *hash = bat_priv->tt.global_hash;
+	struct batadv_tt_common_entry *common;
+	struct batadv_tt_bulk_item *item;
+	struct hlist_node *node;
+	struct hlist_head *head;
+	bool ret = true, found;
+	int num_items = 0;
+	u16 local_flags;
+	u32 index;
+	int i, j;
+
+	for (i = 0; i < num_entries; i++, tt_change++) {
+		if (tt_change->flags & (BATADV_TT_CLIENT_DEL |
+					BATADV_TT_CLIENT_ROAM |
+					BATADV_TT_CLIENT_TEMP)) {
+			if (!batadv_tt_update_change(bat_priv, orig_node,
+						     tt_change, ttvn))
+				ret = false;
+			continue;
+		}
+
+		/* ignore global entries from backbone nodes */
+		if (batadv_bla_is_backbone_gw_orig(bat_priv, orig_node->orig,
+						   ntohs(tt_change->vid)))
+			continue;
+
+		bulk->items[num_items++].change = tt_change;
+	}
+
+	if (num_items == 0)
+		return ret;
+
+	if (!kmem_cache_alloc_bulk(batadv_tg_cache, GFP_ATOMIC, num_items,
+				   bulk->tt_global))
+		goto fallback;
+
+	if (!kmem_cache_alloc_bulk(batadv_tt_orig_cache, GFP_ATOMIC, num_items,
+				   bulk->orig_entry)) {
+		kmem_cache_free_bulk(batadv_tg_cache, num_items,
+				     bulk->tt_global);
+		goto fallback;
+	}
+
+	for (i = 0; i < num_items; i++) {
+		item = &bulk->items[i];
+		item->tt_global = bulk->tt_global[i];
+		item->orig_entry = bulk->orig_entry[i];
+		batadv_tt_bulk_item_init(orig_node, item, ttvn);
+		item->index = batadv_choose_tt(&item->tt_global->common,
+					       hash->size);
+	}
+
+	sort(bulk->items, num_items, sizeof(bulk->items[0]),
+	     batadv_tt_bulk_item_cmp, NULL);
+
+	for (i = 0; i < num_items; i = j) {
+		index = bulk->items[i].index;
+		head = &hash->table[index];
+
+		spin_lock_bh(&hash->list_locks[index]);
+		for (j = i; j < num_items && bulk->items[j].index == index;
+		     j++) {
+			item = &bulk->items[j];
+			common = &item->tt_global->common;
+
+			found = false;
+			hlist_for_each(node, head) {
+				if (!batadv_compare_tt(node, common))
+					continue;
+
+				found = true;
+				break;
+			}
+
+			if (found) {
+				/* handled by the slow path below */
+				item->published = false;
+				continue;
+			}
+
+			hlist_add_head_rcu(&common->hash_entry, head);
+			item->published = true;
+		}
+		spin_unlock_bh(&hash->list_locks[index]);
+	}
+
+	batadv_tt_global_gen_inc(bat_priv);
+
+	for (i = 0; i < num_items; i++) {
+		item = &bulk->items[i];
+		common = &item->tt_global->common;
+
+		if (!item->published) {
+			batadv_tt_bulk_item_release(item);
+			if (!batadv_tt_update_change(bat_priv, orig_node,
+						     item->change, ttvn))
+				ret = false;
+			continue;
+		}
+
+		batadv_tt_global_size_inc(orig_node, common->vid);
+
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Creating new global tt entry: %pM (vid: %d, via %pM)\n",
+			   common->addr, batadv_print_vid(common->vid),
+			   orig_node->orig);
+
+		/* Do not remove multicast addresses from the local hash on
+		 * global additions
+		 */
+		if (!is_multicast_ether_addr(common->addr)) {
+			local_flags = batadv_tt_local_remove(bat_priv,
+							     common->addr,
+							     common->vid,
+							     "global tt received",
+							     false);
+			common->flags |= local_flags & BATADV_TT_CLIENT_WIFI;
 		}
+
+		batadv_tt_global_entry_put(item->tt_global);
+	}
+
+	return ret;
+
+fallback:
+	for (i = 0; i < num_items; i++) {
+		if (!batadv_tt_update_change(bat_priv, orig_node,
+					     bulk->items[i].change, ttvn))
+			ret = false;
+	}
+
+	return ret;
+}
+
+/**
+ * batadv_tt_update_full_table() - apply the entries of a full table
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator the table belongs to
+ * @tt_change: the entries of the table
+ * @num_entries: number of entries
+ * @ttvn: translation table version number of the full table
+ *
+ * Same as _batadv_tt_update_changes() but the old table of the originator must
+ * already be purged, which allows to insert the entries in batches.
+ */
+static void batadv_tt_update_full_table(struct batadv_priv *bat_priv,
+					struct batadv_orig_node *orig_node,
+					struct batadv_tvlv_tt_change *tt_change,
+					u16 num_entries, u8 ttvn)
+{
+	struct batadv_tt_bulk *bulk;
+	u16 batch;
+	int i;
+
+	bulk = kmalloc(sizeof(*bulk), GFP_ATOMIC);
+	if (!bulk) {
+		_batadv_tt_update_changes(bat_priv, orig_node, tt_change,
+					  num_entries, ttvn);
+		return;
+	}
+
+	for (i = 0; i < num_entries; i += batch) {
+		batch = min_t(u16, num_entries - i, BATADV_TT_BULK_SIZE);
+
+		if (!batadv_tt_global_add_bulk(bat_priv, orig_node, bulk,
+					       tt_change + i, batch, ttvn))
+			/* as in _batadv_tt_update_changes(): do not mark the
+			 * table as initialized after a failure
+			 */
+			goto out;
 	}
+
 	set_bit(BATADV_ORIG_CAPA_HAS_TT, &orig_node->capa_initialized);
+
+out:
+	kfree(bulk);
 }
 
 static void batadv_tt_fill_gtable(struct batadv_priv *bat_priv,
@@ -3526,8 +4741,8 @@ static void batadv_tt_fill_gtable(struct batadv_priv *bat_priv,
 	batadv_tt_global_del_orig(bat_priv, orig_node, -1,
 				  "Received full table");
 
-	_batadv_tt_update_changes(bat_priv, orig_node, tt_change, num_entries,
-				  ttvn);
+	batadv_tt_update_full_table(bat_priv, orig_node, tt_change,
+				    num_entries, ttvn);
 
 	spin_lock_bh(&orig_node->tt_buff_lock);
 	kfree(orig_node->tt_buff);
@@ -3536,12 +4751,84 @@ static void batadv_tt_fill_gtable(struct batadv_priv *bat_priv,
 	spin_unlock_bh(&orig_node->tt_buff_lock);
 
 	atomic_set(&orig_node->last_ttvn, ttvn);
+	orig_node->tt_part_offset = BATADV_TT_PART_NONE;
 
 out:
 	if (orig_node)
 		batadv_orig_node_put(orig_node);
 }
 
+/**
+ * batadv_tt_fill_gtable_part() - apply one part of a full table split into
+ *  several TT responses
+ * @bat_priv: the bat priv with all the soft interface information
+ * @orig_node: the originator the table belongs to
+ * @tt_change: pointer to the first entry of this part
+ * @ttvn: translation table version number of the full table
+ * @offset: number of entries carried by the previous parts
+ * @num_entries: number of entries of this part
+ * @last: whether this is the last part of the table
+ *
+ * The first part purges the old table of the originator, the following parts
+ * are only accepted in order. Parts already applied are ignored. When a part
+ * got lost, the entries received so far are kept and the next full table
+ * request asks to resume the transfer. The ttvn is committed with the last
+ * part. Has to be called with orig_node->tt_lock held.
+ *
+ * Return: true if the transfer is finished (completed, interrupted or
+ * aborted), false if more parts are expected.
+ */
+static bool batadv_tt_fill_gtable_part(struct batadv_priv *bat_priv,
+				       struct batadv_orig_node *orig_node,
+				       struct batadv_tvlv_tt_change *tt_change,
+				       u8 ttvn, u32 offset, u16 num_entries,
+				       bool last)
+{
+	if (offset == 0) {
+		batadv_tt_global_del_orig(bat_priv, orig_node, -1,
+					  "Received first part of full table");
+		orig_node->tt_part_ttvn = ttvn;
+		orig_node->tt_part_offset = 0;
+	} else if (orig_node->tt_part_offset == BATADV_TT_PART_NONE ||
+		   orig_node->tt_part_ttvn != ttvn) {
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Unexpected full table part from %pM (ttvn: %u offset: %u), dropping transfer\n",
+			   orig_node->orig, ttvn, offset);
+		orig_node->tt_part_offset = BATADV_TT_PART_NONE;
+		return true;
+	} else if (offset < orig_node->tt_part_offset) {
+		/* resumed transfers may repeat parts already applied */
+		return false;
+	} else if (offset > orig_node->tt_part_offset) {
+		/* a part got lost: the next OGM detects the ttvn mismatch and
+		 * the full table request resumes the transfer from here
+		 */
+		batadv_dbg(BATADV_DBG_TT, bat_priv,
+			   "Missing full table part from %pM (ttvn: %u offset: %u), interrupting transfer at %u\n",
+			   orig_node->orig, ttvn, offset,
+			   orig_node->tt_part_offset);
+		return true;
+	}
+
+	batadv_tt_update_full_table(bat_priv, orig_node, tt_change,
+				    num_entries, ttvn);
+	orig_node->tt_part_offset += num_entries;
+
+	if (!last)
+		return false;
+
+	spin_lock_bh(&orig_node->tt_buff_lock);
+	kfree(orig_node->tt_buff);
+	orig_node->tt_buff_len = 0;
+	orig_node->tt_buff = NULL;
+	spin_unlock_bh(&orig_node->tt_buff_lock);
+
+	atomic_set(&orig_node->last_ttvn, ttvn);
+	orig_node->tt_part_offset = BATADV_TT_PART_NONE;
+
+	return true;
+}
+
 static void batadv_tt_update_changes(struct batadv_priv *bat_priv,
 				     struct batadv_orig_node *orig_node,
 				     u16 tt_num_changes, u8 ttvn,
@@ -3600,8 +4887,10 @@ static void batadv_handle_tt_response(struct batadv_priv *bat_priv,
 	struct hlist_node *safe;
 	struct batadv_orig_node *orig_node = NULL;
 	struct batadv_tvlv_tt_change *tt_change;
+	struct batadv_tvlv_tt_part *tt_part;
 	u8 *tvlv_ptr = (u8 *)tt_data;
 	u16 change_offset;
+	bool done;
 
 	batadv_dbg(BATADV_DBG_TT, bat_priv,
 		   "Received TT_RESPONSE from %pM for ttvn %d t_size: %d [%c]\n",
@@ -3619,11 +4908,27 @@ static void batadv_handle_tt_response(struct batadv_priv *bat_priv,
 	change_offset += sizeof(*tt_data);
 	tvlv_ptr += change_offset;
 
-	tt_change = (struct batadv_tvlv_tt_change *)tvlv_ptr;
-	if (tt_data->flags & BATADV_TT_FULL_TABLE) {
+	if (tt_data->flags & BATADV_TT_MULTIPART) {
+		tt_part = (struct batadv_tvlv_tt_part *)tvlv_ptr;
+		tt_change = (struct batadv_tvlv_tt_change *)(tt_part + 1);
+
+		done = batadv_tt_fill_gtable_part(bat_priv, orig_node,
+						  tt_change, tt_data->ttvn,
+						  ntohl(tt_part->offset),
+						  num_entries,
+						  tt_data->flags &
+						  BATADV_TT_LAST_PART);
+		if (!done) {
+			/* keep the tt_req_node until the last part arrived */
+			spin_unlock_bh(&orig_node->tt_lock);
+			goto out;
+		}
+	} else if (tt_data->flags & BATADV_TT_FULL_TABLE) {
+		tt_change = (struct batadv_tvlv_tt_change *)tvlv_ptr;
 		batadv_tt_fill_gtable(bat_priv, tt_change, tt_data->ttvn,
 				      resp_src, num_entries);
 	} else {
+		tt_change = (struct batadv_tvlv_tt_change *)tvlv_ptr;
 		batadv_tt_update_changes(bat_priv, orig_node, num_entries,
 					 tt_data->ttvn, tt_change);
 	}
@@ -3810,6 +5115,9 @@ void batadv_tt_free(struct batadv_priv *bat_priv)
 
 	cancel_delayed_work_sync(&bat_priv->tt.work);
 
+	/* the transfers walk the tables */
+	batadv_tt_part_tx_list_free(bat_priv);
+
 	batadv_tt_local_table_free(bat_priv);
 	batadv_tt_global_table_free(bat_priv);
 	batadv_tt_req_list_free(bat_priv);
@@ -4162,47 +5470,6 @@ bool batadv_tt_add_temporary_global_entry(struct batadv_priv *bat_priv,
 	return true;
 }
 
-/**
- * batadv_tt_local_resize_to_mtu() - resize the local translation table fit the
- *  maximum packet size that can be transported through the mesh
- * @soft_iface: netdev struct of the mesh interface
- *
- * Remove entries older than 'timeout' and half timeout if more entries need
- * to be removed.
- */
-void batadv_tt_local_resize_to_mtu(struct net_device *soft_iface)
-{
-	struct batadv_priv *bat_priv = netdev_priv(soft_iface);
-	int packet_size_max = atomic_read(&bat_priv->packet_size_max);
-	int table_size, timeout = BATADV_TT_LOCAL_TIMEOUT / 2;
-	bool reduced = false;
-
-	spin_lock_bh(&bat_priv->tt.commit_lock);
-
-	while (true) {
-		table_size = batadv_tt_local_table_transmit_size(bat_priv);
-		if (packet_size_max >= table_size)
-			break;
-
-		batadv_tt_local_purge(bat_priv, timeout);
-		batadv_tt_local_purge_pending_clients(bat_priv);
-
-		timeout /= 2;
-		reduced = true;
-		net_ratelimited_function(batadv_info, soft_iface,
-					 "Forced to purge local tt entries to fit new maximum fragment MTU (%i)\n",
-					 packet_size_max);
-	}
-
-	/* commit these changes immediately, to avoid synchronization problem
-	 * with the TTVN
-	 */
-	if (reduced)
-		batadv_tt_local_commit_changes_nolock(bat_priv);
-
-	spin_unlock_bh(&bat_priv->tt.commit_lock);
-}
-
 /**
  * batadv_tt_tvlv_ogm_handler_v1() - process incoming tt tvlv container
  * @bat_priv: the bat priv with all the soft interface information
@@ -4259,8 +5526,10 @@ static int batadv_tt_tvlv_unicast_handler_v1(struct batadv_priv *bat_priv,
 					     void *tvlv_value,
 					     u16 tvlv_value_len)
 {
-	struct batadv_tvlv_tt_data *tt_data;
+	struct batadv_tvlv_tt_data *tt_data, *decoded;
+	struct batadv_tvlv_tt_part *tt_part;
 	u16 tt_vlan_len, tt_num_entries;
+	u32 part_offset = 0;
 	char tt_flag;
 	bool ret;
 
@@ -4283,10 +5552,19 @@ static int batadv_tt_tvlv_unicast_handler_v1(struct batadv_priv *bat_priv,
 	case BATADV_TT_REQUEST:
 		batadv_inc_counter(bat_priv, BATADV_CNT_TT_REQUEST_RX);
 
+		/* resumption of an interrupted full table transfer */
+		if (tt_data->flags & BATADV_TT_MULTIPART &&
+		    tvlv_value_len >= sizeof(*tt_part)) {
+			tt_part = (struct batadv_tvlv_tt_part *)
+				  ((u8 *)(tt_data + 1) + tt_vlan_len);
+			part_offset = ntohl(tt_part->offset);
+		}
+
 		/* If this node cannot provide a TT response the tt_request is
 		 * forwarded
 		 */
-		ret = batadv_send_tt_response(bat_priv, tt_data, src, dst);
+		ret = batadv_send_tt_response(bat_priv, tt_data, part_offset,
+					      src, dst);
 		if (!ret) {
 			if (tt_data->flags & BATADV_TT_FULL_TABLE)
 				tt_flag = 'F';
@@ -4304,6 +5582,34 @@ static int batadv_tt_tvlv_unicast_handler_v1(struct batadv_priv *bat_priv,
 		batadv_inc_counter(bat_priv, BATADV_CNT_TT_RESPONSE_RX);
 
 		if (batadv_is_my_mac(bat_priv, dst)) {
+			if (tt_data->flags & BATADV_TT_MULTIPART) {
+				/* parts only exist for full tables */
+				if (!(tt_data->flags & BATADV_TT_FULL_TABLE))
+					return NET_RX_SUCCESS;
+
+				if (tvlv_value_len <
+				    sizeof(struct batadv_tvlv_tt_part))
+					return NET_RX_SUCCESS;
+
+				tvlv_value_len -=
+					sizeof(struct batadv_tvlv_tt_part);
+				tt_num_entries =
+					batadv_tt_entries(tvlv_value_len);
+			}
+
+			if (tt_data->flags & BATADV_TT_COMPRESSED) {
+				decoded = batadv_tt_decompress_response(tt_data,
+									tvlv_value_len,
+									&tt_num_entries);
+				if (!decoded)
+					return NET_RX_SUCCESS;
+
+				batadv_handle_tt_response(bat_priv, decoded,
+							  src, tt_num_entries);
+				kfree(decoded);
+				return NET_RX_SUCCESS;
+			}
+
 			batadv_handle_tt_response(bat_priv, tt_data,
 						  src, tt_num_entries);
 			return NET_RX_SUCCESS;
@@ -19,6 +19,7 @@
 #include "main.h"
 
 #include <linux/byteorder/generic.h>
+#include <linux/compiler.h>
 #include <linux/etherdevice.h>
 #include <linux/gfp.h>
 #include <linux/if_ether.h>
@@ -66,34 +67,51 @@ static void batadv_tvlv_handler_put(struct batadv_tvlv_handler *tvlv_handler)
 }
 
 /**
- * batadv_tvlv_handler_get() - retrieve tvlv handler from the tvlv handler list
- *  based on the provided type and version (both need to match)
+ * batadv_tvlv_handler_lookup() - retrieve tvlv handler from the tvlv handler
+ *  table based on the provided type and version (both need to match)
  * @bat_priv: the bat priv with all the soft interface information
  * @type: tvlv handler type to look for
  * @version: tvlv handler version to look for
  *
+ * The caller has to hold the rcu_read_lock (or the handler_list_lock) for as
+ * long as the returned tvlv handler is used. No reference is acquired.
+ *
  * Return: tvlv handler if found or NULL otherwise.
  */
 static struct batadv_tvlv_handler *
-batadv_tvlv_handler_get(struct batadv_priv *bat_priv, u8 type, u8 version)
+batadv_tvlv_handler_lookup(struct batadv_priv *bat_priv, u8 type, u8 version)
 {
-	struct batadv_tvlv_handler *tvlv_handler_tmp, *tvlv_handler = NULL;
+	struct batadv_tvlv_handler *tvlv_handler;
+	struct hlist_head *head = &bat_priv->tvlv.handler_table[type];
 
-	rcu_read_lock();
-	hlist_for_each_entry_rcu(tvlv_handler_tmp,
-				 &bat_priv->tvlv.handler_list, list) {
-		if (tvlv_handler_tmp->type != type)
+	hlist_for_each_entry_rcu(tvlv_handler, head, table_node) {
+		if (tvlv_handler->version != version)
 			continue;
 
-		if (tvlv_handler_tmp->version != version)
-			continue;
+		return tvlv_handler;
+	}
 
-		if (!kref_get_unless_zero(&tvlv_handler_tmp->refcount))
-			continue;
+	return NULL;
+}
 
-		tvlv_handler = tvlv_handler_tmp;
-		break;
-	}
+/**
+ * batadv_tvlv_handler_get() - retrieve tvlv handler from the tvlv handler list
+ *  based on the provided type and version (both need to match)
+ * @bat_priv: the bat priv with all the soft interface information
+ * @type: tvlv handler type to look for
+ * @version: tvlv handler version to look for
+ *
+ * Return: tvlv handler if found or NULL otherwise.
+ */
+static struct batadv_tvlv_handler *
+batadv_tvlv_handler_get(struct batadv_priv *bat_priv, u8 type, u8 version)
+{
+	struct batadv_tvlv_handler *tvlv_handler;
+
+	rcu_read_lock();
+	tvlv_handler = batadv_tvlv_handler_lookup(bat_priv, type, version);
+	if (tvlv_handler && !kref_get_unless_zero(&tvlv_handler->refcount))
+		tvlv_handler = NULL;
 	rcu_read_unlock();
 
 	return tvlv_handler;
@@ -204,6 +222,90 @@ static void batadv_tvlv_container_remove(struct batadv_priv *bat_priv,
 	batadv_tvlv_container_put(tvlv);
 }
 
+/**
+ * batadv_tvlv_container_equal() - check whether a tvlv container carries the
+ *  given content
+ * @tvlv: tvlv container, may be NULL
+ * @type: tvlv container type
+ * @version: tvlv container version
+ * @tvlv_value: tvlv container content
+ * @tvlv_value_len: tvlv container content length
+ *
+ * Return: true if type, version, length and payload of the container match
+ */
+static bool batadv_tvlv_container_equal(struct batadv_tvlv_container *tvlv,
+					u8 type, u8 version, void *tvlv_value,
+					u16 tvlv_value_len)
+{
+	if (!tvlv)
+		return false;
+
+	if (tvlv->tvlv_hdr.type != type)
+		return false;
+
+	if (tvlv->tvlv_hdr.version != version)
+		return false;
+
+	if (ntohs(tvlv->tvlv_hdr.len) != tvlv_value_len)
+		return false;
+
+	return memcmp(tvlv + 1, tvlv_value, tvlv_value_len) == 0;
+}
+
+/**
+ * batadv_tvlv_container_blob_update() - serialize the tvlv container list into
+ *  the blob appended to each OGM
+ * @bat_priv: the bat priv with all the soft interface information
+ *
+ * If the new blob cannot be allocated, the old one is kept and the update is
+ * retried when the next OGM is built.
+ *
+ * Has to be called with the appropriate locks being acquired
+ * (tvlv.container_list_lock).
+ */
+static void batadv_tvlv_container_blob_update(struct batadv_priv *bat_priv)
+{
+	struct batadv_tvlv_blob *blob_old, *blob_new = NULL;
+	struct batadv_tvlv_container *tvlv;
+	struct batadv_tvlv_hdr *tvlv_hdr;
+	u16 tvlv_value_len;
+	void *tvlv_value;
+
+	lockdep_assert_held(&bat_priv->tvlv.container_list_lock);
+
+	tvlv_value_len = batadv_tvlv_container_list_size(bat_priv);
+	if (!tvlv_value_len)
+		goto publish;
+
+	blob_new = kmalloc(sizeof(*blob_new) + tvlv_value_len, GFP_ATOMIC);
+	if (!blob_new) {
+		WRITE_ONCE(bat_priv->tvlv.container_blob_stale, true);
+		return;
+	}
+
+	blob_new->len = tvlv_value_len;
+	tvlv_value = blob_new->data;
+
+	hlist_for_each_entry(tvlv, &bat_priv->tvlv.container_list, list) {
+		tvlv_hdr = tvlv_value;
+		tvlv_hdr->type = tvlv->tvlv_hdr.type;
+		tvlv_hdr->version = tvlv->tvlv_hdr.version;
+		tvlv_hdr->len = tvlv->tvlv_hdr.len;
+		tvlv_value = tvlv_hdr + 1;
+		memcpy(tvlv_value, tvlv + 1, ntohs(tvlv->tvlv_hdr.len));
+		tvlv_value = (u8 *)tvlv_value + ntohs(tvlv->tvlv_hdr.len);
+	}
+
+publish:
+	blob_old = rcu_dereference_protected(bat_priv->tvlv.container_blob,
+			lockdep_is_held(&bat_priv->tvlv.container_list_lock));
+	rcu_assign_pointer(bat_priv->tvlv.container_blob, blob_new);
+	WRITE_ONCE(bat_priv->tvlv.container_blob_stale, false);
+
+	if (blob_old)
+		kfree_rcu(blob_old, rcu);
+}
+
 /**
  * batadv_tvlv_container_unregister() - unregister tvlv container based on the
  *  provided type and version (both need to match)
@@ -218,8 +320,16 @@ void batadv_tvlv_container_unregister(struct batadv_priv *bat_priv,
 
 	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
 	tvlv = batadv_tvlv_container_get(bat_priv, type, version);
+	if (!tvlv) {
+		spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+		return;
+	}
+
 	batadv_tvlv_container_remove(bat_priv, tvlv);
+	batadv_tvlv_container_blob_update(bat_priv);
 	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+
+	batadv_topology_changed(bat_priv);
 }
 
 /**
@@ -232,7 +342,8 @@ void batadv_tvlv_container_unregister(struct batadv_priv *bat_priv,
  * @tvlv_value_len: tvlv container content length
  *
  * If a container of the same type and version was already registered the new
- * content is going to replace the old one.
+ * content is going to replace the old one. Registering unchanged content (e.g.
+ * the TT container for each OGM) does not touch the container list.
  */
 void batadv_tvlv_container_register(struct batadv_priv *bat_priv,
 				    u8 type, u8 version,
@@ -243,9 +354,22 @@ void batadv_tvlv_container_register(struct batadv_priv *bat_priv,
 	if (!tvlv_value)
 		tvlv_value_len = 0;
 
+	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
+	tvlv_old = batadv_tvlv_container_get(bat_priv, type, version);
+	if (batadv_tvlv_container_equal(tvlv_old, type, version, tvlv_value,
+					tvlv_value_len)) {
+		batadv_tvlv_container_put(tvlv_old);
+		spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+		return;
+	}
+
 	tvlv_new = kzalloc(sizeof(*tvlv_new) + tvlv_value_len, GFP_ATOMIC);
-	if (!tvlv_new)
+	if (!tvlv_new) {
+		if (tvlv_old)
+			batadv_tvlv_container_put(tvlv_old);
+		spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
 		return;
+	}
 
 	tvlv_new->tvlv_hdr.version = version;
 	tvlv_new->tvlv_hdr.type = type;
@@ -255,14 +379,16 @@ void batadv_tvlv_container_register(struct batadv_priv *bat_priv,
 	INIT_HLIST_NODE(&tvlv_new->list);
 	kref_init(&tvlv_new->refcount);
 
-	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
-	tvlv_old = batadv_tvlv_container_get(bat_priv, type, version);
 	batadv_tvlv_container_remove(bat_priv, tvlv_old);
 
 	kref_get(&tvlv_new->refcount);
 	hlist_add_head(&tvlv_new->list, &bat_priv->tvlv.container_list);
+	batadv_tvlv_container_blob_update(bat_priv);
 	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
 
+	/* changed OGM content has to be propagated quickly */
+	batadv_topology_changed(bat_priv);
+
 	/* don't return reference to new tvlv_container */
 	batadv_tvlv_container_put(tvlv_new);
 }
@@ -318,38 +444,38 @@ u16 batadv_tvlv_container_ogm_append(struct batadv_priv *bat_priv,
 				     unsigned char **packet_buff,
 				     int *packet_buff_len, int packet_min_len)
 {
-	struct batadv_tvlv_container *tvlv;
-	struct batadv_tvlv_hdr *tvlv_hdr;
-	u16 tvlv_value_len;
-	void *tvlv_value;
+	struct batadv_tvlv_blob *blob;
+	u16 tvlv_value_len = 0;
 	bool ret;
 
-	spin_lock_bh(&bat_priv->tvlv.container_list_lock);
-	tvlv_value_len = batadv_tvlv_container_list_size(bat_priv);
-
-	ret = batadv_tvlv_realloc_packet_buff(packet_buff, packet_buff_len,
-					      packet_min_len, tvlv_value_len);
+	if (READ_ONCE(bat_priv->tvlv.container_blob_stale)) {
+		spin_lock_bh(&bat_priv->tvlv.container_list_lock);
+		if (bat_priv->tvlv.container_blob_stale)
+			batadv_tvlv_container_blob_update(bat_priv);
+		spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+	}
 
-	if (!ret)
-		goto end;
+	rcu_read_lock();
+	blob = rcu_dereference(bat_priv->tvlv.container_blob);
+	if (blob)
+		tvlv_value_len = blob->len;
+
+	if (*packet_buff_len != packet_min_len + tvlv_value_len) {
+		ret = batadv_tvlv_realloc_packet_buff(packet_buff,
+						      packet_buff_len,
+						      packet_min_len,
+						      tvlv_value_len);
+		if (!ret)
+			goto end;
+	}
 
 	if (!tvlv_value_len)
 		goto end;
 
-	tvlv_value = (*packet_buff) + packet_min_len;
-
-	hlist_for_each_entry(tvlv, &bat_priv->tvlv.container_list, list) {
-		tvlv_hdr = tvlv_value;
-		tvlv_hdr->type = tvlv->tvlv_hdr.type;
-		tvlv_hdr->version = tvlv->tvlv_hdr.version;
-		tvlv_hdr->len = tvlv->tvlv_hdr.len;
-		tvlv_value = tvlv_hdr + 1;
-		memcpy(tvlv_value, tvlv + 1, ntohs(tvlv->tvlv_hdr.len));
-		tvlv_value = (u8 *)tvlv_value + ntohs(tvlv->tvlv_hdr.len);
-	}
+	memcpy(*packet_buff + packet_min_len, blob->data, tvlv_value_len);
 
 end:
-	spin_unlock_bh(&bat_priv->tvlv.container_list_lock);
+	rcu_read_unlock();
 	return tvlv_value_len;
 }
 
@@ -433,6 +559,7 @@ int batadv_tvlv_containers_process(struct batadv_priv *bat_priv,
 	u8 cifnotfound = BATADV_TVLV_HANDLER_OGM_CIFNOTFND;
 	int ret = NET_RX_SUCCESS;
 
+	rcu_read_lock();
 	while (tvlv_value_len >= sizeof(*tvlv_hdr)) {
 		tvlv_hdr = tvlv_value;
 		tvlv_value_cont_len = ntohs(tvlv_hdr->len);
@@ -442,24 +569,23 @@ int batadv_tvlv_containers_process(struct batadv_priv *bat_priv,
 		if (tvlv_value_cont_len > tvlv_value_len)
 			break;
 
-		tvlv_handler = batadv_tvlv_handler_get(bat_priv,
-						       tvlv_hdr->type,
-						       tvlv_hdr->version);
+		tvlv_handler = batadv_tvlv_handler_lookup(bat_priv,
+							  tvlv_hdr->type,
+							  tvlv_hdr->version);
 
 		ret |= batadv_tvlv_call_handler(bat_priv, tvlv_handler,
 						ogm_source, orig_node,
 						src, dst, tvlv_value,
 						tvlv_value_cont_len);
-		if (tvlv_handler)
-			batadv_tvlv_handler_put(tvlv_handler);
 		tvlv_value = (u8 *)tvlv_value + tvlv_value_cont_len;
 		tvlv_value_len -= tvlv_value_cont_len;
 	}
 
-	if (!ogm_source)
+	if (!ogm_source) {
+		rcu_read_unlock();
 		return ret;
+	}
 
-	rcu_read_lock();
 	hlist_for_each_entry_rcu(tvlv_handler,
 				 &bat_priv->tvlv.handler_list, list) {
 		if ((tvlv_handler->flags & BATADV_TVLV_HANDLER_OGM_CIFNOTFND) &&
@@ -551,9 +677,12 @@ void batadv_tvlv_handler_register(struct batadv_priv *bat_priv,
 	tvlv_handler->flags = flags;
 	kref_init(&tvlv_handler->refcount);
 	INIT_HLIST_NODE(&tvlv_handler->list);
+	INIT_HLIST_NODE(&tvlv_handler->table_node);
 
 	kref_get(&tvlv_handler->refcount);
 	hlist_add_head_rcu(&tvlv_handler->list, &bat_priv->tvlv.handler_list);
+	hlist_add_head_rcu(&tvlv_handler->table_node,
+			   &bat_priv->tvlv.handler_table[type]);
 	spin_unlock_bh(&bat_priv->tvlv.handler_list_lock);
 
 	/* don't return reference to new tvlv_handler */
@@ -579,6 +708,7 @@ void batadv_tvlv_handler_unregister(struct batadv_priv *bat_priv,
 	batadv_tvlv_handler_put(tvlv_handler);
 	spin_lock_bh(&bat_priv->tvlv.handler_list_lock);
 	hlist_del_rcu(&tvlv_handler->list);
+	hlist_del_rcu(&tvlv_handler->table_node);
 	spin_unlock_bh(&bat_priv->tvlv.handler_list_lock);
 	batadv_tvlv_handler_put(tvlv_handler);
 }
@@ -28,6 +28,7 @@
 #include <linux/compiler.h>
 #include <linux/if_ether.h>
 #include <linux/kref.h>
+#include <linux/ktime.h>
 #include <linux/netdevice.h>
 #include <linux/netlink.h>
 #include <linux/sched.h> /* for linux/wait.h */
@@ -79,6 +80,20 @@ enum batadv_dhcp_recipient {
  */
 #define BATADV_TT_SYNC_MASK	0x00F0
 
+/**
+ * struct batadv_interval_backoff - backoff state of a periodic routing protocol
+ *  message
+ */
+struct batadv_interval_backoff {
+	/**
+	 * @topology_gen: &batadv_priv.topology_gen at the previous transmission
+	 */
+	int topology_gen;
+
+	/** @level: number of doublings of the configured interval */
+	unsigned int level;
+};
+
 /**
  * struct batadv_hard_iface_bat_iv - per hard-interface B.A.T.M.A.N. IV data
  */
@@ -91,24 +106,37 @@ struct batadv_hard_iface_bat_iv {
 
 	/** @ogm_seqno: OGM sequence number - used to identify each OGM */
 	atomic_t ogm_seqno;
+
+	/**
+	 * @aggr_slots: pending OGM aggregates leaving this interface, indexed
+	 *  by their send time (protected by &batadv_priv.forw_bat_list_lock)
+	 */
+	struct hlist_head aggr_slots[BATADV_IV_AGGR_SLOTS];
+
+	/** @ogm_backoff: backoff state of the own OGM interval */
+	struct batadv_interval_backoff ogm_backoff;
 };
 
 /**
  * enum batadv_v_hard_iface_flags - interface flags useful to B.A.T.M.A.N. V
+ *
+ * The flags are bit numbers in &batadv_hard_iface_bat_v.flags. They are
+ * changed from the ELP work and from netdev notifications, therefore only
+ * through atomic bit operations.
  */
 enum batadv_v_hard_iface_flags {
 	/**
 	 * @BATADV_FULL_DUPLEX: tells if the connection over this link is
 	 *  full-duplex
 	 */
-	BATADV_FULL_DUPLEX	= BIT(0),
+	BATADV_FULL_DUPLEX,
 
 	/**
 	 * @BATADV_WARNING_DEFAULT: tells whether we have warned the user that
 	 *  no throughput data is available for this interface and that default
 	 *  values are assumed.
 	 */
-	BATADV_WARNING_DEFAULT	= BIT(1),
+	BATADV_WARNING_DEFAULT,
 };
 
 /**
@@ -127,14 +155,35 @@ struct batadv_hard_iface_bat_v {
 	/** @elp_wq: workqueue used to schedule ELP transmissions */
 	struct delayed_work elp_wq;
 
+	/** @elp_backoff: backoff state of the ELP interval */
+	struct batadv_interval_backoff elp_backoff;
+
 	/**
 	 * @throughput_override: throughput override to disable link
 	 *  auto-detection
 	 */
 	atomic_t throughput_override;
 
-	/** @flags: interface specific flags */
-	u8 flags;
+	/**
+	 * @link_throughput: link throughput reported by ethtool on the last
+	 *  link change or 0 if not available
+	 */
+	atomic_t link_throughput;
+
+	/** @flags: interface specific flags (enum batadv_v_hard_iface_flags) */
+	unsigned long flags;
+
+	/** @aggr_wq: workqueue used to transmit the OGM2 aggregate */
+	struct delayed_work aggr_wq;
+
+	/** @aggr_list: queue of OGM2 packets waiting to be aggregated */
+	struct sk_buff_head aggr_list;
+
+	/** @aggr_len: size of the OGM2 aggregate (excluding ethernet header) */
+	unsigned int aggr_len;
+
+	/** @aggr_list_lock: protects aggr_list and aggr_len */
+	spinlock_t aggr_list_lock;
 };
 
 /**
@@ -440,6 +489,16 @@ struct batadv_orig_node {
 	/** @tt_buff_lock: lock that protects tt_buff and tt_buff_len */
 	spinlock_t tt_buff_lock;
 
+	/**
+	 * @tt_part_offset: number of entries already received of a full table
+	 *  split into several TT responses (BATADV_TT_PART_NONE when no such
+	 *  transfer is ongoing)
+	 */
+	u32 tt_part_offset;
+
+	/** @tt_part_ttvn: ttvn of the full table received in several parts */
+	u8 tt_part_ttvn;
+
 	/**
 	 * @tt_lock: prevents from updating the table while reading it. Table
 	 *  update is made up by two operations (data structure update and
@@ -558,6 +617,12 @@ struct batadv_gw_node {
 	/** @bandwidth_up: advertised uplink upload bandwidth */
 	u32 bandwidth_up;
 
+	/**
+	 * @lb_weight: load balancing weight the DHCP clients are distributed
+	 *  with, follows the weight of the routing algorithm with hysteresis
+	 */
+	u32 lb_weight;
+
 	/** @refcount: number of contexts the object is used */
 	struct kref refcount;
 
@@ -587,8 +652,44 @@ struct batadv_hardif_neigh_node_bat_v {
 	 */
 	unsigned long last_unicast_tx;
 
-	/** @metric_work: work queue callback item for metric update */
-	struct work_struct metric_work;
+	/**
+	 * @metric_list: list node for the batch of neighbors whose metric gets
+	 *  updated by the ELP periodic work
+	 */
+	struct hlist_node metric_list;
+
+	/**
+	 * @est_needed: neither cfg80211 nor ethtool provide the throughput
+	 *  towards this neighbor and it has to be estimated
+	 */
+	bool est_needed;
+
+	/**
+	 * @est_throughput: ewma of the estimated link throughput, sampled from
+	 *  ELP probe trains and from unicast traffic sent to this neighbor
+	 */
+	struct ewma_throughput est_throughput;
+
+	/** @est_samples: number of samples added to est_throughput */
+	atomic_t est_samples;
+
+	/**
+	 * @peer_est_needed: the neighbour estimates the throughput towards
+	 *  this node and requested a probe train in return
+	 */
+	bool peer_est_needed;
+
+	/** @probe_seqno: sequence number of the last received ELP probe */
+	u32 probe_seqno;
+
+	/** @probe_last: arrival time of the last received ELP probe */
+	ktime_t probe_last;
+
+	/** @tx_bytes: unicast bytes sent to this neighbor since tx_start */
+	atomic_t tx_bytes;
+
+	/** @tx_start: start of the tx_bytes measurement period (jiffies) */
+	unsigned long tx_start;
 };
 
 /**
@@ -798,6 +899,25 @@ enum batadv_counters {
 	 */
 	BATADV_CNT_MGMT_RX_BYTES,
 
+	/**
+	 * @BATADV_CNT_MGMT_TX_SAVED: periodic routing protocol packets not
+	 *  transmitted due to backed off intervals
+	 */
+	BATADV_CNT_MGMT_TX_SAVED,
+
+#ifdef CONFIG_BATMAN_ADV_BATMAN_V
+	/**
+	 * @BATADV_CNT_OGM2_AGGR_TX: transmitted OGM2 aggregate packet counter
+	 */
+	BATADV_CNT_OGM2_AGGR_TX,
+
+	/**
+	 * @BATADV_CNT_OGM2_AGGR_TX_OGMS: counter for OGM2 packets transmitted
+	 *  as part of an aggregate
+	 */
+	BATADV_CNT_OGM2_AGGR_TX_OGMS,
+#endif
+
 	/** @BATADV_CNT_FRAG_TX: transmitted fragment traffic packet counter */
 	BATADV_CNT_FRAG_TX,
 
@@ -852,6 +972,48 @@ enum batadv_counters {
 	 */
 	BATADV_CNT_TT_ROAM_ADV_RX,
 
+	/**
+	 * @BATADV_CNT_TT_COMPRESS_SAVED: bytes saved by sending compressed tt
+	 *  responses
+	 */
+	BATADV_CNT_TT_COMPRESS_SAVED,
+
+	/**
+	 * @BATADV_CNT_TT_SEARCH_MISS: global table searches for unknown
+	 *  clients
+	 */
+	BATADV_CNT_TT_SEARCH_MISS,
+
+	/**
+	 * @BATADV_CNT_TT_SEARCH_MISS_CACHED: searches for unknown clients
+	 *  answered by the miss cache
+	 */
+	BATADV_CNT_TT_SEARCH_MISS_CACHED,
+
+	/**
+	 * @BATADV_CNT_GW_CLASS_DHCP: broadcasts classified as DHCP in gateway
+	 *  mode
+	 */
+	BATADV_CNT_GW_CLASS_DHCP,
+
+	/**
+	 * @BATADV_CNT_GW_CLASS_ARP: broadcasts classified as ARP in gateway
+	 *  mode
+	 */
+	BATADV_CNT_GW_CLASS_ARP,
+
+	/**
+	 * @BATADV_CNT_GW_CLASS_UDP: broadcasts classified as non-DHCP UDP in
+	 *  gateway mode
+	 */
+	BATADV_CNT_GW_CLASS_UDP,
+
+	/**
+	 * @BATADV_CNT_GW_CLASS_OTHER: other broadcasts classified in gateway
+	 *  mode
+	 */
+	BATADV_CNT_GW_CLASS_OTHER,
+
 #ifdef CONFIG_BATMAN_ADV_DAT
 	/**
 	 * @BATADV_CNT_DAT_GET_TX: transmitted dht GET traffic packet counter
@@ -928,12 +1090,58 @@ enum batadv_counters {
 	 *  promisc mode.
 	 */
 	BATADV_CNT_NC_SNIFFED,
+
+	/**
+	 * @BATADV_CNT_NC_BUFFER_EVICT: counter for packets evicted from the nc
+	 *  decoding buffer before their buffer time expired
+	 */
+	BATADV_CNT_NC_BUFFER_EVICT,
+#endif
+
+#ifdef CONFIG_BATMAN_ADV_MCAST
+	/**
+	 * @BATADV_CNT_MCAST_FANOUT_TX: transmitted multicast packets which were
+	 *  sent as unicasts to their listeners instead of being flooded
+	 */
+	BATADV_CNT_MCAST_FANOUT_TX,
+
+	/**
+	 * @BATADV_CNT_MCAST_FANOUT_UNICAST_TX: unicast copies transmitted for
+	 *  multicast packets
+	 */
+	BATADV_CNT_MCAST_FANOUT_UNICAST_TX,
 #endif
 
 	/** @BATADV_CNT_NUM: number of traffic counters */
 	BATADV_CNT_NUM,
 };
 
+/**
+ * struct batadv_tt_miss_cache_entry - client recently missed in the global
+ *  table
+ */
+struct batadv_tt_miss_cache_entry {
+	/** @addr: mac address of the client */
+	u8 addr[ETH_ALEN];
+
+	/** @vid: VLAN identifier of the client */
+	unsigned short vid;
+
+	/**
+	 * @gen: value of &batadv_priv_tt.global_gen when the client was not
+	 *  found in the global table
+	 */
+	unsigned int gen;
+};
+
+/**
+ * struct batadv_tt_miss_cache - per cpu cache of global table misses
+ */
+struct batadv_tt_miss_cache {
+	/** @entries: direct mapped cache slots */
+	struct batadv_tt_miss_cache_entry entries[BATADV_TT_MISS_CACHE_SIZE];
+};
+
 /**
  * struct batadv_priv_tt - per mesh interface translation table data
  */
@@ -964,6 +1172,11 @@ struct batadv_priv_tt {
 	/** @req_list: list of pending & unanswered tt_requests */
 	struct hlist_head req_list;
 
+	/**
+	 * @part_tx_list: list of full tables being sent in several parts
+	 */
+	struct hlist_head part_tx_list;
+
 	/**
 	 * @roam_list: list of the last roaming events of each client limiting
 	 *  the number of roaming events to avoid route flapping
@@ -979,6 +1192,9 @@ struct batadv_priv_tt {
 	/** @roam_list_lock: lock protecting roam_list */
 	spinlock_t roam_list_lock;
 
+	/** @part_tx_lock: lock protecting part_tx_list and its transfers */
+	spinlock_t part_tx_lock;
+
 	/** @last_changeset: last tt changeset this host has generated */
 	unsigned char *last_changeset;
 
@@ -1005,10 +1221,41 @@ struct batadv_priv_tt {
 
 	/** @work: work queue callback item for translation table purging */
 	struct delayed_work work;
+
+	/** @miss_cache: per cpu cache of clients missing in the global table */
+	struct batadv_tt_miss_cache __percpu *miss_cache;
+
+	/**
+	 * @global_gen: generation of the global table, increased whenever a
+	 *  client is added to it
+	 */
+	atomic_t global_gen;
 };
 
 #ifdef CONFIG_BATMAN_ADV_BLA
 
+/**
+ * struct batadv_bla_claim_cache_entry - recently used claim of a cpu
+ */
+struct batadv_bla_claim_cache_entry {
+	/** @claim: pointer to the cached claim (no reference is held) */
+	struct batadv_bla_claim *claim;
+
+	/**
+	 * @gen: value of &batadv_priv_bla.claim_gen when @claim was found in
+	 *  the claim hash
+	 */
+	unsigned int gen;
+};
+
+/**
+ * struct batadv_bla_claim_cache - per cpu cache of recently used claims
+ */
+struct batadv_bla_claim_cache {
+	/** @entries: direct mapped cache slots */
+	struct batadv_bla_claim_cache_entry entries[BATADV_BLA_CLAIM_CACHE_SIZE];
+};
+
 /**
  * struct batadv_priv_bla - per mesh interface bridge loope avoidance data
  */
@@ -1021,6 +1268,18 @@ struct batadv_priv_bla {
 	 */
 	struct batadv_hashtable *claim_hash;
 
+	/**
+	 * @claim_cache: per cpu cache of claims recently looked up by the
+	 *  packet path
+	 */
+	struct batadv_bla_claim_cache __percpu *claim_cache;
+
+	/**
+	 * @claim_gen: generation counter increased whenever a claim is removed
+	 *  from the claim hash - invalidates all entries of @claim_cache
+	 */
+	atomic_t claim_gen;
+
 	/**
 	 * @backbone_hash: hash table containing all detected backbone gateways
 	 */
@@ -1138,11 +1397,29 @@ struct batadv_priv_tvlv {
 	/** @handler_list: list of the various tvlv content handlers */
 	struct hlist_head handler_list;
 
+	/**
+	 * @handler_table: the tvlv content handlers of handler_list indexed by
+	 *  their tvlv type
+	 */
+	struct hlist_head handler_table[BATADV_TVLV_TYPE_NUM];
+
 	/** @container_list_lock: protects tvlv container list access */
 	spinlock_t container_list_lock;
 
 	/** @handler_list_lock: protects handler list access */
 	spinlock_t handler_list_lock;
+
+	/**
+	 * @container_blob: serialized container_list appended to each OGM,
+	 *  rebuilt whenever a container is (un)registered
+	 */
+	struct batadv_tvlv_blob __rcu *container_blob;
+
+	/**
+	 * @container_blob_stale: container_blob could not be rebuilt after the
+	 *  last container_list change
+	 */
+	bool container_blob_stale;
 };
 
 #ifdef CONFIG_BATMAN_ADV_DAT
@@ -1187,6 +1464,12 @@ struct batadv_priv_mcast {
 	 */
 	struct hlist_head mla_list; /* see __batadv_mcast_mla_update() */
 
+	/**
+	 * @mla_round: number of the current listener scan, see
+	 *  batadv_mcast_mla_collect()
+	 */
+	unsigned int mla_round;
+
 	/**
 	 * @want_all_unsnoopables_list: a list of orig_nodes wanting all
 	 *  unsnoopable multicast traffic
@@ -1238,6 +1521,12 @@ struct batadv_priv_mcast {
 	 */
 	spinlock_t want_lists_lock;
 
+	/**
+	 * @mla_lock: a lock protecting mla_list, mla_round and the flags and
+	 *  querier state of the own multicast tvlv
+	 */
+	spinlock_t mla_lock;
+
 	/** @work: work queue callback item for multicast TT and TVLV updates */
 	struct delayed_work work;
 };
@@ -1247,7 +1536,7 @@ struct batadv_priv_mcast {
  * struct batadv_priv_nc - per mesh interface network coding private data
  */
 struct batadv_priv_nc {
-	/** @work: work queue callback item for cleanup */
+	/** @work: work queue callback item for nc node and nc path cleanup */
 	struct delayed_work work;
 
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
@@ -1258,7 +1547,9 @@ struct batadv_priv_nc {
 #endif
 
 	/**
-	 * @min_tq: only consider neighbors for encoding if neigh_tq > min_tq
+	 * @min_tq: only consider neighbors for encoding if the link quality
+	 *  reported by the routing algorithm (scaled to BATADV_TQ_MAX_VALUE)
+	 *  is at least min_tq
 	 */
 	u8 min_tq;
 
@@ -1274,15 +1565,28 @@ struct batadv_priv_nc {
 	u32 max_buffer_time;
 
 	/**
-	 * @timestamp_fwd_flush: timestamp of last forward packet queue flush
+	 * @max_buffer_bytes: maximum number of bytes held by all packets
+	 *  buffered for decoding
+	 */
+	u32 max_buffer_bytes;
+
+	/**
+	 * @max_path_bytes: maximum number of bytes held by the packets
+	 *  buffered for decoding on a single nc path
 	 */
-	unsigned long timestamp_fwd_flush;
+	u32 max_path_bytes;
+
+	/** @decoding_bytes: number of bytes held by the decoding buffer */
+	atomic_t decoding_bytes;
 
 	/**
-	 * @timestamp_sniffed_purge: timestamp of last sniffed packet queue
-	 *  purge
+	 * @decoding_lru: all packets buffered for decoding, least recently
+	 *  added first
 	 */
-	unsigned long timestamp_sniffed_purge;
+	struct list_head decoding_lru;
+
+	/** @decoding_lru_lock: lock protecting decoding_lru */
+	spinlock_t decoding_lru_lock;
 
 	/**
 	 * @coding_hash: Hash table used to buffer skbs while waiting for
@@ -1330,7 +1634,174 @@ enum batadv_tp_meter_role {
 };
 
 /**
- * struct batadv_tp_vars - tp meter private variables per session
+ * struct batadv_tp_cubic - state of the CUBIC congestion control
+ */
+struct batadv_tp_cubic {
+	/** @last_w_max: congestion window before the last loss */
+	u32 last_w_max;
+
+	/** @origin: congestion window the cubic function plateaus at */
+	u32 origin;
+
+	/** @k: time (in ms) to reach @origin again after a loss */
+	u32 k;
+
+	/** @epoch_start: start of the current growth epoch (jiffies) */
+	unsigned long epoch_start;
+
+	/** @epoch_started: whether @epoch_start is valid */
+	bool epoch_started;
+};
+
+/**
+ * struct batadv_tp_rate - state of the rate based congestion control
+ */
+struct batadv_tp_rate {
+	/** @btl_bw: estimated bottleneck bandwidth (in bytes per second) */
+	u64 btl_bw;
+
+	/** @pacing_rate: current pacing rate (in bytes per second) */
+	u64 pacing_rate;
+
+	/** @full_bw: bandwidth at the last significant growth in startup */
+	u64 full_bw;
+
+	/** @delivered: bytes acked in the current round */
+	u64 delivered;
+
+	/** @round_start: start of the current round (jiffies) */
+	unsigned long round_start;
+
+	/** @min_rtt: smallest RTT seen (in ms) */
+	u32 min_rtt;
+
+	/** @min_rtt_stamp: time @min_rtt was measured (jiffies) */
+	unsigned long min_rtt_stamp;
+
+	/** @full_bw_cnt: rounds without significant bandwidth growth */
+	u8 full_bw_cnt;
+
+	/** @startup: whether the bottleneck bandwidth is still searched */
+	bool startup;
+
+	/** @cycle_idx: current phase of the bandwidth probing gain cycle */
+	u8 cycle_idx;
+};
+
+/**
+ * struct batadv_tp_lat_result - summary of the latency probes of a tp meter
+ *  session
+ */
+struct batadv_tp_lat_result {
+	/** @sent: number of sent probes */
+	u32 sent;
+
+	/** @lost: number of probes which were not echoed back */
+	u32 lost;
+
+	/** @min: smallest RTT (in microseconds) */
+	u32 min;
+
+	/** @avg: average RTT (in microseconds) */
+	u32 avg;
+
+	/** @p50: median RTT (in microseconds) */
+	u32 p50;
+
+	/** @p99: 99th percentile of the RTT (in microseconds) */
+	u32 p99;
+
+	/** @max: largest RTT (in microseconds) */
+	u32 max;
+
+	/** @jitter: RTT variation as defined in RFC3550 (in microseconds) */
+	u32 jitter;
+};
+
+/**
+ * struct batadv_tp_latency - latency probe state of a tp meter stream
+ */
+struct batadv_tp_latency {
+	/** @interval: time between two probes (in milliseconds) */
+	u32 interval;
+
+	/** @lock: lock protecting the statistics below */
+	spinlock_t lock;
+
+	/** @sent: number of sent probes */
+	u32 sent;
+
+	/** @received: number of echoed probes */
+	u32 received;
+
+	/** @min: smallest RTT (in microseconds) */
+	u32 min;
+
+	/** @max: largest RTT (in microseconds) */
+	u32 max;
+
+	/** @sum: sum of all RTTs (in microseconds) */
+	u64 sum;
+
+	/** @last: previously measured RTT (in microseconds) */
+	u32 last;
+
+	/** @jitter: RTT variation (in microseconds) scaled by 2^4 */
+	u32 jitter;
+
+	/** @hist: histogram of the measured RTTs */
+	u32 hist[BATADV_TP_LAT_BUCKETS];
+
+	/** @last_seqno: highest sequence number of the echoed probes */
+	u32 last_seqno;
+
+	/** @seqno_bits: window of the recently echoed sequence numbers */
+	DECLARE_BITMAP(seqno_bits, BATADV_TQ_LOCAL_WINDOW_SIZE);
+};
+
+/**
+ * struct batadv_tp_group - tp meter session consisting of parallel streams
+ */
+struct batadv_tp_group {
+	/** @other_end: mac address of remote */
+	u8 other_end[ETH_ALEN];
+
+	/** @cookie: session cookie reported to the user */
+	u32 cookie;
+
+	/** @start_time: start time in jiffies */
+	unsigned long start_time;
+
+	/** @num_streams: number of started throughput streams */
+	u8 num_streams;
+
+	/**
+	 * @active: number of streams (including the probe stream) which did
+	 *  not finish yet
+	 */
+	atomic_t active;
+
+	/** @lock: lock protecting @tot_sent, @reason & @latency */
+	spinlock_t lock;
+
+	/** @tot_sent: amount of data ACKed over all finished streams */
+	u64 tot_sent;
+
+	/**
+	 * @reason: reason for the stopped session, an error is only reported
+	 *  if no stream finished successfully
+	 */
+	enum batadv_tp_meter_reason reason;
+
+	/** @probing: whether the session measures the latency */
+	bool probing;
+
+	/** @latency: result of the latency probes */
+	struct batadv_tp_lat_result latency;
+};
+
+/**
+ * struct batadv_tp_vars - tp meter private variables per session stream
  */
 struct batadv_tp_vars {
 	/** @list: list node for &bat_priv.tp_list */
@@ -1371,6 +1842,18 @@ struct batadv_tp_vars {
 
 	/* sender variables */
 
+	/** @group: the session this stream is part of */
+	struct batadv_tp_group *group;
+
+	/** @stream: index (starting at 1) of this stream in @group */
+	u8 stream;
+
+	/**
+	 * @latency: latency probe state, only set for the probe stream of a
+	 *  session
+	 */
+	struct batadv_tp_latency *latency;
+
 	/** @dec_cwnd: decimal part of the cwnd used during linear growth */
 	u16 dec_cwnd;
 
@@ -1380,6 +1863,21 @@ struct batadv_tp_vars {
 	/** @cwnd_lock: lock do protect @cwnd & @dec_cwnd */
 	spinlock_t cwnd_lock;
 
+	/** @cc_ops: congestion control algorithm of the stream */
+	const struct batadv_tp_cc_ops *cc_ops;
+
+	/** @cc: state of the congestion control algorithm */
+	union {
+		/** @cc.cubic: state of BATADV_TP_CC_CUBIC */
+		struct batadv_tp_cubic cubic;
+
+		/** @cc.rate: state of BATADV_TP_CC_RATE */
+		struct batadv_tp_rate rate;
+	} cc;
+
+	/** @pacing_next: earliest time (ns) the next packet may be sent */
+	u64 pacing_next;
+
 	/**
 	 * @ss_threshold: Slow Start threshold. Once cwnd exceeds this value the
 	 *  connection switches to the Congestion Avoidance state
@@ -1446,6 +1944,41 @@ struct batadv_tp_vars {
 	struct rcu_head rcu;
 };
 
+/**
+ * struct batadv_tp_cc_ops - congestion control algorithm of the tp meter
+ *
+ * All callbacks are called with &batadv_tp_vars.cwnd_lock being held.
+ */
+struct batadv_tp_cc_ops {
+	/** @name: name of the algorithm */
+	const char *name;
+
+	/** @init: initialize the algorithm state of a stream (optional) */
+	void (*init)(struct batadv_tp_vars *tp_vars);
+
+	/**
+	 * @cong_avoid: grow the congestion window after new data of at least
+	 *  one MSS was acked outside of Fast Recovery
+	 */
+	void (*cong_avoid)(struct batadv_tp_vars *tp_vars, u32 mss);
+
+	/** @ssthresh: compute the slow start threshold after a loss */
+	u32 (*ssthresh)(struct batadv_tp_vars *tp_vars);
+
+	/**
+	 * @pkts_acked: account newly acked data and the RTT sample (in ms, 0
+	 *  if none) of the ACK (optional)
+	 */
+	void (*pkts_acked)(struct batadv_tp_vars *tp_vars, u32 acked, u32 rtt);
+
+	/**
+	 * @pacing_rate: get the rate (in bytes per second) the packets have to
+	 *  be paced at, 0 to send at the speed of the congestion window
+	 *  (optional)
+	 */
+	u64 (*pacing_rate)(struct batadv_tp_vars *tp_vars);
+};
+
 /**
  * struct batadv_softif_vlan - per VLAN attributes set
  */
@@ -1492,6 +2025,9 @@ struct batadv_priv_bat_v {
 
 	/** @ogm_wq: workqueue used to schedule OGM transmissions */
 	struct delayed_work ogm_wq;
+
+	/** @ogm_backoff: backoff state of the OGM interval */
+	struct batadv_interval_backoff ogm_backoff;
 };
 
 /**
@@ -1521,6 +2057,12 @@ struct batadv_priv {
 	/** @bonding: bool indicating whether traffic bonding is enabled */
 	atomic_t bonding;
 
+	/**
+	 * @gw_load_balancing: bool indicating whether DHCP clients are
+	 *  distributed over all gateways instead of the selected one
+	 */
+	atomic_t gw_load_balancing;
+
 	/**
 	 * @fragmentation: bool indicating whether traffic fragmentation is
 	 *  enabled
@@ -1562,11 +2104,28 @@ struct batadv_priv {
 	 *  node's sender/originating side
 	 */
 	atomic_t multicast_mode;
+
+	/**
+	 * @multicast_fanout: maximum number of packet copies to generate for a
+	 *  multicast-to-unicast conversion
+	 */
+	atomic_t multicast_fanout;
 #endif
 
 	/** @orig_interval: OGM broadcast interval in milliseconds */
 	atomic_t orig_interval;
 
+	/**
+	 * @interval_backoff: maximum number of doublings of the ELP and OGM
+	 *  intervals while the topology is stable
+	 */
+	atomic_t interval_backoff;
+
+	/**
+	 * @topology_gen: generation counter incremented on each topology change
+	 */
+	atomic_t topology_gen;
+
 	/**
 	 * @hop_penalty: penalty which will be applied to an OGM's tq-field on
 	 *  every hop
@@ -1915,6 +2474,40 @@ struct batadv_tt_orig_list_entry {
 	struct rcu_head rcu;
 };
 
+/**
+ * struct batadv_tt_bulk_item - full table entry prepared for bulk insertion
+ */
+struct batadv_tt_bulk_item {
+	/** @index: global hash bucket of the entry */
+	u32 index;
+
+	/** @change: the tt change announcing the entry */
+	struct batadv_tvlv_tt_change *change;
+
+	/** @tt_global: preallocated global entry */
+	struct batadv_tt_global_entry *tt_global;
+
+	/** @orig_entry: preallocated orig list entry */
+	struct batadv_tt_orig_list_entry *orig_entry;
+
+	/** @published: whether the entry was added to the global hash */
+	bool published;
+};
+
+/**
+ * struct batadv_tt_bulk - state of a bulk insertion into the global table
+ */
+struct batadv_tt_bulk {
+	/** @tt_global: objects allocated from the global entry cache */
+	void *tt_global[BATADV_TT_BULK_SIZE];
+
+	/** @orig_entry: objects allocated from the orig list entry cache */
+	void *orig_entry[BATADV_TT_BULK_SIZE];
+
+	/** @items: entries of the current batch */
+	struct batadv_tt_bulk_item items[BATADV_TT_BULK_SIZE];
+};
+
 /**
  * struct batadv_tt_change_node - structure for tt changes occurred
  */
@@ -1945,6 +2538,50 @@ struct batadv_tt_req_node {
 	struct hlist_node list;
 };
 
+/**
+ * struct batadv_tt_part_tx - full table being sent in several parts
+ */
+struct batadv_tt_part_tx {
+	/** @list: list node for &batadv_priv_tt.part_tx_list */
+	struct hlist_node list;
+
+	/** @bat_priv: pointer to the mesh object */
+	struct batadv_priv *bat_priv;
+
+	/**
+	 * @orig_node: originator whose global table is sent, NULL for the
+	 *  local table
+	 */
+	struct batadv_orig_node *orig_node;
+
+	/** @src: address of the node whose table is sent */
+	u8 src[ETH_ALEN];
+
+	/** @dst: address of the node which requested the table */
+	u8 dst[ETH_ALEN];
+
+	/** @hdr: tt data and vlan data header of the full table */
+	struct batadv_tvlv_tt_data *hdr;
+
+	/** @hdr_len: length of @hdr */
+	u16 hdr_len;
+
+	/** @compress: whether the requester accepts compressed tt changes */
+	bool compress;
+
+	/** @offset: number of entries already sent */
+	u32 offset;
+
+	/** @finished: whether the last part was sent */
+	bool finished;
+
+	/** @restart: whether a request changed @offset during a window */
+	bool restart;
+
+	/** @work: work item sending the next window of parts */
+	struct delayed_work work;
+};
+
 /**
  * struct batadv_tt_roam_node - roaming client data
  */
@@ -2017,6 +2654,24 @@ struct batadv_nc_path {
 
 	/** @last_valid: timestamp for last validation of path */
 	unsigned long last_valid;
+
+	/**
+	 * @buffer_bytes: number of bytes held by the packets buffered for
+	 *  decoding on this path (protected by packet_list_lock)
+	 */
+	u32 buffer_bytes;
+
+	/** @bat_priv: pointer to soft_iface this path belongs to */
+	struct batadv_priv *bat_priv;
+
+	/**
+	 * @timeout_work: work item releasing the packets of @packet_list once
+	 *  their buffering time has passed
+	 */
+	struct delayed_work timeout_work;
+
+	/** @cleanup_list: list node for purging functions */
+	struct hlist_node cleanup_list;
 };
 
 /**
@@ -2044,6 +2699,15 @@ struct batadv_nc_packet {
 
 	/** @nc_path: pointer to path this nc packet is attached to */
 	struct batadv_nc_path *nc_path;
+
+	/**
+	 * @lru_list: list node for &batadv_priv_nc.decoding_lru, empty for
+	 *  packets buffered for coding
+	 */
+	struct list_head lru_list;
+
+	/** @size: number of bytes accounted in the decoding buffer */
+	unsigned int size;
 };
 
 /**
@@ -2074,6 +2738,12 @@ struct batadv_forw_packet {
 	/** @cleanup_list: list node for purging functions */
 	struct hlist_node cleanup_list;
 
+	/**
+	 * @aggr_list: list node for &batadv_hard_iface_bat_iv.aggr_slots of
+	 *  the outgoing interface (OGMv1 only)
+	 */
+	struct hlist_node aggr_list;
+
 	/** @send_time: execution time for delayed_work (packet sending) */
 	unsigned long send_time;
 
@@ -2138,6 +2808,18 @@ struct batadv_algo_iface_ops {
 
 	/** @primary_set: called when primary interface is selected / changed */
 	void (*primary_set)(struct batadv_hard_iface *hard_iface);
+
+	/**
+	 * @link_update: react to a link state change of the hard-interface
+	 *  (optional)
+	 */
+	void (*link_update)(struct batadv_hard_iface *hard_iface);
+
+	/**
+	 * @backoff_reset: bring the transmissions scheduled with a backed off
+	 *  interval forward after a topology change (optional)
+	 */
+	void (*backoff_reset)(struct batadv_priv *bat_priv);
 };
 
 /**
@@ -2225,6 +2907,13 @@ struct batadv_algo_gw_ops {
 			    struct batadv_orig_node *curr_gw_orig,
 			    struct batadv_orig_node *orig_node);
 
+	/**
+	 * @get_lb_weight: compute the share of DHCP clients a GW should serve
+	 *  when load balancing over all GWs, 0 if the GW is unusable (optional)
+	 */
+	u32 (*get_lb_weight)(struct batadv_priv *bat_priv,
+			     struct batadv_gw_node *gw_node);
+
 #ifdef CONFIG_BATMAN_ADV_DEBUGFS
 	/** @print: print the gateway table (optional) */
 	void (*print)(struct batadv_priv *bat_priv, struct seq_file *seq);
@@ -2296,6 +2985,9 @@ struct batadv_hw_addr {
 
 	/** @addr: the MAC address of this list entry */
 	unsigned char addr[ETH_ALEN];
+
+	/** @seen: number of the multicast listener scan which last found it */
+	unsigned int seen;
 };
 
 /**
@@ -2331,6 +3023,20 @@ struct batadv_tvlv_container {
 	struct kref refcount;
 };
 
+/**
+ * struct batadv_tvlv_blob - serialized tvlv containers appended to OGMs
+ */
+struct batadv_tvlv_blob {
+	/** @rcu: struct used for freeing in an RCU-safe manner */
+	struct rcu_head rcu;
+
+	/** @len: length of the serialized tvlv containers */
+	u16 len;
+
+	/** @data: tvlv headers and values of all registered containers */
+	u8 data[];
+};
+
 /**
  * struct batadv_tvlv_handler - handler for specific tvlv type and version
  */
@@ -2338,6 +3044,9 @@ struct batadv_tvlv_handler {
 	/** @list: hlist node for &batadv_priv_tvlv.handler_list */
 	struct hlist_node list;
 
+	/** @table_node: hlist node for &batadv_priv_tvlv.handler_table */
+	struct hlist_node table_node;
+
 	/**
 	 * @ogm_handler: handler callback which is given the tvlv payload to
 	 *  process on incoming OGM packets